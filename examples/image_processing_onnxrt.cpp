@@ -1,15 +1,26 @@
 #include <libasyik/service.hpp>
 #include <libasyik/http.hpp>
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
 #include <typeinfo>
 #include <memory>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <vector>
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
-#include <rapidjson/stringbuffer.h>
-#include <rapidjson/writer.h>
 #include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/admission.hpp"
+#include "cpp_server/utils/multipart.hpp"
+#include "cpp_server/utils/json_writer.hpp"
 #include "cpp_server/image_processor.hpp"
+#include "cpp_server/dynamic_batcher.hpp"
+#include "cpp_server/engine_pool.hpp"
+#include "cpp_server/parallel_processor.hpp"
+#include "cpp_server/model_registry.hpp"
+#include "cpp_server/model_watcher.hpp"
 #include "cpp_server/onnxrt_helper.hpp"
 #include "cpp_server/onnxrt_engine.hpp"
 
@@ -42,52 +53,339 @@ uint16_t validate_requests(const auto &req_ptr, rapidjson::Document &doc)
   return 200;
 }
 
-int main()
+uint16_t validate_raw_requests(const auto &req_ptr, const char *&data, size_t &size)
+{
+  // The request body is the encoded image, it is decoded in place.
+  std::string content_type(req_ptr->headers["Content-Type"]);
+  std::string media_type = content_type.substr(0, content_type.find(';'));
+  if (media_type != "image/jpeg" && media_type != "image/png" && media_type != "application/octet-stream")
+  {
+    LOG(ERROR) << "Content type error: payload must be defined as image/jpeg, image/png or application/octet-stream"
+               << "\n";
+    return 415;
+  }
+  if (req_ptr->body.empty())
+  {
+    LOG(ERROR) << "Data validation error: Image is empty"
+               << "\n";
+    return 422;
+  }
+  data = req_ptr->body.data();
+  size = req_ptr->body.size();
+  return 200;
+}
+
+uint16_t validate_multipart_requests(const auto &req_ptr, const char *&data, size_t &size)
+{
+  std::string boundary;
+  if (!cps_utils::multipart_boundary(std::string(req_ptr->headers["Content-Type"]), boundary))
+  {
+    LOG(ERROR) << "Content type error: payload must be defined as multipart/form-data with a boundary"
+               << "\n";
+    return 415;
+  }
+
+  // Parts point into the request body, the image field is not copied.
+  std::vector<cps_utils::MultipartPart> parts;
+  cps_utils::Error p_err = cps_utils::parse_multipart(req_ptr->body.data(), req_ptr->body.size(), boundary, parts);
+  if (!p_err.IsOk())
+  {
+    LOG(ERROR) << "Multipart parse error: " << p_err.Message() << "\n";
+    return 400;
+  }
+  for (const cps_utils::MultipartPart &part : parts)
+  {
+    if (part.name == "image" && part.size > 0)
+    {
+      data = part.data;
+      size = part.size;
+      return 200;
+    }
+  }
+  LOG(ERROR) << "Data validation error: Image is not available in form"
+             << "\n";
+  return 422;
+}
+
+uint16_t error_status(const cps_utils::Error &proc_code)
+{
+  switch (proc_code.ErrorCode())
+  {
+  case cps_utils::Error::Code::RESOURCE_EXHAUSTED:
+    return 429;
+  case cps_utils::Error::Code::UNAVAILABLE:
+    return 503;
+  case cps_utils::Error::Code::DEADLINE_EXCEEDED:
+    return 504;
+  default:
+    return 422;
+  }
+}
+
+uint16_t admit_request(const auto &req_ptr, cps_utils::AdmissionController &admission, cps_utils::Deadline &deadline, cps_utils::AdmissionController::Ticket &ticket)
+{
+  // Optional time budget of the request, work still pending when it runs out is dropped.
+  cps_utils::Error p_err = cps_utils::parse_request_timeout(std::string(req_ptr->headers["X-Request-Timeout-Ms"]), deadline);
+  if (!p_err.IsOk())
+  {
+    LOG(ERROR) << "Header validation error: " << p_err.Message() << "\n";
+    return 400;
+  }
+  p_err = admission.admit(deadline, ticket);
+  if (!p_err.IsOk())
+  {
+    uint16_t status = error_status(p_err);
+    if (status == 429 || status == 503)
+    {
+      req_ptr->response.headers.set("Retry-After", std::to_string(admission.retryAfter()));
+    }
+    req_ptr->response.body = p_err.AsString();
+    return status;
+  }
+  return 200;
+}
+
+void write_response(const auto &req_ptr, const cps_utils::Error &proc_code, const rapidjson::Document &payload_result, cps_utils::JsonBuffer &json_buffer)
+{
+  if (!proc_code.IsOk())
+  {
+    req_ptr->response.result(error_status(proc_code));
+    req_ptr->response.body = proc_code.AsString();
+    return;
+  }
+
+  // Serialize straight into the response body, no intermediate string is built and copied.
+  req_ptr->response.body.clear();
+  cps_utils::write_json(payload_result, req_ptr->response.body, json_buffer, 3);
+  req_ptr->response.headers.set("Content-Type", "application/json");
+  req_ptr->response.result(200);
+}
+
+/// @brief How the image of a request is sent.
+enum class InputKind
+{
+  /// @brief Chosen from the Content-Type header.
+  AUTO,
+  /// @brief JSON document with a base64 encoded "image" member.
+  JSON,
+  /// @brief Encoded image as the request body.
+  RAW,
+  /// @brief Multipart form with an image field.
+  FORM
+};
+
+void infer_request(const auto &req_ptr, const cps_processor::ModelRegistry &registry, const std::string &model_name, const std::string &model_version,
+                   cps_utils::AdmissionController &admission, InputKind input_kind)
+{
+  std::shared_ptr<cps_processor::Processor> processor;
+  cps_utils::Error p_err = registry.find(model_name, model_version, processor);
+  if (!p_err.IsOk())
+  {
+    req_ptr->response.body = p_err.AsString();
+    req_ptr->response.result(404);
+    return;
+  }
+
+  cps_utils::Deadline deadline;
+  cps_utils::AdmissionController::Ticket ticket;
+  uint16_t r_errcode = admit_request(req_ptr, admission, deadline, ticket);
+  // Declared first so the documents using its allocator are destroyed before it is released.
+  cps_utils::JsonBuffer::Ptr json_buffer = cps_utils::JsonBuffer::acquire();
+  rapidjson::Document payload_data, payload_result(&json_buffer->allocator());
+  const char *data = nullptr;
+  size_t size = 0;
+
+  if (input_kind == InputKind::AUTO)
+  {
+    std::string content_type(req_ptr->headers["Content-Type"]);
+    std::string media_type = content_type.substr(0, content_type.find(';'));
+    input_kind = media_type == "application/json" ? InputKind::JSON : media_type == "multipart/form-data" ? InputKind::FORM
+                                                                                                          : InputKind::RAW;
+  }
+  if (r_errcode == 200)
+  {
+    switch (input_kind)
+    {
+    case InputKind::JSON:
+      r_errcode = validate_requests(req_ptr, payload_data);
+      break;
+    case InputKind::FORM:
+      r_errcode = validate_multipart_requests(req_ptr, data, size);
+      break;
+    default:
+      r_errcode = validate_raw_requests(req_ptr, data, size);
+      break;
+    }
+  }
+  if (r_errcode != 200)
+  {
+    req_ptr->response.result(r_errcode);
+    return;
+  }
+
+  cps_utils::Error proc_code = input_kind == InputKind::JSON ? processor->process(payload_data, payload_result, deadline)
+                                                             : processor->process(data, size, payload_result, deadline);
+  write_response(req_ptr, proc_code, payload_result, *json_buffer);
+}
+
+void write_models(const auto &req_ptr, const cps_processor::ModelRegistry &registry)
+{
+  cps_utils::JsonBuffer::Ptr json_buffer = cps_utils::JsonBuffer::acquire();
+  rapidjson::Document payload_result(&json_buffer->allocator());
+  rapidjson::Document::AllocatorType &allocator = payload_result.GetAllocator();
+  rapidjson::Value models(rapidjson::kArrayType);
+  for (const cps_processor::ModelSpec &spec : registry.models())
+  {
+    rapidjson::Value model(rapidjson::kObjectType);
+    model.AddMember("name", rapidjson::Value(spec.name.c_str(), allocator), allocator);
+    model.AddMember("version", rapidjson::Value(spec.version.c_str(), allocator), allocator);
+    models.PushBack(model, allocator);
+  }
+  payload_result.SetObject();
+  payload_result.AddMember("models", models, allocator);
+  write_response(req_ptr, cps_utils::Error::Success, payload_result, *json_buffer);
+}
+
+int main(int argc, char **argv)
 {
   auto as = asyik::make_service();
   auto server = asyik::make_http_server(as, "127.0.0.1", 8080);
   server->set_request_body_limit(10485760); // 10MB
 
-  std::shared_ptr<cps_processor::ImageProcessor> image_processor;
+  // Model repository laid out as <name>/<version>/model.onnx, a model may add a preprocess.json
+  // next to its versions, options left out follow the model input.
+  std::string model_repository = argc > 1 ? argv[1] : "/model-repository";
+  // Engines behind the batcher of each worker, up to this many batches of a worker run at once.
+  const size_t engines_per_worker = argc > 2 ? std::max(std::atoi(argv[2]), 1) : 1;
+  std::vector<cps_processor::ModelSpec> specs;
+  cps_utils::Error p_err = cps_processor::ModelRegistry::scan(model_repository, specs);
+  if (!p_err.IsOk() || specs.empty())
   {
-    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
-    const int batch_size = 1;
+    LOG(ERROR) << "No model found in " << model_repository << ": " << p_err.AsString() << "\n";
+    return 1;
+  }
+
+  const size_t num_cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+  // Images of multi-image requests are preprocessed in parallel, the pool is shared by every model.
+  std::shared_ptr<cps_utils::ThreadPool> preprocess_pool(new cps_utils::ThreadPool(num_cores));
 
-    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine_(new cps_inferencer::ONNXRTEngine<float>(model_path, batch_size));
-    image_processor.reset(new cps_processor::ImageProcessor(engine_));
+  // Cores are split between the model versions, each one gets workers pinned to its own share of
+  // the cores, with their own engine, batcher and image processor. The service thread only handles
+  // HTTP while decoding, preprocessing and inference run on the workers.
+  const size_t workers_per_model = std::max<size_t>(num_cores / specs.size(), 1);
+  cps_processor::ModelRegistry::ModelFactory model_factory =
+      [&](const cps_processor::ModelSpec &spec)
+      {
+        // Cores follow the position of the version in the repository, a reloaded version runs on the
+        // cores of the one it replaces.
+        cps_processor::WorkerConfig worker_config;
+        worker_config.num_workers = workers_per_model;
+        worker_config.first_core = spec.position * workers_per_model % num_cores;
+
+        std::unique_ptr<cps_processor::ParallelProcessor> model_processor(new cps_processor::ParallelProcessor(
+            [&spec, &preprocess_pool, num_cores, engines_per_worker](const size_t &worker_id)
+            {
+              const int batch_size = 8;
+              // Engines of the process share one ONNXRuntime thread pool sized to the cores.
+              cps_inferencer::ONNXRTConfig ort_config;
+              ort_config.intra_op_num_threads = num_cores;
+              ort_config.use_global_thread_pool = true;
+              // Replicas started after the first one skip graph optimizations.
+              ort_config.optimized_model_cache_dir = "/tmp/cpp-server-model-cache";
+              ort_config.mmap_model = true;
+
+              std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines;
+              for (size_t i = 0; i < engines_per_worker; ++i)
+              {
+                engines.emplace_back(new cps_inferencer::ONNXRTEngine<float>(spec.version_path + "/model.onnx", batch_size, ort_config));
+              }
+              std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine_(new cps_inferencer::EnginePool<float>(engines));
+              // Collect concurrent requests up to batch_size images or 2ms, whichever comes first.
+              cps_inferencer::BatcherConfig batcher_config;
+              batcher_config.max_batch_size = batch_size;
+              batcher_config.max_queue_delay_us = 2000;
+              std::unique_ptr<cps_inferencer::InferenceEngine<float>> batcher_(new cps_inferencer::DynamicBatcher<float>(engine_, batcher_config));
+              // Return the five best classes of every image.
+              const size_t top_k = 5;
+              return std::unique_ptr<cps_processor::Processor>(new cps_processor::ImageProcessor(batcher_, spec.preprocess_config, preprocess_pool, top_k));
+            },
+            worker_config));
+        if (!model_processor->isOk())
+        {
+          throw std::runtime_error("Unable to start processing workers");
+        }
+        return std::unique_ptr<cps_processor::Processor>(std::move(model_processor));
+      };
+  // New versions run a blank image through each of their workers before serving traffic.
+  cps_processor::ModelRegistry::WarmupFunction model_warmup =
+      [workers_per_model](cps_processor::Processor &processor, const cps_processor::ModelSpec &spec)
+      {
+        std::vector<uchar> image;
+        cv::imencode(".png", cv::Mat(224, 224, CV_8UC3, cv::Scalar(0, 0, 0)), image);
+        for (size_t i = 0; i < workers_per_model; ++i)
+        {
+          rapidjson::Document result_doc;
+          cps_utils::Error p_err = processor.process(reinterpret_cast<const char *>(image.data()), image.size(), result_doc);
+          if (!p_err.IsOk())
+          {
+            return p_err;
+          }
+        }
+        return cps_utils::Error::Success;
+      };
+
+  std::shared_ptr<cps_processor::ModelRegistry> registry(new cps_processor::ModelRegistry());
+  p_err = registry->reload(model_repository, model_factory, model_warmup);
+  if (!p_err.IsOk())
+  {
+    LOG(ERROR) << p_err.AsString() << "\n";
+    return 1;
   }
+  // Model versions added, changed or removed in the repository are swapped in without restarting,
+  // requests in flight finish on the version they started on.
+  std::shared_ptr<cps_processor::ModelWatcher> watcher(new cps_processor::ModelWatcher(*registry, model_repository, model_factory, model_warmup));
 
-  // accept string argument
-  server->on_http_request("/classification/image", "POST", [image_processor](auto req, auto args)
+  // Bound the requests processed at once, requests over the bound wait up to 100ms or their deadline.
+  cps_utils::AdmissionConfig admission_config;
+  admission_config.max_in_flight = 4 * num_cores;
+  admission_config.max_queue = 256;
+  admission_config.max_queue_delay_us = 100000;
+  std::shared_ptr<cps_utils::AdmissionController> admission(new cps_utils::AdmissionController(admission_config));
+
+  // list served models and versions
+  server->on_http_request("/v1/models", "GET", [registry](auto req, auto args)
+                          { write_models(req, *registry); });
+
+  // reload the model repository now instead of at the next check
+  server->on_http_request("/v1/repository/reload", "POST", [watcher](auto req, auto args)
                           {
-                            uint16_t r_errcode = 200;
-                            rapidjson::Document payload_data, payload_result;
-
-                            r_errcode = validate_requests(req, payload_data);
-                            if (r_errcode != 200)
-                            {
-                              req->response.result(r_errcode);
-                            }
-                            else
-                            {
-                              cps_utils::Error proc_code = image_processor->process(payload_data, payload_result);
-                              rapidjson::StringBuffer buffer; buffer.Clear();
-                              rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-                              writer.SetMaxDecimalPlaces(3);
-                              payload_result.Accept(writer);
-
-                              if (!proc_code.IsOk()) {
-                                req->response.result(422);
-                                req->response.body = proc_code.AsString();
-                              }
-                              else {
-                                req->response.body = buffer.GetString();
-                                req->response.headers.set("Content-Type", "application/json");
-                                req->response.result(200);
-                              }
-                            } }); // other standard headers like content-length is set by library
+                            watcher->trigger();
+                            req->response.result(202); });
+
+  // infer on the latest version of a model, the image is sent as JSON, raw body or multipart form
+  server->on_http_request("/v1/models/<string>/infer", "POST", [registry, admission](auto req, auto args)
+                          { infer_request(req, *registry, std::string(args[1]), "", *admission, InputKind::AUTO); });
+
+  // infer on a given version of a model
+  server->on_http_request("/v1/models/<string>/versions/<string>/infer", "POST", [registry, admission](auto req, auto args)
+                          { infer_request(req, *registry, std::string(args[1]), std::string(args[2]), *admission, InputKind::AUTO); });
+
+  // Routes of the single model server, served by the latest version of the default model.
+  const std::string default_model = "imagenet_classification_static";
+
+  // accept string argument
+  server->on_http_request("/classification/image", "POST", [registry, admission, default_model](auto req, auto args)
+                          { infer_request(req, *registry, default_model, "", *admission, InputKind::JSON); }); // other standard headers like content-length is set by library
+
+  // accept raw image body, no base64 or JSON overhead
+  server->on_http_request("/classification/image/raw", "POST", [registry, admission, default_model](auto req, auto args)
+                          { infer_request(req, *registry, default_model, "", *admission, InputKind::RAW); });
+
+  // accept multipart form with an image field
+  server->on_http_request("/classification/image/form", "POST", [registry, admission, default_model](auto req, auto args)
+                          { infer_request(req, *registry, default_model, "", *admission, InputKind::FORM); });
 
   as->run();
 
   return 0;
-}
\ No newline at end of file
+}
@@ -4,6 +4,10 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <boost/fiber/future.hpp>
 #include "cpp_server/utils/common.hpp"
 #include "cpp_server/utils/error.hpp"
 
@@ -18,6 +22,9 @@ namespace cpp_server
         class InferenceEngine
         {
         public:
+            /// @brief Callback to receive the status and results of an asynchronous process.
+            typedef std::function<void(cps_utils::Error, std::vector<cps_utils::InferenceResult<T>> &)> ProcessCallback;
+
             InferenceEngine() = default;
             virtual ~InferenceEngine(){};
             InferenceEngine(const InferenceEngine &engine) = delete;
@@ -31,6 +38,44 @@ namespace cpp_server
             /// @return cpp_server::utils::Error code to validate process.
             virtual cps_utils::Error process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results) = 0;
 
+            /// @brief Process data asynchronously using inference engine.
+            /// Default implementation runs process() and invokes the callback before returning.
+            /// @param infer_data vector of inference data, must stay valid until the callback is invoked.
+            /// @param callback function invoked once with the process status and inference results.
+            /// @return cpp_server::utils::Error code to validate the request is accepted, callback is not invoked on error.
+            virtual cps_utils::Error processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, ProcessCallback callback)
+            {
+                std::vector<cps_utils::InferenceResult<T>> infer_results;
+                cps_utils::Error p_err = process(infer_data, infer_results);
+                callback(p_err, infer_results);
+                return cps_utils::Error::Success;
+            }
+
+            /// @brief Process data asynchronously and wait for the results.
+            /// Waiting is fiber-aware, the calling fiber yields instead of blocking its thread.
+            /// @param infer_data vector of inference data.
+            /// @param infer_results vector of inference results.
+            /// @return cpp_server::utils::Error code to validate process.
+            cps_utils::Error processAwait(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
+            {
+                // Promise is owned by the callback, so it outlives set_value on the engine thread.
+                std::shared_ptr<boost::fibers::promise<cps_utils::Error>> promise(new boost::fibers::promise<cps_utils::Error>());
+                boost::fibers::future<cps_utils::Error> future = promise->get_future();
+
+                cps_utils::Error p_err = processAsync(
+                    infer_data,
+                    [promise, &infer_results](cps_utils::Error err, std::vector<cps_utils::InferenceResult<T>> &results)
+                    {
+                        infer_results.insert(infer_results.end(), std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
+                        promise->set_value(err);
+                    });
+                if (!p_err.IsOk())
+                {
+                    return p_err;
+                }
+                return future.get();
+            }
+
             /// @brief Check if the inference engine is valid.
             /// @return boolean status.
             bool isOk() { return status; }
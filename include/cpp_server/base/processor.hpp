@@ -30,8 +30,22 @@ namespace cpp_server
             /// @brief Abstract function to process incoming data and update output data.
             /// @param data_doc Input data stored as JSON format.
             /// @param result_doc Output data stored as JSON format.
-            /// @return Error code to validate process.
-            virtual cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc) = 0;
+            /// @param deadline point in time after which the work is dropped.
+            /// @return Error code to validate process, DEADLINE_EXCEEDED if the deadline passed.
+            virtual cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                                             const cps_utils::Deadline &deadline = cps_utils::no_deadline()) = 0;
+
+            /// @brief Process raw binary data, such as an encoded image from the request body.
+            /// @param data pointer to input data, only read during the call.
+            /// @param size input data size in bytes.
+            /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped.
+            /// @return Error code to validate process, UNSUPPORTED if the processor only accepts JSON.
+            virtual cps_utils::Error process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                                             const cps_utils::Deadline &deadline = cps_utils::no_deadline())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::UNSUPPORTED, "Binary input is not supported");
+            }
         };
     }
 }
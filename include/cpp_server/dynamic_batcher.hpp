@@ -0,0 +1,130 @@
+#ifndef DYNAMIC_BATCHER_HPP
+#define DYNAMIC_BATCHER_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/mutex.hpp>
+#include "base/inference_engine.hpp"
+#include "utils/common.hpp"
+#include "utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        /// @brief Configuration for dynamic batching.
+        struct BatcherConfig
+        {
+            /// @brief Maximum number of rows per engine call, 0 to use the model max_batch_size_.
+            int max_batch_size{0};
+            /// @brief Maximum time the oldest queued request waits for a batch to fill, in microseconds.
+            int64_t max_queue_delay_us{1000};
+        };
+
+        /// @brief Inference engine that collects concurrent requests into a single batched call.
+        ///
+        /// Requests are queued by process() and executed by a dedicated worker thread, which
+        /// concatenates their inputs along the batch dimension, runs the wrapped engine once and
+        /// splits the results back per request. Requests whose deadline passed while queued are
+        /// failed with DEADLINE_EXCEEDED instead of taking a place in the batch. Waiting uses
+        /// fiber-aware primitives, so callers running on libasyik fibers yield instead of blocking
+        /// the service thread.
+        template <typename T>
+        class DynamicBatcher : public InferenceEngine<T>
+        {
+        public:
+            DynamicBatcher() = default;
+
+            /// @brief Construct batcher on top of an inference engine.
+            /// @param engine inference engine to run batches, ownership is moved to the batcher.
+            /// @param config batching configuration.
+            DynamicBatcher(std::unique_ptr<InferenceEngine<T>> &engine, const BatcherConfig &config);
+            ~DynamicBatcher();
+
+            DynamicBatcher(const DynamicBatcher &batcher) = delete;
+            DynamicBatcher &operator=(const DynamicBatcher &batcher);
+            DynamicBatcher(DynamicBatcher &&batcher) = delete;
+            DynamicBatcher &operator=(DynamicBatcher &&batcher);
+
+            /// @brief Queue data for the next batch and wait for its results.
+            /// @param infer_data vector of inference data, the first dimension of each shape is the batch.
+            /// @param infer_results vector of inference results for this request only.
+            /// @return Error code to validate process.
+            cps_utils::Error process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results);
+
+            /// @brief Queue data for the next batch without waiting.
+            /// @param infer_data vector of inference data, must stay valid until the callback is invoked.
+            /// @param callback function invoked with the results of this request only.
+            /// @return Error code to validate the request is queued.
+            cps_utils::Error processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback);
+
+        private:
+            /// @brief Queued request waiting to be batched.
+            struct Request
+            {
+                const std::vector<cps_utils::InferenceData<T>> *infer_data;
+                typename InferenceEngine<T>::ProcessCallback callback;
+                int64_t rows;
+                std::chrono::steady_clock::time_point enqueue_time;
+                /// @brief Requests past their deadline are dropped instead of batched.
+                cps_utils::Deadline deadline;
+            };
+
+            /// @brief Requests merged into one engine call, kept alive until its callback.
+            struct Batch
+            {
+                std::vector<std::unique_ptr<Request>> requests;
+                std::vector<cps_utils::InferenceData<T>> merged;
+            };
+
+            /// @brief Pointer to inference engine.
+            std::unique_ptr<InferenceEngine<T>> infer_engine;
+            /// @brief Batching configuration.
+            BatcherConfig config{};
+
+            /// @brief Pending requests, guarded by queue_mutex.
+            std::deque<std::unique_ptr<Request>> queue;
+            /// @brief Total rows of pending requests.
+            int64_t queued_rows{0};
+            /// @brief Stop flag for the worker thread.
+            bool stop{false};
+            boost::fibers::mutex queue_mutex;
+            boost::fibers::condition_variable queue_cv;
+            /// @brief Worker thread executing batches.
+            std::thread worker;
+
+            /// @brief Worker loop, collect requests and execute them.
+            void run();
+
+            /// @brief Send a batch of requests to the inference engine.
+            /// @param requests requests to execute.
+            void execute(std::vector<std::unique_ptr<Request>> &requests);
+
+            /// @brief Check if two requests can be concatenated into one batch.
+            bool compatible(const Request &a, const Request &b) const;
+
+            /// @brief Concatenate inputs of all requests along the batch dimension.
+            /// @param batch requests to merge, stores the merged inference data.
+            /// @return Error code to validate process.
+            cps_utils::Error merge(Batch &batch);
+
+            /// @brief Split batched results back per request.
+            /// @param results batched inference results.
+            /// @param batch merged requests.
+            /// @param outputs inference results per request.
+            /// @return Error code to validate process.
+            static cps_utils::Error scatter(std::vector<cps_utils::InferenceResult<T>> &results, const Batch &batch,
+                                            std::vector<std::vector<cps_utils::InferenceResult<T>>> &outputs);
+        };
+    }
+}
+
+#endif
@@ -0,0 +1,123 @@
+#ifndef ENGINE_POOL_HPP
+#define ENGINE_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/mutex.hpp>
+#include "base/inference_engine.hpp"
+#include "utils/common.hpp"
+#include "utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        /// @brief Configuration of an engine pool.
+        struct EnginePoolConfig
+        {
+            /// @brief Maximum time a request waits for a free engine, in microseconds.
+            /// 0 fails right away when every engine is busy, negative waits without limit.
+            int64_t checkout_timeout_us{1000000};
+        };
+
+        /// @brief Inference engine handing K engine instances out to concurrent requests.
+        ///
+        /// Each request checks an engine out, runs on it alone and returns it, so engines that
+        /// aren't safe for concurrent calls are never shared and concurrency is bounded by the
+        /// number of instances. Free engines are kept in a lock-free stack, the mutex is only
+        /// taken when every engine is busy and a request waits for one. Waiting is fiber-aware.
+        template <typename T>
+        class EnginePool : public InferenceEngine<T>
+        {
+        public:
+            /// @brief Return a checked out engine to its pool.
+            struct Returner
+            {
+                EnginePool<T> *pool;
+                size_t index;
+                void operator()(InferenceEngine<T> *engine) const;
+            };
+            /// @brief Engine checked out of the pool, returned when the pointer is destroyed.
+            typedef std::unique_ptr<InferenceEngine<T>, Returner> Lease;
+
+            EnginePool() = default;
+
+            /// @brief Construct pool on top of engine instances of the same model.
+            /// @param engines inference engines, ownership is moved to the pool.
+            /// @param config pool configuration.
+            EnginePool(std::vector<std::unique_ptr<InferenceEngine<T>>> &engines, const EnginePoolConfig &config = EnginePoolConfig());
+
+            EnginePool(const EnginePool &pool) = delete;
+            EnginePool &operator=(const EnginePool &pool);
+            EnginePool(EnginePool &&pool) = delete;
+            EnginePool &operator=(EnginePool &&pool);
+
+            /// @brief Process data on a free engine, waiting for one up to the checkout timeout or the request deadline.
+            /// @param infer_data vector of inference data.
+            /// @param infer_results vector of inference results.
+            /// @return Error code to validate process, UNAVAILABLE if no engine was freed in time.
+            cps_utils::Error process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results);
+
+            /// @brief Process data asynchronously on a free engine, the engine is returned before the callback runs.
+            /// The wait for an engine is bounded by the request deadline as well.
+            /// @param infer_data vector of inference data, must stay valid until the callback is invoked.
+            /// @param callback function invoked with the process status and inference results.
+            /// @return Error code to validate the request is queued, UNAVAILABLE if no engine was freed in time.
+            cps_utils::Error processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback);
+
+            /// @brief Check an engine out for exclusive use, waiting for one up to the checkout timeout.
+            /// @param lease checked out engine, returned to the pool when destroyed.
+            /// @return Error code, UNAVAILABLE if no engine was freed in time.
+            cps_utils::Error checkout(Lease &lease);
+
+            /// @brief Get number of engine instances.
+            size_t size() const { return engines.size(); }
+
+            /// @brief Get number of engines currently free.
+            size_t available() const { return free_count; }
+
+        private:
+            /// @brief Engine instance and its link in the free stack.
+            struct Slot
+            {
+                std::unique_ptr<InferenceEngine<T>> engine;
+                /// @brief Index + 1 of the next free slot, 0 ends the stack.
+                std::atomic<uint32_t> next{0};
+            };
+
+            std::vector<std::unique_ptr<Slot>> engines;
+            EnginePoolConfig config{};
+
+            /// @brief Top of the free stack: a version tag in the upper 32 bits against ABA,
+            /// index + 1 of the top slot in the lower 32 bits, 0 when every engine is busy.
+            std::atomic<uint64_t> free_head{0};
+            std::atomic<size_t> free_count{0};
+            /// @brief Requests waiting for a free engine, engines returned while waiters exist notify them.
+            std::atomic<int> waiters{0};
+            boost::fibers::mutex wait_mutex;
+            boost::fibers::condition_variable wait_cv;
+
+            /// @brief Pop a free engine without waiting.
+            /// @return Index of the engine, -1 if every engine is busy.
+            int64_t tryAcquire();
+
+            /// @brief Pop a free engine, waiting for one up to the checkout timeout or the request deadline.
+            /// @param deadline request deadline, the wait ends at the earlier of both.
+            /// @return Index of the engine, -1 if no engine was freed in time.
+            int64_t acquire(const cps_utils::Deadline &deadline = cps_utils::no_deadline());
+
+            /// @brief Push an engine back on the free stack and wake a waiting request.
+            /// @param index index of the engine.
+            void release(const size_t &index);
+        };
+    }
+}
+
+#endif
@@ -3,20 +3,30 @@
 
 #include <string>
 #include <vector>
+#include <iterator>
 #include <utility>
 #include <exception>
 #include <iostream>
 #include <math.h>
+#include <algorithm>
+#include <cmath>
+#include <chrono>
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 #include <opencv2/imgcodecs.hpp>
 #include <rapidjson/document.h>
-#include <rapidjson/pointer.h>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/mutex.hpp>
 #include "base/processor.hpp"
 #include "base/inference_engine.hpp"
 #include "utils/error.hpp"
 #include "utils/common.hpp"
 #include "utils/base64.hpp"
+#include "utils/jpeg.hpp"
+#include "utils/normalize.hpp"
+#include "utils/preprocess.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/softmax.hpp"
 
 namespace cps_utils = cpp_server::utils;
 namespace cps_inferencer = cpp_server::inferencer;
@@ -31,7 +41,16 @@ namespace cpp_server
         public:
             ImageProcessor() = default;
 
-            ImageProcessor(std::unique_ptr<cps_inferencer::InferenceEngine<float>> &engine);
+            /// @brief Construct image processor on top of an inference engine.
+            /// @param engine inference engine, ownership is moved to the processor.
+            /// @param preprocess_config image preprocessing, options left unset follow the model input.
+            /// @param preprocess_pool worker pool preprocessing the images of a request in parallel,
+            /// can be shared between processors. Images are preprocessed on the calling thread if empty.
+            /// @param top_k number of best classes returned per image.
+            ImageProcessor(std::unique_ptr<cps_inferencer::InferenceEngine<float>> &engine,
+                           const cps_utils::PreprocessConfig &preprocess_config = cps_utils::PreprocessConfig(),
+                           std::shared_ptr<cps_utils::ThreadPool> preprocess_pool = std::shared_ptr<cps_utils::ThreadPool>(),
+                           const size_t &top_k = 1);
 
             ~ImageProcessor()
             {
@@ -45,33 +64,82 @@ namespace cpp_server
             ImageProcessor &operator=(ImageProcessor &&server);
 
             /// @brief Function to process incoming data and update output data.
+            /// The "image" member is a base64 encoded image, or an array of them classified as one batch.
             /// @param data_doc Input data stored as JSON format.
             /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped, also passed to the inference engine.
             /// @return Error code to validate process.
-            cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc);
+            cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                                     const cps_utils::Deadline &deadline = cps_utils::no_deadline());
+
+            /// @brief Function to process an encoded image and update output data.
+            /// The image is decoded straight from the given buffer without copying it.
+            /// @param data pointer to encoded image bytes, e.g. a JPEG or PNG request body.
+            /// @param size image size in bytes.
+            /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped, also passed to the inference engine.
+            /// @return Error code to validate process.
+            cps_utils::Error process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                                     const cps_utils::Deadline &deadline = cps_utils::no_deadline());
 
         private:
+            /// @brief Encoded image of a request, pointing into the request data.
+            struct EncodedImage
+            {
+                const char *data;
+                size_t size;
+                /// @brief Data is base64 encoded, decoded by the preprocessing worker.
+                bool base64;
+            };
+
             /// @brief Pointer to inference engine.
             std::unique_ptr<cps_inferencer::InferenceEngine<float>> infer_engine;
 
             /// @brief Store model configuration from inference engine
             cps_utils::ModelConfig model_config;
 
-            /// @brief Preprocess incoming data by converting string to vector data.
-            /// @param ss Input data as string, encoded as base64.
-            /// @param output Processed output data as vector<float>.
+            /// @brief Image preprocessing resolved against the model input.
+            cps_utils::PreprocessConfig preprocess_config;
+            /// @brief Error of resolving the preprocessing configuration, returned by every process call.
+            cps_utils::Error preprocess_status;
+            /// @brief Worker pool preprocessing images of batched requests.
+            std::shared_ptr<cps_utils::ThreadPool> preprocess_pool;
+            /// @brief Number of best classes returned per image.
+            size_t top_k{1};
+
+            /// @brief Preprocess images into one batch tensor, run inference and write classification results.
+            /// Images beyond the model max batch size are inferred as several batches.
+            /// @param images encoded images, results are written in this order.
+            /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped.
             /// @return Error code to validate process.
-            cps_utils::Error preprocess_data(const std::string &ss, std::vector<float> &output);
+            cps_utils::Error process_images(const std::vector<EncodedImage> &images, rapidjson::Document &result_doc,
+                                            const cps_utils::Deadline &deadline);
+
+            /// @brief Decode and preprocess one image into its slot of the batch tensor.
+            /// @param image encoded image.
+            /// @param output pointer to the slot of the image in the batch tensor.
+            /// @return Error code to validate process.
+            cps_utils::Error preprocess_image(const EncodedImage &image, float *output);
+
+            /// @brief Preprocess incoming data by decoding the image into tensor data.
+            /// @param data pointer to encoded image bytes.
+            /// @param size image size in bytes.
+            /// @param output Processed output data, 3 * width * height floats of the configured input size.
+            /// @return Error code to validate process.
+            cps_utils::Error preprocess_data(const char *data, const size_t &size, float *output);
+
+            /// @brief Fit a decoded image to the network input size with a single resize.
+            /// @param image decoded BGR image.
+            /// @param output image of the network input size, may share memory with image.
+            /// @return Error code to validate process.
+            cps_utils::Error resize_image(const cv::Mat &image, cv::Mat &output);
 
             /// @brief Postprocess raw inference result data into meaningful classification data.
             /// @param infer_results Vector of inference results, especially if processed in batches.
             /// @param output Vector to store output classification data.
             /// @return Error code to validate process.
             cps_utils::Error postprocess_classifaction(const std::vector<cps_utils::InferenceResult<float>> &infer_results, std::vector<cps_utils::ClassificationResult> &output);
-
-            /// @brief Apply softmax to raw logits data and modify inplace.
-            /// @param input vector of logits.
-            void apply_softmax(std::vector<float> &input);
         };
     }
 }
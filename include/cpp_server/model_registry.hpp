@@ -0,0 +1,176 @@
+#ifndef MODEL_REGISTRY_HPP
+#define MODEL_REGISTRY_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "base/processor.hpp"
+#include "utils/error.hpp"
+#include "utils/preprocess.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        /// @brief Model version found in a model repository.
+        struct ModelSpec
+        {
+            std::string name;
+            /// @brief Numeric version, the name of the version directory.
+            std::string version;
+            /// @brief Path of the model directory, <repository>/<name>.
+            std::string model_path;
+            /// @brief Path of the version directory, <repository>/<name>/<version>.
+            std::string version_path;
+            /// @brief Preprocessing read from <repository>/<name>/preprocess.json, default options if absent.
+            cps_utils::PreprocessConfig preprocess_config;
+            /// @brief Last change of the version directory or the preprocessing file in nanoseconds,
+            /// a version is reloaded when it changes.
+            int64_t modified{0};
+            /// @brief Position of the version in the repository scan, sorted by name and version.
+            /// Stable while the repository layout doesn't change, e.g. to split resources between versions.
+            size_t position{0};
+        };
+
+        /// @brief Configuration of a model reload.
+        struct ReloadConfig
+        {
+            /// @brief Maximum time to wait for the requests of a replaced version, in milliseconds.
+            /// Versions still in use afterwards are freed by their last request.
+            int64_t drain_timeout_ms{30000};
+        };
+
+        /// @brief Registry of the models served by the process, requests are routed by model name and version.
+        ///
+        /// Models are read from a repository laid out like a Triton model repository:
+        /// <repository>/<name>/<version>/ with numeric versions, e.g. model.onnx for ONNXRuntime or a
+        /// model served by Triton under the same name. Each model version gets its own processor,
+        /// so its engine, batcher and preprocessing are independent of the other models.
+        ///
+        /// Registered models are an immutable snapshot swapped atomically on every update. Lookups
+        /// never wait for an update, a request keeps the processor it found alive until it is done,
+        /// so replacing a model version never drops requests in flight.
+        class ModelRegistry
+        {
+        public:
+            /// @brief Create the processor of one model version.
+            typedef std::function<std::unique_ptr<Processor>(const ModelSpec &spec)> ModelFactory;
+            /// @brief Run requests through a new processor before it serves traffic.
+            typedef std::function<cps_utils::Error(Processor &processor, const ModelSpec &spec)> WarmupFunction;
+
+            ModelRegistry() = default;
+
+            ModelRegistry(const ModelRegistry &registry) = delete;
+            ModelRegistry &operator=(const ModelRegistry &registry) = delete;
+            ModelRegistry(ModelRegistry &&registry) = delete;
+            ModelRegistry &operator=(ModelRegistry &&registry) = delete;
+
+            /// @brief Find the model versions of a repository.
+            /// @param repository path of the model repository.
+            /// @param specs model versions, sorted by name and version.
+            /// @return Error code, INVALID_DATA if the repository or a preprocessing file can't be read.
+            static cps_utils::Error scan(const std::string &repository, std::vector<ModelSpec> &specs);
+
+            /// @brief Create a processor for every model version of a repository.
+            /// @param repository path of the model repository.
+            /// @param factory function creating the processor of each model version.
+            /// @return Error code, INTERNAL if a processor can't be created.
+            cps_utils::Error load(const std::string &repository, const ModelFactory &factory);
+
+            /// @brief Bring the registry in line with a repository without interrupting traffic.
+            ///
+            /// New and changed versions are created and warmed up while the current ones keep serving,
+            /// then every change is swapped in at once. Versions gone from the repository are removed.
+            /// Replaced and removed versions are freed once their requests in flight are done.
+            /// A version that fails to load keeps its current processor.
+            /// @param repository path of the model repository.
+            /// @param factory function creating the processor of each new or changed model version.
+            /// @param warmup function warming a new processor up, may be empty.
+            /// @param config reload configuration.
+            /// @return Error code, the error of the last version that failed to load.
+            cps_utils::Error reload(const std::string &repository, const ModelFactory &factory,
+                                    const WarmupFunction &warmup = WarmupFunction(), const ReloadConfig &config = ReloadConfig());
+
+            /// @brief Register the processor of a model version.
+            /// @param spec model version, its version must be numeric.
+            /// @param processor processor of the model version, ownership is moved to the registry.
+            /// @return Error code, ALREADY_EXISTS if the version is registered already.
+            cps_utils::Error add(const ModelSpec &spec, std::unique_ptr<Processor> &processor);
+
+            /// @brief Find the processor of a model version.
+            /// @param name model name.
+            /// @param version model version, empty for the latest version.
+            /// @param processor processor of the model version.
+            /// @return Error code, NOT_FOUND if the model or version isn't registered.
+            cps_utils::Error find(const std::string &name, const std::string &version, std::shared_ptr<Processor> &processor) const;
+
+            /// @brief Get registered model versions, sorted by name and version.
+            std::vector<ModelSpec> models() const;
+
+            /// @brief Get number of registered model versions.
+            size_t size() const;
+
+        private:
+            /// @brief Owner of a registered processor, signalled once every handle to it is released.
+            struct Lifetime
+            {
+                std::unique_ptr<Processor> processor;
+                std::mutex mutex;
+                std::condition_variable released_cv;
+                /// @brief No handle is left, guarded by mutex.
+                bool released{false};
+            };
+            /// @brief Deleter of a processor handle, wakes the drain waiting for the processor.
+            /// The processor is freed with its lifetime, by the drain or by the last handle after a drain timeout.
+            struct Releaser
+            {
+                std::shared_ptr<Lifetime> lifetime;
+                void operator()(Processor *processor) const;
+            };
+            /// @brief Registered model version.
+            struct Entry
+            {
+                ModelSpec spec;
+                /// @brief Handle shared by the snapshots and the requests using the processor.
+                std::shared_ptr<Processor> processor;
+                std::shared_ptr<Lifetime> lifetime;
+            };
+            /// @brief Versions of each model by name, ordered so the latest version is last.
+            typedef std::map<std::string, std::map<int64_t, Entry>> Models;
+
+            /// @brief Current snapshot, read and replaced with the atomic shared_ptr functions.
+            std::shared_ptr<const Models> current_models{std::make_shared<const Models>()};
+            /// @brief Serialize updates, lookups don't take it.
+            std::mutex update_mutex;
+
+            /// @brief Get the current snapshot.
+            std::shared_ptr<const Models> snapshot() const;
+
+            /// @brief Create the entry of a model version, the entry takes ownership of the processor.
+            /// @param spec model version.
+            /// @param processor processor of the model version.
+            /// @return Registered model version.
+            static Entry createEntry(const ModelSpec &spec, std::unique_ptr<Processor> &processor);
+
+            /// @brief Wait until the requests using replaced processors are done, then free them.
+            /// @param retired replaced model versions.
+            /// @param config reload configuration.
+            static void drain(std::vector<Entry> &retired, const ReloadConfig &config);
+        };
+
+        /// @brief Parse a model version.
+        /// @param version decimal version number.
+        /// @param number parsed version.
+        /// @return true if the version is a non-negative decimal number.
+        bool parse_model_version(const std::string &version, int64_t &number);
+    }
+}
+
+#endif
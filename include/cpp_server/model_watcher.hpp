@@ -0,0 +1,83 @@
+#ifndef MODEL_WATCHER_HPP
+#define MODEL_WATCHER_HPP
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "model_registry.hpp"
+#include "utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        /// @brief Configuration of a model repository watcher.
+        struct WatcherConfig
+        {
+            /// @brief Interval between repository checks in milliseconds, 0 only reloads when triggered.
+            int64_t poll_interval_ms{5000};
+            ReloadConfig reload_config{};
+        };
+
+        /// @brief Reload a model registry from its repository on a background thread.
+        ///
+        /// Reloads run when the repository is checked every poll interval, or right away when
+        /// triggered, e.g. by an admin endpoint. A check only stats the repository, models are
+        /// rebuilt when a version is added, removed or changed. Loading, warming up and draining
+        /// happen on the watcher thread, requests keep being served by the current versions.
+        class ModelWatcher
+        {
+        public:
+            /// @brief Start the watcher thread.
+            /// @param registry registry to reload, must outlive the watcher.
+            /// @param repository path of the model repository.
+            /// @param factory function creating the processor of each new or changed model version.
+            /// @param warmup function warming a new processor up, may be empty.
+            /// @param config watcher configuration.
+            ModelWatcher(ModelRegistry &registry, const std::string &repository, const ModelRegistry::ModelFactory &factory,
+                         const ModelRegistry::WarmupFunction &warmup = ModelRegistry::WarmupFunction(), const WatcherConfig &config = WatcherConfig());
+
+            /// @brief Finish the running reload and join the watcher thread.
+            ~ModelWatcher();
+
+            ModelWatcher(const ModelWatcher &watcher) = delete;
+            ModelWatcher &operator=(const ModelWatcher &watcher) = delete;
+            ModelWatcher(ModelWatcher &&watcher) = delete;
+            ModelWatcher &operator=(ModelWatcher &&watcher) = delete;
+
+            /// @brief Request a reload without waiting for it, reloads requested meanwhile are merged.
+            void trigger();
+
+            /// @brief Get number of finished reloads.
+            size_t reloads() const;
+
+            /// @brief Get status of the last finished reload.
+            cps_utils::Error status() const;
+
+        private:
+            /// @brief Watcher loop, reload when triggered or every poll interval.
+            void run();
+
+            ModelRegistry &registry;
+            std::string repository;
+            ModelRegistry::ModelFactory factory;
+            ModelRegistry::WarmupFunction warmup;
+            WatcherConfig config{};
+
+            mutable std::mutex watcher_mutex;
+            std::condition_variable watcher_cv;
+            /// @brief Guarded by watcher_mutex.
+            bool triggered{false};
+            bool stop{false};
+            size_t reload_count{0};
+            cps_utils::Error reload_status;
+            std::thread thread;
+        };
+    }
+}
+
+#endif
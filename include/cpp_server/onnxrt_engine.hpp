@@ -1,7 +1,11 @@
 #ifndef ONNXRT_ENGINE_HPP
 #define ONNXRT_ENGINE_HPP
 
+#include <algorithm>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <iostream>
 #include <numeric>
 #include <vector>
 
@@ -10,6 +14,7 @@
 #include "utils/error.hpp"
 #include "base/inference_engine.hpp"
 #include "cpp_server/onnxrt_helper.hpp"
+#include "cpp_server/utils/thread_pool.hpp"
 
 
 namespace cps_utils = cpp_server::utils;
@@ -29,7 +34,15 @@ namespace cpp_server
             /// @brief Construct inference engine based on model path and batch size
             /// @param model_path path to onnx model.
             /// @param batch_size desired batch size.
-            ONNXRTEngine(const std::string &model_path, const int &batch_size);
+            /// @param num_workers number of threads running asynchronous requests.
+            ONNXRTEngine(const std::string &model_path, const int &batch_size, const int &num_workers = 1);
+
+            /// @brief Construct inference engine based on model path, batch size and session configuration
+            /// @param model_path path to onnx model.
+            /// @param batch_size desired batch size.
+            /// @param config ONNXRuntime session configuration.
+            /// @param num_workers number of threads running asynchronous requests.
+            ONNXRTEngine(const std::string &model_path, const int &batch_size, const ONNXRTConfig &config, const int &num_workers = 1);
 
             ONNXRTEngine(const ONNXRTEngine &engine) = delete;
             ONNXRTEngine &operator=(const ONNXRTEngine &engine);
@@ -38,23 +51,70 @@ namespace cpp_server
 
             /// @brief Process data using inference engine.
             /// @param infer_data vector of inference data.
-            /// @param infer_results vector of inference results.
+            /// @param infer_results vector of inference results, replaced by one result per model output.
+            /// Reusing the vector across calls avoids allocating the results.
             /// @return Error code to validate process.
             cps_utils::Error process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results);
 
+            /// @brief Process data asynchronously on the engine worker threads.
+            /// @param infer_data vector of inference data, must stay valid until the callback is invoked.
+            /// @param callback function invoked from a worker thread with the process status and inference results.
+            /// @return Error code to validate the request is queued.
+            cps_utils::Error processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback);
+
         private:
+            /// @brief Buffers and IO binding preallocated for one run at a batch-size bucket.
+            struct BindingSlot
+            {
+                /// @brief Batch size of the bound tensors.
+                int64_t rows;
+                /// @brief Input and output buffers, inputs are copied in and outputs are handed out as slices.
+                std::vector<cps_utils::TensorBuffer<T>> inputs, outputs;
+                /// @brief ORT values wrapping the buffers.
+                std::vector<Ort::Value> input_values, output_values;
+                std::unique_ptr<Ort::IoBinding> binding;
+                /// @brief Slot is running, guarded by slots_mutex.
+                bool busy{false};
+            };
+
             /// @brief ONNXRuntime handler.
             std::unique_ptr<ORTRunner> ort_runner;
-            /// @brief Model configuration
-            std::vector<cps_utils::ModelConfig> model_configs;
-            /// @brief vector to store inputs and outputs as ORT Values
-            std::vector<Ort::Value> input_tensors_, output_tensors_;
+            /// @brief Batch sizes tensors are allocated for, ascending.
+            std::vector<int64_t> batch_buckets;
+            /// @brief Binding slots per batch-size bucket, grown up to the number of concurrent runs.
+            std::map<int64_t, std::vector<std::unique_ptr<BindingSlot>>> binding_slots;
+            std::mutex slots_mutex;
+            /// @brief Worker threads for asynchronous requests, declared last to be joined first.
+            std::unique_ptr<cps_utils::ThreadPool> thread_pool;
 
             /// @brief Validate inference data with confugration and buffer allocations.
             /// @param data vector of input data.
             /// @return Error code to validate process.
             cps_utils::Error validate(const std::vector<cps_utils::InferenceData<T>> &infer_data);
 
+            /// @brief Get the model input index of an input data.
+            /// @param infer_data vector of input data.
+            /// @param i position of the input data.
+            /// @return Model input index, -1 if no input has the data name.
+            int inputIndex(const std::vector<cps_utils::InferenceData<T>> &infer_data, const size_t &i) const;
+
+            /// @brief Get an idle binding slot of the smallest bucket fitting the rows, allocating one if none is free.
+            /// A slot is idle when it's not running and its output buffers are no longer referenced by results.
+            /// @param rows batch size of the request.
+            /// @param slot acquired binding slot.
+            /// @return Error code to validate process.
+            cps_utils::Error acquireSlot(const int64_t &rows, BindingSlot *&slot);
+
+            /// @brief Return a binding slot acquired with acquireSlot.
+            /// @param slot binding slot.
+            void releaseSlot(BindingSlot *slot);
+
+            /// @brief Allocate buffers and bind them for a batch size.
+            /// @param rows batch size of the bucket.
+            /// @param slot allocated binding slot.
+            /// @return Error code to validate process.
+            cps_utils::Error createSlot(const int64_t &rows, std::unique_ptr<BindingSlot> &slot);
+
         };
     }
 }
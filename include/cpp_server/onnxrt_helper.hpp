@@ -1,12 +1,16 @@
 #ifndef ONNXRT_HELPER_HPP
 #define ONNXRT_HELPER_HPP
 
+#include <iostream>
 #include <memory>
+#include <mutex>
+#include <string>
 #include <onnxruntime/core/session/onnxruntime_cxx_api.h>
 #include <rapidjson/document.h>
 #include <rapidjson/istreamwrapper.h>
 #include "cpp_server/utils/common.hpp"
 #include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/mapped_file.hpp"
 #include <fstream>
 
 namespace cps_utils = cpp_server::utils;
@@ -80,19 +84,47 @@ namespace cpp_server
             return "UNDEFINED";
         }
 
+        /// @brief ONNXRuntime session configuration, defaults match ONNXRuntime defaults.
+        struct ONNXRTConfig
+        {
+            /// @brief Number of threads parallelizing a single operator, 0 to let ONNXRuntime decide.
+            int intra_op_num_threads{0};
+            /// @brief Number of threads running independent operators in parallel mode, 0 to let ONNXRuntime decide.
+            int inter_op_num_threads{0};
+            /// @brief Graph optimizations applied when the session is created.
+            GraphOptimizationLevel graph_optimization_level{GraphOptimizationLevel::ORT_ENABLE_ALL};
+            /// @brief Run operators sequentially or in parallel.
+            ExecutionMode execution_mode{ExecutionMode::ORT_SEQUENTIAL};
+            /// @brief Preallocate memory based on the memory pattern of previous runs.
+            bool enable_mem_pattern{true};
+            /// @brief Use the arena allocator for CPU memory.
+            bool enable_cpu_mem_arena{true};
+            /// @brief Run all sessions of the process on one global thread pool instead of per-session pools,
+            /// so several engines don't oversubscribe the cores. Thread counts of the first session
+            /// creating the environment size the global pool.
+            bool use_global_thread_pool{false};
+            /// @brief Directory storing optimized models in ORT format, empty to disable caching.
+            /// Entries are keyed by model content, ONNXRuntime version and this configuration.
+            std::string optimized_model_cache_dir{""};
+            /// @brief Memory-map the model file and create the session from the mapped bytes. Combined with
+            /// the optimized model cache, weights of ORT format models are shared between processes.
+            bool mmap_model{false};
+        };
+
         class ORTRunner
         {
         public:
             ORTRunner() = default;
             /// @brief Construct ONNXRuntime Runner based on model path
             /// @param model_path path to onnx model.
-            ORTRunner(const std::string &model_path);
+            /// @param config session configuration.
+            ORTRunner(const std::string &model_path, const ONNXRTConfig &config = ONNXRTConfig());
             ~ORTRunner(){};
 
             /// @brief read model configurations from onnx file.
             cps_utils::Error readModelConfigs();
-            /// @brief Get vector of model configurations.
-            std::vector<cps_utils::ModelConfig> getModelConfigs() { return model_configs_;};
+            /// @brief Get model configuration with all inputs and outputs.
+            cps_utils::ModelConfig getModelConfig() { return model_config_;};
             /// @brief Check if the session is valid.
             bool isValid() {bool val = session_ == nullptr ? false : true; return val;};
 
@@ -102,18 +134,53 @@ namespace cpp_server
             /// @return Error code to validate process.
             cps_utils::Error process(const std::vector<Ort::Value> &input_tensors, std::vector<Ort::Value> &output_tensors);
 
+            /// @brief Create IO binding for the session.
+            /// @param binding created IO binding.
+            /// @return Error code to validate process.
+            cps_utils::Error createIoBinding(std::unique_ptr<Ort::IoBinding> &binding);
+
+            /// @brief Process data bound to the session, outputs are written to the bound buffers.
+            /// @param binding IO binding with all inputs and outputs bound.
+            /// @return Error code to validate process.
+            cps_utils::Error process(Ort::IoBinding &binding);
+
         private:
-            /// @brief onnxruntime session handler.
+            /// @brief onnxruntime environment, shared by all runners of the process.
+            std::shared_ptr<Ort::Env> env_;
+            /// @brief Mapped model file, the session may reference its bytes.
+            std::unique_ptr<cps_utils::MappedFile> model_file_;
+            /// @brief onnxruntime session handler, declared after env_ and model_file_ to be released first.
             std::unique_ptr<Ort::Session> session_;
-            /// @brief onnxruntime environment.
-            Ort::Env env_;
             /// @brief onnxruntime run options.
             Ort::RunOptions run_options_;
 
             /// @brief vector to store input and output names.
             std::vector<const char*> input_node_names_, output_node_names_;
-            /// @brief vector to store model configurations.
-            std::vector<cps_utils::ModelConfig> model_configs_;
+            /// @brief model configuration.
+            cps_utils::ModelConfig model_config_;
+
+            /// @brief Get the process-wide onnxruntime environment, creating it on first use.
+            /// @param config session configuration, requests global thread pools.
+            /// @return Error code to validate the environment matches the configuration.
+            cps_utils::Error acquireEnv(const ONNXRTConfig &config);
+
+            /// @brief Create session options from configuration.
+            /// @param config session configuration.
+            /// @return onnxruntime session options.
+            static Ort::SessionOptions createSessionOptions(const ONNXRTConfig &config);
+
+            /// @brief Create session from a model file, mapping it into memory when configured.
+            /// @param model_path path to onnx or ort model.
+            /// @param config session configuration.
+            /// @param options onnxruntime session options.
+            /// @return Error code to validate process.
+            cps_utils::Error createSession(const std::string &model_path, const ONNXRTConfig &config, Ort::SessionOptions &options);
+
+            /// @brief Create session from the optimized model cache, optimizing and storing the model on a miss.
+            /// @param model_path path to onnx model.
+            /// @param config session configuration.
+            /// @return Error code to validate process.
+            cps_utils::Error createCachedSession(const std::string &model_path, const ONNXRTConfig &config);
 
         };
     }
@@ -0,0 +1,127 @@
+#ifndef PARALLEL_PROCESSOR_HPP
+#define PARALLEL_PROCESSOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/mutex.hpp>
+#include <rapidjson/document.h>
+#include "base/processor.hpp"
+#include "utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        /// @brief Configuration of the processing workers.
+        struct WorkerConfig
+        {
+            /// @brief Number of worker threads, 0 for one per core.
+            size_t num_workers{0};
+            /// @brief Pin worker i to core first_core + i, modulo the number of cores.
+            bool pin_workers{true};
+            /// @brief Core of the first worker, processors sharing the process can be given disjoint cores.
+            size_t first_core{0};
+        };
+
+        /// @brief Processor spreading requests over worker threads, each owning its own processor and engine.
+        ///
+        /// The HTTP service keeps a single thread for network I/O while decoding, preprocessing and
+        /// inference of a request run on a worker, so CPU work scales with the number of cores
+        /// instead of being serialized on the service thread. Each request runs on its own fiber
+        /// of the least loaded worker, so a worker waiting for inference results keeps processing
+        /// other requests. Callers wait with fiber-aware primitives and yield the service thread.
+        class ParallelProcessor : public Processor
+        {
+        public:
+            /// @brief Create the processor of one worker, called on the worker thread.
+            typedef std::function<std::unique_ptr<Processor>(const size_t &worker_id)> ProcessorFactory;
+
+            /// @brief Start worker threads and create their processors.
+            /// @param factory function creating the processor of each worker.
+            /// @param config worker configuration.
+            ParallelProcessor(const ProcessorFactory &factory, const WorkerConfig &config = WorkerConfig());
+
+            /// @brief Finish requests in flight and join worker threads.
+            ~ParallelProcessor();
+
+            ParallelProcessor(const ParallelProcessor &processor) = delete;
+            ParallelProcessor &operator=(const ParallelProcessor &processor);
+            ParallelProcessor(ParallelProcessor &&processor) = delete;
+            ParallelProcessor &operator=(ParallelProcessor &&processor);
+
+            /// @brief Process incoming data on a worker and wait for its output data.
+            /// @param data_doc Input data stored as JSON format.
+            /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped, also when still queued on a worker.
+            /// @return Error code to validate process.
+            cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                                     const cps_utils::Deadline &deadline = cps_utils::no_deadline());
+
+            /// @brief Process raw binary data on a worker and wait for its output data.
+            /// @param data pointer to input data, only read during the call.
+            /// @param size input data size in bytes.
+            /// @param result_doc Output data stored as JSON format.
+            /// @param deadline point in time after which the work is dropped, also when still queued on a worker.
+            /// @return Error code to validate process.
+            cps_utils::Error process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                                     const cps_utils::Deadline &deadline = cps_utils::no_deadline());
+
+            /// @brief Check if every worker created its processor.
+            bool isOk() const { return status; }
+
+            /// @brief Get number of worker threads.
+            size_t size() const { return workers.size(); }
+
+        private:
+            /// @brief Worker thread with its own processor and request queue.
+            struct Worker
+            {
+                std::unique_ptr<Processor> processor;
+                /// @brief Queued requests, guarded by tasks_mutex.
+                std::deque<std::function<void()>> tasks;
+                /// @brief Requests queued or running on this worker.
+                std::atomic<size_t> load{0};
+                boost::fibers::mutex tasks_mutex;
+                boost::fibers::condition_variable tasks_cv;
+                std::thread thread;
+            };
+
+            /// @brief Workers, created in the constructor and never resized.
+            std::vector<std::unique_ptr<Worker>> workers;
+            /// @brief Every worker created its processor.
+            bool status{false};
+            /// @brief Stop flag for the worker threads, set under the mutex of each worker.
+            std::atomic<bool> stop{false};
+            /// @brief Number of workers done creating their processor, guarded by start_mutex.
+            size_t started{0};
+            boost::fibers::mutex start_mutex;
+            boost::fibers::condition_variable start_cv;
+            /// @brief Start of the next worker search, spreads ties between workers.
+            std::atomic<size_t> next_worker{0};
+
+            /// @brief Worker loop, create the processor, then run each queued request on its own fiber.
+            /// @param worker worker owned by this thread.
+            /// @param worker_id index of the worker.
+            /// @param factory function creating the processor of the worker.
+            /// @param core core to pin the thread to, negative to leave it unpinned.
+            void run(Worker &worker, const size_t &worker_id, const ProcessorFactory &factory, const int &core);
+
+            /// @brief Run a function with the processor of the least loaded worker and wait for its result.
+            /// @param function function to run on the worker thread.
+            /// @param deadline point in time after which the function is no longer run.
+            /// @return Error code returned by the function.
+            cps_utils::Error dispatch(const std::function<cps_utils::Error(Processor &)> &function, const cps_utils::Deadline &deadline);
+        };
+    }
+}
+
+#endif
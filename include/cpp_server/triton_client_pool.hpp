@@ -0,0 +1,162 @@
+#ifndef TRITON_CLIENT_POOL_HPP
+#define TRITON_CLIENT_POOL_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "triton_helper.hpp"
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        /// @brief Client connection to one Triton endpoint.
+        struct TritonConnection
+        {
+            /// @brief Release the client of the active protocol, TritonClient doesn't track it.
+            ~TritonConnection()
+            {
+                if (protocol == ProtocolType::GRPC)
+                {
+                    client.grpc_client_.reset();
+                }
+                else
+                {
+                    client.http_client_.reset();
+                }
+            }
+
+            TritonClient client;
+            ProtocolType protocol{ProtocolType::HTTP};
+            /// @brief Index of the endpoint in the pool.
+            size_t endpoint{0};
+            /// @brief Number of requests in flight on this connection.
+            std::atomic<int> outstanding{0};
+
+            /// @brief gRPC stream state, guarded by stream_mutex.
+            std::mutex stream_mutex;
+            bool stream_active{false};
+            /// @brief Callbacks of requests sent over the stream, by request id.
+            std::unordered_map<std::string, tc::OnCompleteFn> stream_callbacks;
+        };
+
+        /// @brief Pool of client connections across Triton endpoints.
+        ///
+        /// Requests are spread over healthy endpoints with the configured balancing policy, and over
+        /// the connections of the chosen endpoint by fewest requests in flight. An endpoint is ejected
+        /// after consecutive failures or a failed readiness probe, and re-added once a probe succeeds.
+        class TritonClientPool
+        {
+        public:
+            /// @brief Open connections to every configured endpoint.
+            /// @param client_config triton client configurations.
+            TritonClientPool(const ClientConfig &client_config);
+            ~TritonClientPool();
+
+            TritonClientPool(const TritonClientPool &pool) = delete;
+            TritonClientPool &operator=(const TritonClientPool &pool) = delete;
+            TritonClientPool(TritonClientPool &&pool) = delete;
+            TritonClientPool &operator=(TritonClientPool &&pool) = delete;
+
+            /// @brief Check if every connection is created.
+            bool isValid() const { return valid_; }
+
+            /// @brief Pick a connection for a request, its outstanding count is incremented.
+            /// @return Connection to use, nullptr when every endpoint is ejected.
+            TritonConnection *acquire();
+
+            /// @brief Return a connection after its request completed.
+            /// @param connection connection returned by acquire.
+            /// @param success whether the request reached the endpoint and succeeded.
+            void release(TritonConnection *connection, const bool &success);
+
+            /// @brief Get one connection per endpoint, used for per-server state such as
+            /// model configuration and shared memory registration.
+            /// @return Connections in endpoint order.
+            std::vector<TritonConnection *> endpointConnections() const;
+
+            /// @brief Check if requests are sent over gRPC streams.
+            bool isStreaming() const { return streaming_; }
+
+            /// @brief Send a request over the stream of a connection.
+            /// The request id is replaced by one unique in the pool to match the response, the callback is
+            /// invoked with nullptr if the stream closes before the response arrives.
+            /// @param connection connection returned by acquire.
+            /// @param callback function invoked with the response, taking ownership of it.
+            /// @param options inference options.
+            /// @param inputs request inputs.
+            /// @param outputs requested outputs.
+            /// @return Error if the stream is closed or the request can't be sent.
+            tc::Error asyncStreamInfer(TritonConnection *connection, tc::OnCompleteFn callback, tc::InferOptions &options,
+                                       const std::vector<tc::InferInput *> &inputs, const std::vector<const tc::InferRequestedOutput *> &outputs);
+
+            /// @brief Number of endpoints.
+            size_t size() const { return endpoints_.size(); }
+
+            /// @brief Check if an endpoint receives requests.
+            /// @param endpoint index of the endpoint.
+            bool isHealthy(const size_t &endpoint) const { return endpoints_[endpoint]->healthy; }
+
+            /// @brief Get number of requests in flight on an endpoint.
+            /// @param endpoint index of the endpoint.
+            int outstanding(const size_t &endpoint) const { return endpoints_[endpoint]->outstanding; }
+
+        private:
+            /// @brief Triton instance and its connections.
+            struct Endpoint
+            {
+                std::string url;
+                std::vector<std::unique_ptr<TritonConnection>> connections;
+                std::atomic<int> outstanding{0};
+                std::atomic<int> failures{0};
+                std::atomic<bool> healthy{true};
+            };
+
+            ClientConfig client_config_;
+            std::vector<std::unique_ptr<Endpoint>> endpoints_;
+            bool valid_{false};
+            bool streaming_{false};
+            std::atomic<uint64_t> next_stream_id_{0};
+            /// @brief Start of the least outstanding scan, rotated so ties don't always pick the first endpoint.
+            std::atomic<size_t> next_endpoint_{0};
+
+            /// @brief Readiness probing thread.
+            std::thread health_thread_;
+            std::mutex health_mutex_;
+            std::condition_variable health_cv_;
+            bool stop_{false};
+
+            /// @brief Pick a healthy endpoint with the balancing policy.
+            /// @return Endpoint to use, nullptr when every endpoint is ejected.
+            Endpoint *selectEndpoint();
+
+            /// @brief Probe endpoint readiness until stopped.
+            void checkHealth();
+
+            /// @brief Ask an endpoint whether the server is ready.
+            bool isReady(Endpoint &endpoint);
+
+            /// @brief Open the stream of a connection, stopping a closed one first.
+            /// Must not be called from a stream callback, stopping joins the stream thread.
+            /// @param connection gRPC connection.
+            /// @return Error if the stream can't be started.
+            tc::Error startStream(TritonConnection &connection);
+
+            /// @brief Dispatch a stream response to the callback of its request.
+            /// @param connection connection of the stream.
+            /// @param result response, ownership is taken.
+            void onStreamResult(TritonConnection &connection, tc::InferResult *result);
+        };
+    }
+}
+
+#endif
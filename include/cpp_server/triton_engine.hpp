@@ -1,18 +1,26 @@
 #ifndef TRITON_ENGINE_HPP
 #define TRITON_ENGINE_HPP
 
+#include <algorithm>
 #include <string>
 #include <memory>
 #include <cstdint>
+#include <cstring>
 #include <exception>
 #include <stdexcept>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <unistd.h>
 #include <http_client.h>
 #include "json_utils.h"
 #include <rapidjson/document.h>
 #include "base/inference_engine.hpp"
+#include "utils/batch_pipeline.hpp"
 #include "utils/common.hpp"
 #include "utils/error.hpp"
+#include "utils/shared_memory.hpp"
+#include "triton_client_pool.hpp"
 #include "triton_helper.hpp"
 
 namespace cps_utils = cpp_server::utils;
@@ -32,20 +40,7 @@ namespace cpp_server
             /// @param client_config triton client configurations.
             /// @param batch_size desired batch size.
             TritonEngine(const cpp_server::inferencer::ClientConfig &client_config, const int &batch_size);
-            ~TritonEngine()
-            {
-                for (auto p : infer_inputs)
-                {
-                    delete p;
-                }
-                infer_inputs.clear();
-
-                for (auto p : infer_outputs)
-                {
-                    delete p;
-                }
-                infer_outputs.clear();
-            };
+            ~TritonEngine();
             TritonEngine(const TritonEngine &engine) = delete;
             TritonEngine &operator=(const TritonEngine &engine);
             TritonEngine(TritonEngine &&engine) = delete;
@@ -57,7 +52,57 @@ namespace cpp_server
             /// @return Error code to validate process.
             cps_utils::Error process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results);
 
+            /// @brief Process data asynchronously using Triton AsyncInfer.
+            /// Callback is invoked from the Triton client worker thread, the engine must outlive the request.
+            /// @param infer_data vector of inference data, must stay valid until the callback is invoked.
+            /// @param callback function invoked with the process status and inference results.
+            /// @return Error code to validate the request is sent.
+            cps_utils::Error processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback);
+
         private:
+            /// @brief Shared memory region registered with Triton, holding the inputs and outputs of one batch.
+            struct SharedMemorySlot
+            {
+                std::unique_ptr<cps_utils::SharedMemoryRegion> region;
+                /// @brief Region name registered with Triton.
+                std::string name;
+                /// @brief Slot is used by a request in flight, guarded by shm_mutex.
+                bool busy{false};
+                /// @brief Endpoints the region is registered on, only used by the request holding the slot.
+                std::set<size_t> endpoints;
+            };
+
+            /// @brief One batch of an asynchronous request, sent with its index as request id.
+            struct AsyncChunk
+            {
+                /// @brief First row and number of rows of the batch.
+                int64_t offset{0};
+                int64_t rows{1};
+                std::vector<std::unique_ptr<tc::InferInput>> inputs;
+                std::vector<std::unique_ptr<tc::InferRequestedOutput>> outputs;
+                /// @brief Connection and shared memory slot while the batch is in flight.
+                TritonConnection *connection{nullptr};
+                std::shared_ptr<SharedMemorySlot> shm_slot;
+                /// @brief Results of the batch, one per model output.
+                std::vector<cps_utils::InferenceResult<T>> results;
+            };
+
+            /// @brief State of an asynchronous request, shared with Triton callbacks.
+            struct AsyncRequest
+            {
+                /// @brief Inference data in model input order.
+                std::vector<cps_utils::InferenceData<T>> input_data;
+                int64_t total_rows{1};
+                /// @brief Number of elements per row of each input.
+                std::vector<size_t> row_sizes;
+                /// @brief Batches in request id order.
+                std::vector<AsyncChunk> chunks;
+                typename InferenceEngine<T>::ProcessCallback callback;
+
+                /// @brief Batches sent and in flight, first error of any batch.
+                std::unique_ptr<cps_utils::BatchPipeline> pipeline;
+            };
+
             /// @brief Model metadata in json format
             rapidjson::Document model_metadata_json;
             /// @brief Model configuration in json format
@@ -65,42 +110,89 @@ namespace cpp_server
 
             /// @brief Client configuration.
             cpp_server::inferencer::ClientConfig client_config{};
-            /// @brief Model configuration
-            cps_utils::ModelConfig model_config{};
-            /// @brief Triton client handler.
-            TritonClient triton_client;
-
-            /// @brief Pointer to store Triton's InferInput
-            std::shared_ptr<tc::InferInput> input_ptr;
-            /// @brief Pointer to store Triton's output
-            std::shared_ptr<tc::InferRequestedOutput> output_ptr;
-            /// @brief Vector to store raw pointer Triton's input
-            std::vector<tc::InferInput *> infer_inputs;
-            /// @brief Vector to store raw pointer Triton's output
-            std::vector<const tc::InferRequestedOutput *> infer_outputs;
-            /// @brief Triton inference options
-            tc::InferOptions infer_options{""};
+            /// @brief Triton client connections across endpoints.
+            std::unique_ptr<TritonClientPool> client_pool;
+
+            /// @brief Offsets of each input and output in a shared memory slot, npos for tensors with
+            /// variable-size dimensions which are sent over the socket.
+            std::vector<size_t> shm_input_offsets, shm_output_offsets;
+            /// @brief Byte size of each input and output for one batch.
+            std::vector<size_t> shm_input_sizes, shm_output_sizes;
+            /// @brief Byte size of a shared memory slot.
+            size_t shm_slot_size{0};
+            /// @brief Registered shared memory slots, reused once results referencing them are released.
+            std::vector<std::shared_ptr<SharedMemorySlot>> shm_slots;
+            std::mutex shm_mutex;
 
             /// @brief Read triton model configuration from server
             /// @return Error code to validate process.
             cps_utils::Error readModelConfig();
 
-            /// @brief Initialize and allocate buffer memory
+            /// @brief Compute the shared memory layout of a batch.
+            void initializeSharedMemory();
+
+            /// @brief Get an idle shared memory slot, creating one if none is free, and register it on
+            /// the endpoint of the connection if it isn't yet.
+            /// @param slot acquired slot.
+            /// @param connection connection the batch is sent on.
+            /// @return Error code to validate process.
+            cps_utils::Error acquireSharedMemory(std::shared_ptr<SharedMemorySlot> &slot, TritonConnection *connection);
+
+            /// @brief Register or unregister the region of a shared memory slot on the endpoint of a connection.
+            /// @param slot shared memory slot.
+            /// @param connection connection to the endpoint.
+            /// @param registered register the region if true, unregister it otherwise.
+            /// @return Triton client error.
+            tc::Error registerSharedMemory(const SharedMemorySlot &slot, TritonConnection *connection, const bool &registered);
+
+            /// @brief Mark a shared memory slot idle and drop the reference.
+            /// @param slot slot to release, may be null.
+            void releaseSharedMemory(std::shared_ptr<SharedMemorySlot> &slot);
+
+            /// @brief Return the connection and shared memory slot of a batch.
+            /// @param chunk batch holding a connection.
+            /// @param success whether the request reached the endpoint and succeeded.
+            void releaseConnection(AsyncChunk &chunk, const bool &success);
+
+            /// @brief Initialize Triton's input and output of a batch
+            /// @param chunk batch to initialize.
+            /// @return Error code to validate process.
+            cps_utils::Error initializeMemory(AsyncChunk &chunk);
+
+            /// @brief Send a batch of an asynchronous request.
+            /// @param request asynchronous request to send.
+            /// @param index index of the batch.
             /// @return Error code to validate process.
-            cps_utils::Error initializeMemory();
+            cps_utils::Error sendChunk(const std::shared_ptr<AsyncRequest> &request, const size_t &index);
+
+            /// @brief Send remaining batches of an asynchronous request while below the max outstanding limit.
+            /// @param request asynchronous request to send.
+            void sendPending(const std::shared_ptr<AsyncRequest> &request);
+
+            /// @brief Handle a batch response, send pending batches and complete the asynchronous request.
+            /// @param request asynchronous request of the response.
+            /// @param index index of the batch.
+            /// @param result pointer to inference result, ownership is taken, nullptr if the stream closed.
+            void onResult(const std::shared_ptr<AsyncRequest> &request, const size_t &index, tc::InferResult *result);
+
+            /// @brief Join batch results along the first dimension and invoke the request callback.
+            /// @param request completed asynchronous request.
+            void finish(AsyncRequest &request);
 
             /// @brief Validate inference data with confugration and buffer allocations.
             /// @param data vector of input data.
+            /// @param input_indices model input index of each input data, matched by name.
             /// @return Error code to validate process.
-            cps_utils::Error validate(const std::vector<cps_utils::InferenceData<uint8_t>> &data);
+            cps_utils::Error validate(const std::vector<cps_utils::InferenceData<T>> &data, std::vector<int> &input_indices);
             /// @brief Apply postprocessing to convert response from server to buffer outputs.
+            /// The output buffer shares ownership of the result, or of the shared memory slot, instead of copying its data.
             /// @param result pointer to inference result.
             /// @param res Store buffer output.
-            /// @param batch_size inference batch size.
-            /// @param output_name output name.
+            /// @param output_index index of the model output.
+            /// @param shm_slot shared memory slot of the batch, null when shared memory is not used.
             /// @return Error code to validate process.
-            cps_utils::Error postprocess(const std::unique_ptr<tc::InferResult> &result, cps_utils::InferenceResult<T> &res,
-                                         const size_t &batch_size, const std::string &output_name);
+            cps_utils::Error postprocess(const std::shared_ptr<tc::InferResult> &result, cps_utils::InferenceResult<T> &res,
+                                         const size_t &output_index, const std::shared_ptr<SharedMemorySlot> &shm_slot);
         };
     }
 }
@@ -39,15 +39,43 @@ namespace cpp_server
             GRPC = 1
         };
 
+        /// @brief Policy to spread requests across Triton endpoints.
+        enum LoadBalancingPolicy
+        {
+            /// @brief Endpoint with the fewest requests in flight.
+            LEAST_OUTSTANDING = 0,
+            /// @brief Less loaded of two endpoints picked at random.
+            POWER_OF_TWO_CHOICES = 1
+        };
+
         /// @brief Configuration to access triton server.
         struct ClientConfig
         {
             std::string model_name;
             std::string model_version{""};
             std::string url{"localhost:8000"};
+            /// @brief Triton endpoints to balance requests across, url is used when empty.
+            std::vector<std::string> urls;
+            /// @brief Number of client connections opened to each endpoint.
+            int connections_per_endpoint{1};
+            LoadBalancingPolicy load_balancing{LoadBalancingPolicy::LEAST_OUTSTANDING};
+            /// @brief Consecutive failed requests before an endpoint is ejected.
+            int max_consecutive_failures{3};
+            /// @brief Interval between endpoint readiness probes in milliseconds, 0 disables probing.
+            /// Ejected endpoints are re-added once they report ready.
+            int health_check_interval_ms{1000};
+            /// @brief Multiplex requests over one long-lived bidirectional stream per gRPC connection
+            /// instead of unary calls, ignored for HTTP.
+            bool use_streaming{false};
             ProtocolType protocol = ProtocolType::HTTP;
             tc::Headers http_headers;
             bool verbose;
+            /// @brief Exchange tensors through system shared memory, only metadata is sent over the socket.
+            /// Triton must run on the same host and share the IPC namespace.
+            bool use_shared_memory{false};
+            /// @brief Maximum number of batches of one request in flight, requests larger than the model
+            /// max batch size are split and pipelined instead of sent one round trip after another.
+            int max_outstanding_requests{4};
         };
 
         /// @brief Parse model configuration from grpc client.
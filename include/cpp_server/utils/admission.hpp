@@ -0,0 +1,105 @@
+#ifndef ADMISSION_HPP
+#define ADMISSION_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <boost/fiber/condition_variable.hpp>
+#include <boost/fiber/mutex.hpp>
+#include "common.hpp"
+#include "error.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Configuration of an admission controller.
+        struct AdmissionConfig
+        {
+            /// @brief Maximum number of requests processed at the same time.
+            size_t max_in_flight{64};
+            /// @brief Maximum number of requests waiting for admission, more are rejected right away.
+            size_t max_queue{256};
+            /// @brief Maximum time a request waits for admission, in microseconds.
+            /// 0 rejects requests right away when max_in_flight is reached, negative waits without limit.
+            int64_t max_queue_delay_us{100000};
+        };
+
+        /// @brief Bound the requests in flight and the requests queued for admission.
+        ///
+        /// Requests over max_in_flight wait in a bounded queue. A request is rejected without
+        /// waiting when the queue is full, or when the expected wait, estimated from the average
+        /// service time, would take it past its deadline or the maximum queue delay. Waiting is
+        /// fiber-aware.
+        class AdmissionController
+        {
+        public:
+            /// @brief Release an admitted request and record its service time.
+            struct Releaser
+            {
+                std::chrono::steady_clock::time_point start;
+                void operator()(AdmissionController *controller) const;
+            };
+            /// @brief Admission of a request, released when the pointer is destroyed.
+            typedef std::unique_ptr<AdmissionController, Releaser> Ticket;
+
+            /// @brief Construct admission controller.
+            /// @param config admission configuration.
+            explicit AdmissionController(const AdmissionConfig &config = AdmissionConfig());
+
+            AdmissionController(const AdmissionController &controller) = delete;
+            AdmissionController &operator=(const AdmissionController &controller) = delete;
+            AdmissionController(AdmissionController &&controller) = delete;
+            AdmissionController &operator=(AdmissionController &&controller) = delete;
+
+            /// @brief Admit a request, waiting in the queue while max_in_flight requests are processed.
+            /// @param deadline request deadline.
+            /// @param ticket admission of the request, hold it until the response is written.
+            /// @return Error code, DEADLINE_EXCEEDED if the deadline already passed, RESOURCE_EXHAUSTED
+            /// if the queue is full, UNAVAILABLE if the request can't be admitted in time.
+            Error admit(const Deadline &deadline, Ticket &ticket);
+
+            /// @brief Get number of seconds a rejected client should wait before retrying, at least 1.
+            int retryAfter() const;
+
+            /// @brief Get number of requests currently admitted.
+            size_t inFlight() const { return in_flight; }
+
+            /// @brief Get number of requests currently waiting for admission.
+            size_t queued() const { return waiting; }
+
+        private:
+            AdmissionConfig config{};
+
+            std::atomic<size_t> in_flight{0};
+            std::atomic<size_t> waiting{0};
+            /// @brief Moving average of the time requests are admitted, in microseconds.
+            std::atomic<int64_t> service_time_us{0};
+            boost::fibers::mutex wait_mutex;
+            boost::fibers::condition_variable wait_cv;
+
+            /// @brief Take an in flight slot without waiting.
+            /// @return true if a slot was taken.
+            bool tryAdmit();
+
+            /// @brief Estimate the time until a queued request is admitted.
+            /// @param position position of the request in the queue, from 1.
+            /// @return Expected wait in microseconds.
+            int64_t expectedWait(const size_t &position) const;
+
+            /// @brief Free an in flight slot and wake a waiting request.
+            /// @param elapsed_us time the request was admitted, in microseconds.
+            void release(const int64_t &elapsed_us);
+        };
+
+        /// @brief Compute the deadline of a request from its timeout header value.
+        /// @param timeout_ms timeout in milliseconds, an empty value sets no deadline.
+        /// @param deadline request deadline.
+        /// @return Error code, INVALID_DATA if the value is not a positive number of milliseconds.
+        Error parse_request_timeout(const std::string &timeout_ms, Deadline &deadline);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
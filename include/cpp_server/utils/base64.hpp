@@ -5,7 +5,10 @@
 #ifndef BASE64_DECODER_HPP
 #define BASE64_DECODER_HPP
 
+#include <cstddef>
 #include <string>
+#include "error.hpp"
+#include "simd.hpp"
 
 namespace cpp_server
 {
@@ -16,6 +19,22 @@ namespace cpp_server
         /// @return Decoded string data
         std::string base64_decode(std::string const &encoded_string);
 
+        /// @brief Get the number of bytes decoded from base64 data, trailing padding excluded.
+        /// @param encoded pointer to encoded characters.
+        /// @param size number of encoded characters.
+        /// @return Decoded size in bytes.
+        size_t base64_decoded_size(const char *encoded, const size_t &size);
+
+        /// @brief Decode base64 data into a caller buffer, without allocating or throwing.
+        /// @param encoded pointer to encoded characters.
+        /// @param size number of encoded characters.
+        /// @param output buffer receiving the decoded bytes.
+        /// @param output_size size of output, must equal base64_decoded_size.
+        /// @param level SIMD level of the kernel, unsupported levels fall back to scalar.
+        /// @return Error code, INVALID_DATA if the input is not valid base64 or the buffer size doesn't match.
+        Error base64_decode(const char *encoded, const size_t &size, char *output, const size_t &output_size,
+                            const SimdLevel &level = detectSimdLevel());
+
         /// @brief Encode raw string
         /// @param encoded_string string to encode
         /// @return Encoded string data
@@ -0,0 +1,122 @@
+#ifndef BATCH_PIPELINE_HPP
+#define BATCH_PIPELINE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "common.hpp"
+#include "error.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Rows of a request sent as one batch.
+        struct BatchRange
+        {
+            /// @brief First row and number of rows of the batch.
+            int64_t offset{0};
+            int64_t rows{1};
+        };
+
+        /// @brief Split the rows of a request into batches of at most batch_rows rows.
+        /// @param total_rows number of rows of the request.
+        /// @param batch_rows maximum number of rows of a batch, at least 1.
+        /// @return Batches in row order.
+        std::vector<BatchRange> split_batches(const int64_t &total_rows, const int64_t &batch_rows);
+
+        /// @brief Sending state of a request split into batches.
+        ///
+        /// Batches are sent in order with at most max_outstanding of them in flight, and complete in
+        /// any order. The first failure stops sending the remaining batches, the request completes once
+        /// the batches in flight are done. Safe to use from the threads completing the batches.
+        class BatchPipeline
+        {
+        public:
+            /// @brief Construct pipeline of a request.
+            /// @param num_batches number of batches of the request.
+            /// @param max_outstanding maximum number of batches in flight, at least 1.
+            BatchPipeline(const size_t &num_batches, const size_t &max_outstanding);
+
+            BatchPipeline(const BatchPipeline &pipeline) = delete;
+            BatchPipeline &operator=(const BatchPipeline &pipeline) = delete;
+            BatchPipeline(BatchPipeline &&pipeline) = delete;
+            BatchPipeline &operator=(BatchPipeline &&pipeline) = delete;
+
+            /// @brief Take the next batch to send, it counts as in flight until completed.
+            /// @param index index of the batch.
+            /// @return false if every batch is sent, a batch failed or max_outstanding batches are in flight.
+            bool next(size_t &index);
+
+            /// @brief Mark a batch in flight as done.
+            /// @param err status of the batch.
+            /// @return true for the one call completing the request, the caller then finishes it.
+            bool complete(const Error &err);
+
+            /// @brief Get first error of any batch, success once every batch completed without one.
+            Error error();
+
+        private:
+            std::mutex mutex;
+            size_t num_batches{0};
+            size_t max_outstanding{1};
+            size_t next_batch{0};
+            size_t in_flight{0};
+            Error first_error;
+            bool finished{false};
+        };
+
+        /// @brief Join the results of the batches of a request along the first dimension.
+        /// @param batch_results results of each batch in batch order, one per output.
+        /// @param results joined results, one per output. A single batch is passed as is.
+        /// @return Error code, INFERENCE_ERROR if batches don't have the same outputs.
+        template <typename T>
+        Error join_batches(const std::vector<std::vector<InferenceResult<T>>> &batch_results, std::vector<InferenceResult<T>> &results)
+        {
+            if (batch_results.empty())
+            {
+                return Error::Success;
+            }
+            const size_t num_outputs = batch_results[0].size();
+            for (const std::vector<InferenceResult<T>> &batch : batch_results)
+            {
+                if (batch.size() != num_outputs)
+                {
+                    return Error(Error::Code::INFERENCE_ERROR, "Batches of a request have different outputs");
+                }
+            }
+
+            for (size_t o = 0; o < num_outputs; ++o)
+            {
+                InferenceResult<T> output_data = batch_results[0][o];
+                if (batch_results.size() > 1)
+                {
+                    size_t size = 0;
+                    for (const std::vector<InferenceResult<T>> &batch : batch_results)
+                    {
+                        if (batch[o].shape.empty())
+                        {
+                            return Error(Error::Code::INFERENCE_ERROR, "Unable to join batched output " + batch[o].name);
+                        }
+                        size += batch[o].data.size();
+                    }
+                    output_data.data = TensorBuffer<T>(size);
+                    output_data.shape[0] = 0;
+
+                    T *dst = output_data.data.data();
+                    for (const std::vector<InferenceResult<T>> &batch : batch_results)
+                    {
+                        dst = std::copy(batch[o].data.begin(), batch[o].data.end(), dst);
+                        output_data.shape[0] += batch[o].shape[0];
+                    }
+                    output_data.byte_size = sizeof(T) * size;
+                }
+                results.push_back(std::move(output_data));
+            }
+            return Error::Success;
+        }
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef COMMON_HELPER_HPP
 #define COMMON_HELPER_HPP
 
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
+#include "tensor.hpp"
 
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const std::vector<T>& v)
@@ -48,8 +51,20 @@ namespace cpp_server
             return accumulate(v.begin(), v.end(), 1, std::multiplies<T>());
         }
 
-        // TODO: Replace with singular form node type
+        /// @brief Struct to store an input or output tensor description of a model.
+        struct TensorConfig
+        {
+            std::string name_;
+            std::string datatype_{"FP32"};
+            std::string format_{"FORMAT_NONE"};
+            /// @brief Tensor shape including the batch dimension, -1 for variable-size dimensions.
+            std::vector<int64_t> shape_;
+            /// @brief Byte size of the full batch, -1 when the shape has variable-size dimensions.
+            int64_t byte_size_{};
+        };
+
         /// @brief Struct to store model configuration from inference engine.
+        /// The single input_* and output_* fields mirror the first input and output.
         struct ModelConfig
         {
             std::string input_name_{"input"};
@@ -63,17 +78,78 @@ namespace cpp_server
             int output_byte_size_{};
             int max_batch_size_{0};
             bool channel_first_{true};
+            /// @brief All model inputs and outputs, in model order.
+            std::vector<TensorConfig> inputs_;
+            std::vector<TensorConfig> outputs_;
+
+            /// @brief Find input by name.
+            /// @param name input name.
+            /// @return Index of the input, -1 if the model has no such input.
+            int inputIndex(const std::string &name) const
+            {
+                for (size_t i = 0; i < inputs_.size(); ++i)
+                {
+                    if (inputs_[i].name_ == name)
+                    {
+                        return i;
+                    }
+                }
+                return -1;
+            }
+
+            /// @brief Find output by name.
+            /// @param name output name.
+            /// @return Index of the output, -1 if the model has no such output.
+            int outputIndex(const std::string &name) const
+            {
+                for (size_t i = 0; i < outputs_.size(); ++i)
+                {
+                    if (outputs_[i].name_ == name)
+                    {
+                        return i;
+                    }
+                }
+                return -1;
+            }
+
+            /// @brief Copy the first input and output to the single tensor fields.
+            void syncFirstTensors()
+            {
+                if (!inputs_.empty())
+                {
+                    input_name_ = inputs_[0].name_;
+                    input_datatype_ = inputs_[0].datatype_;
+                    input_format_ = inputs_[0].format_;
+                    input_shape_ = inputs_[0].shape_;
+                    input_byte_size_ = inputs_[0].byte_size_;
+                }
+                if (!outputs_.empty())
+                {
+                    output_name_ = outputs_[0].name_;
+                    output_datatype_ = outputs_[0].datatype_;
+                    output_shape_ = outputs_[0].shape_;
+                    output_byte_size_ = outputs_[0].byte_size_;
+                }
+            }
         };
 
+        /// @brief Point in time after which the result of a request is no longer useful.
+        typedef std::chrono::steady_clock::time_point Deadline;
+
+        /// @brief Deadline of requests without one.
+        inline Deadline no_deadline() { return Deadline::max(); }
+
         /// @brief Struct to store inference input data to inference process.
         /// @tparam T Type of inferece data.
         template <typename T>
         struct InferenceData
         {
-            std::vector<T> data;
+            TensorBuffer<T> data;
             std::string name;
             std::string data_dtype;
             std::vector<int64_t> shape;
+            /// @brief Requests past their deadline are dropped before inference.
+            Deadline deadline{no_deadline()};
         };
 
         /// @brief Struct to store inference result data from inference process.
@@ -81,7 +157,7 @@ namespace cpp_server
         template <typename T>
         struct InferenceResult
         {
-            std::vector<T> data;
+            TensorBuffer<T> data;
             std::string data_dtype;
             std::vector<int64_t> shape;
             std::string name;
@@ -95,6 +171,8 @@ namespace cpp_server
             std::string name;
             int class_idx;
             float score;
+            /// @brief Best classes as class index and score, sorted from the highest score.
+            std::vector<std::pair<int, float>> top_classes;
         };
 
         /// @brief Convert vector<T> to vector<uint8_t>
@@ -125,14 +203,20 @@ namespace cpp_server
 
 static std::ostream& operator<<(std::ostream& os, const cpp_server::utils::ModelConfig& m)
 {
-    os << "Input name: " <<  m.input_name_ << "\n";
-    os << "Input shape: " <<  m.input_shape_ << "\n";
-    os << "Input dtype: " <<  m.input_datatype_ << "\n";
-    os << "Input bytesize: " <<  m.input_byte_size_ << "\n";
-    os << "Output name: " << m.output_name_ << "\n";
-    os << "Output shape: " <<  m.output_shape_ << "\n";
-    os << "Output dtype: " <<  m.output_datatype_ << "\n";
-    os << "Output bytesize: " <<  m.output_byte_size_ << "\n";
+    for (const cpp_server::utils::TensorConfig &input : m.inputs_)
+    {
+        os << "Input name: " <<  input.name_ << "\n";
+        os << "Input shape: " <<  input.shape_ << "\n";
+        os << "Input dtype: " <<  input.datatype_ << "\n";
+        os << "Input bytesize: " <<  input.byte_size_ << "\n";
+    }
+    for (const cpp_server::utils::TensorConfig &output : m.outputs_)
+    {
+        os << "Output name: " << output.name_ << "\n";
+        os << "Output shape: " <<  output.shape_ << "\n";
+        os << "Output dtype: " <<  output.datatype_ << "\n";
+        os << "Output bytesize: " <<  output.byte_size_ << "\n";
+    }
     os << "Max batch size: " << m.max_batch_size_;
     return os;
 }
@@ -45,7 +45,10 @@ namespace cpp_server
                 INFERENCE_ERROR,
                 UNAVAILABLE,
                 UNSUPPORTED,
-                ALREADY_EXISTS
+                ALREADY_EXISTS,
+                RESOURCE_EXHAUSTED,
+                DEADLINE_EXCEEDED,
+                NOT_FOUND
             };
 
             explicit Error(Code code = Code::SUCCESS) : code_(code) {}
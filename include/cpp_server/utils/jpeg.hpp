@@ -0,0 +1,30 @@
+#ifndef JPEG_HPP
+#define JPEG_HPP
+
+#include <cstddef>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Read the frame size from the SOF header of a JPEG image without decoding it.
+        /// @param data pointer to encoded image bytes.
+        /// @param size image size in bytes.
+        /// @param width image width in pixels.
+        /// @param height image height in pixels.
+        /// @return False if the data is not a JPEG image or has no frame header.
+        bool jpeg_size(const char *data, const size_t &size, int &width, int &height);
+
+        /// @brief Get the largest DCT scale denominator (1, 2, 4 or 8) keeping the image at or above the target size.
+        /// The smaller image side is compared with the larger target side, so the choice still holds
+        /// when the decoder rotates the image by its EXIF orientation.
+        /// @param width image width in pixels.
+        /// @param height image height in pixels.
+        /// @param target_width width the image is resized to after decoding.
+        /// @param target_height height the image is resized to after decoding.
+        /// @return Scale denominator, 1 for a full resolution decode.
+        int jpeg_scale_denominator(const int &width, const int &height, const int &target_width, const int &target_height);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
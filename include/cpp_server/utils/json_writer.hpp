@@ -0,0 +1,80 @@
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <rapidjson/allocators.h>
+#include <rapidjson/document.h>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief rapidjson output stream appending to a string, e.g. an HTTP response body.
+        class StringOutputStream
+        {
+        public:
+            typedef char Ch;
+
+            explicit StringOutputStream(std::string &output) : output(output) {}
+
+            void Put(Ch c) { output.push_back(c); }
+            void Flush() {}
+
+        private:
+            std::string &output;
+        };
+
+        /// @brief Reusable memory to build and write one JSON response without heap allocations.
+        ///
+        /// Documents built with allocator() and the writer stack of write_json are served from an
+        /// inline buffer. Buffers are recycled through a free list of the calling thread, so the
+        /// request fibers of a service thread take turns on the same few buffers.
+        class JsonBuffer
+        {
+        public:
+            typedef rapidjson::MemoryPoolAllocator<> Allocator;
+
+            /// @brief Return the buffer to the free list of the current thread instead of deleting it.
+            struct Releaser
+            {
+                void operator()(JsonBuffer *buffer) const;
+            };
+            typedef std::unique_ptr<JsonBuffer, Releaser> Ptr;
+
+            JsonBuffer();
+
+            JsonBuffer(const JsonBuffer &buffer) = delete;
+            JsonBuffer &operator=(const JsonBuffer &buffer) = delete;
+            JsonBuffer(JsonBuffer &&buffer) = delete;
+            JsonBuffer &operator=(JsonBuffer &&buffer) = delete;
+
+            /// @brief Take a buffer from the free list of the calling thread, or allocate one.
+            /// Documents using its allocator must be destroyed before the buffer is released.
+            /// @return Buffer returned to the free list when the pointer is destroyed.
+            static Ptr acquire();
+
+            /// @brief Allocator for rapidjson documents and writers, backed by the inline buffer.
+            Allocator &allocator() { return pool_allocator; }
+
+            /// @brief Size of the last output written with this buffer, reserved for the next one.
+            size_t last_output_size{0};
+
+        private:
+            /// @brief Inline capacity, enough for the classification results of a typical batch.
+            static const size_t inline_size = 16384;
+            char inline_buffer[inline_size];
+            Allocator pool_allocator;
+        };
+
+        /// @brief Serialize a JSON value straight into a string, without an intermediate StringBuffer.
+        /// @param value JSON value to write.
+        /// @param output string the JSON text is appended to.
+        /// @param buffer buffer serving the writer stack, also sizes output ahead of writing.
+        /// @param max_decimal_places maximum number of decimal places of floating point numbers.
+        void write_json(const rapidjson::Value &value, std::string &output, JsonBuffer &buffer, const int &max_decimal_places);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MAPPED_FILE_HPP
+#define MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Read-only memory mapping of a file.
+        ///
+        /// Pages are shared through the page cache, so processes mapping the same file don't
+        /// hold private copies of its content.
+        class MappedFile
+        {
+        public:
+            /// @brief Map the whole file.
+            /// @param path path to the file.
+            explicit MappedFile(const std::string &path);
+
+            /// @brief Unmap the file.
+            ~MappedFile();
+
+            MappedFile(const MappedFile &file) = delete;
+            MappedFile &operator=(const MappedFile &file) = delete;
+            MappedFile(MappedFile &&file) = delete;
+            MappedFile &operator=(MappedFile &&file) = delete;
+
+            /// @brief Check if the file is mapped.
+            bool isValid() const { return data_ != nullptr; }
+
+            /// @brief Get pointer to the first byte.
+            const void *data() const { return data_; }
+
+            /// @brief Get file size in bytes.
+            size_t size() const { return size_; }
+
+        private:
+            void *data_{nullptr};
+            size_t size_{0};
+        };
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MULTIPART_HPP
+#define MULTIPART_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "error.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Part of a multipart/form-data body, its content points into the body buffer.
+        struct MultipartPart
+        {
+            std::string name;
+            std::string filename;
+            std::string content_type;
+            const char *data{nullptr};
+            size_t size{0};
+        };
+
+        /// @brief Get the boundary parameter of a multipart Content-Type header.
+        /// @param content_type Content-Type header value.
+        /// @param boundary parsed boundary, without the leading dashes.
+        /// @return False if the header is not multipart/form-data or has no boundary.
+        bool multipart_boundary(const std::string &content_type, std::string &boundary);
+
+        /// @brief Split a multipart/form-data body into parts without copying their content.
+        /// The body buffer must outlive the parts.
+        /// @param body pointer to the request body.
+        /// @param size body size in bytes.
+        /// @param boundary boundary from the Content-Type header.
+        /// @param parts parsed parts in body order.
+        /// @return Error code to validate process.
+        Error parse_multipart(const char *body, const size_t &size, const std::string &boundary, std::vector<MultipartPart> &parts);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef NORMALIZE_HELPER_HPP
+#define NORMALIZE_HELPER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include "simd.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Per-channel normalization applied as (pixel / 255 - mean) / std, in output channel order.
+        /// Defaults to ImageNet mean and standard deviation for RGB.
+        struct NormalizeParams
+        {
+            float mean[3]{0.485f, 0.456f, 0.406f};
+            float std[3]{0.229f, 0.224f, 0.225f};
+        };
+
+        /// @brief Convert an interleaved 8-bit BGR image to planar normalized float (CHW) in a single pass.
+        /// @param src pointer to the first pixel.
+        /// @param src_step number of bytes between the start of two rows.
+        /// @param width image width.
+        /// @param height image height.
+        /// @param swap_rb write channels as RGB instead of BGR.
+        /// @param params normalization parameters in output channel order.
+        /// @param dst output buffer of 3 * width * height floats.
+        /// @param level SIMD level of the kernel, unsupported levels fall back to scalar.
+        void bgr_to_chw_normalize(const uint8_t *src, const size_t &src_step, const int &width, const int &height,
+                                  const bool &swap_rb, const NormalizeParams &params, float *dst,
+                                  const SimdLevel &level = detectSimdLevel());
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
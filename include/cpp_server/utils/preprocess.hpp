@@ -0,0 +1,112 @@
+#ifndef PREPROCESS_HPP
+#define PREPROCESS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <rapidjson/document.h>
+#include "common.hpp"
+#include "error.hpp"
+#include "normalize.hpp"
+#include "simd.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief How a decoded image is fitted to the network input size.
+        enum class ResizeMode
+        {
+            /// @brief Resize to the input size, ignoring the aspect ratio.
+            STRETCH,
+            /// @brief Keep the aspect ratio and pad the borders with pad_value.
+            LETTERBOX,
+            /// @brief Keep the aspect ratio and crop the center that fills the input.
+            CENTER_CROP
+        };
+
+        /// @brief Resize interpolation, values match cv::InterpolationFlags.
+        enum class Interpolation
+        {
+            NEAREST = 0,
+            LINEAR = 1,
+            CUBIC = 2,
+            AREA = 3
+        };
+
+        /// @brief Channel order of the image tensor, decoded images are BGR.
+        enum class ColorOrder
+        {
+            RGB,
+            BGR
+        };
+
+        /// @brief Memory layout of the image tensor.
+        enum class TensorLayout
+        {
+            /// @brief Follow the model input format, NCHW unless the model declares FORMAT_NHWC.
+            AUTO,
+            NCHW,
+            NHWC
+        };
+
+        /// @brief Declarative image preprocessing, read per model.
+        ///
+        /// The stages are not run one by one. Resize mode and interpolation become a single
+        /// geometric pass, color order, normalization and layout become a single packing
+        /// pass over the resized image, see pack_image.
+        struct PreprocessConfig
+        {
+            /// @brief Network input width and height, 0 to take them from the model input shape.
+            int width{0};
+            int height{0};
+            ResizeMode resize_mode{ResizeMode::STRETCH};
+            Interpolation interpolation{Interpolation::CUBIC};
+            /// @brief Border value of letterboxed images.
+            uint8_t pad_value{0};
+            ColorOrder color_order{ColorOrder::RGB};
+            /// @brief Normalization in output channel order.
+            NormalizeParams normalize{};
+            TensorLayout layout{TensorLayout::AUTO};
+            /// @brief Output element type, only FP32 as the inference engines take float tensors.
+            /// Empty to follow the model input datatype, which must then be FP32.
+            std::string datatype;
+        };
+
+        /// @brief Read preprocessing options from a JSON object, options not present keep their value.
+        ///
+        /// Example: {"width": 384, "height": 384, "resize_mode": "letterbox", "interpolation": "linear",
+        /// "pad_value": 114, "color_order": "RGB", "mean": [0.485, 0.456, 0.406], "std": [0.229, 0.224, 0.225],
+        /// "layout": "NCHW", "datatype": "FP32"}
+        /// @param value JSON object with preprocessing options.
+        /// @param config preprocessing configuration to update.
+        /// @return Error code, VALIDATION_ERROR on unknown options or values.
+        Error parse_preprocess_config(const rapidjson::Value &value, PreprocessConfig &config);
+
+        /// @brief Read preprocessing options from a JSON file.
+        /// @param path path of the JSON file.
+        /// @param config preprocessing configuration to update.
+        /// @return Error code to validate process.
+        Error load_preprocess_config(const std::string &path, PreprocessConfig &config);
+
+        /// @brief Fill options left to the model: input size, layout and datatype.
+        /// @param model_config model configuration from the inference engine.
+        /// @param config preprocessing configuration to update.
+        /// @return Error code, UNSUPPORTED if the datatype is not FP32, VALIDATION_ERROR if the configured
+        /// width or height differs from a fixed model input dimension.
+        Error resolve_preprocess_config(const ModelConfig &model_config, PreprocessConfig &config);
+
+        /// @brief Convert an interleaved 8-bit BGR image to the tensor described by a resolved config in one pass.
+        /// @param src pointer to the first pixel.
+        /// @param src_step number of bytes between the start of two rows.
+        /// @param width image width.
+        /// @param height image height.
+        /// @param config resolved preprocessing configuration.
+        /// @param dst output buffer of 3 * width * height floats.
+        /// @param level SIMD level of the kernels, unsupported levels fall back to scalar.
+        void pack_image(const uint8_t *src, const size_t &src_step, const int &width, const int &height,
+                        const PreprocessConfig &config, float *dst, const SimdLevel &level = detectSimdLevel());
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
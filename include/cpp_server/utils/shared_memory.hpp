@@ -0,0 +1,53 @@
+#ifndef SHARED_MEMORY_HPP
+#define SHARED_MEMORY_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief POSIX shared memory region mapped for reading and writing.
+        ///
+        /// The creating instance owns the region and unlinks it on destruction, other processes
+        /// such as an inference server on the same host open it by key.
+        class SharedMemoryRegion
+        {
+        public:
+            /// @brief Create or open a shared memory region.
+            /// @param key shared memory key, starting with '/'.
+            /// @param byte_size size of the region in bytes.
+            /// @param create create a new region instead of opening an existing one.
+            SharedMemoryRegion(const std::string &key, const size_t &byte_size, const bool &create = true);
+
+            /// @brief Unmap the region, and unlink it if it was created by this instance.
+            ~SharedMemoryRegion();
+
+            SharedMemoryRegion(const SharedMemoryRegion &region) = delete;
+            SharedMemoryRegion &operator=(const SharedMemoryRegion &region) = delete;
+            SharedMemoryRegion(SharedMemoryRegion &&region) = delete;
+            SharedMemoryRegion &operator=(SharedMemoryRegion &&region) = delete;
+
+            /// @brief Check if the region is mapped.
+            bool isValid() const { return data_ != nullptr; }
+
+            /// @brief Get pointer to the first byte.
+            void *data() const { return data_; }
+
+            /// @brief Get region size in bytes.
+            size_t size() const { return size_; }
+
+            /// @brief Get shared memory key.
+            const std::string &key() const { return key_; }
+
+        private:
+            std::string key_;
+            void *data_{nullptr};
+            size_t size_{0};
+            bool owner_{false};
+        };
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef SIMD_HELPER_HPP
+#define SIMD_HELPER_HPP
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Instruction set used by vectorized kernels, ordered from the least capable.
+        enum class SimdLevel
+        {
+            SCALAR,
+            SSSE3,
+            AVX2,
+            AVX512,
+            NEON
+        };
+
+        /// @brief Detect the best instruction set supported by the running CPU, cached after the first call.
+        /// @return Best supported SIMD level.
+        SimdLevel detectSimdLevel();
+
+        /// @brief Check if the running CPU supports an instruction set.
+        /// @param level SIMD level to check.
+        /// @return boolean status.
+        bool simdSupported(const SimdLevel &level);
+
+        /// @brief Get SIMD level name as a string.
+        /// @param level SIMD level.
+        /// @return Name of the level.
+        const char *simdLevelName(const SimdLevel &level);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SOFTMAX_HPP
+#define SOFTMAX_HPP
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include "simd.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Replace logits by their softmax probabilities in place.
+        /// Vectorized kernels use a polynomial exp approximation with a relative error below 2e-7
+        /// over the range used by softmax, so probabilities match the scalar kernel within float rounding.
+        /// @param data pointer to the logits of one row.
+        /// @param size number of logits.
+        /// @param level SIMD level of the kernel, unsupported levels fall back to scalar.
+        void softmax(float *data, const size_t &size, const SimdLevel &level = detectSimdLevel());
+
+        /// @brief Select the k largest values of a row, ties keep the lower index first.
+        /// @param data pointer to the values of one row.
+        /// @param size number of values.
+        /// @param k number of values to select, at most size are returned.
+        /// @param output pairs of index and value, sorted from the largest value.
+        void top_k(const float *data, const size_t &size, const size_t &k, std::vector<std::pair<int, float>> &output);
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef TENSOR_HELPER_HPP
+#define TENSOR_HELPER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Reference counted, possibly non-owning, contiguous buffer of tensor elements.
+        ///
+        /// Copies share the same memory, so tensors can be passed from preprocessing to the
+        /// inference engine and back to postprocessing without copying the elements. Memory is
+        /// released with the deleter given at construction once the last copy is destroyed.
+        /// @tparam T Type of tensor elements.
+        template <typename T>
+        class TensorBuffer
+        {
+        public:
+            typedef T value_type;
+            typedef T *iterator;
+            typedef const T *const_iterator;
+
+            TensorBuffer() = default;
+
+            /// @brief Allocate an uninitialized buffer owned by this tensor.
+            /// @param size number of elements.
+            explicit TensorBuffer(const size_t &size)
+                : ptr_(size > 0 ? new T[size] : nullptr, std::default_delete<T[]>()), size_(size) {}
+
+            /// @brief Allocate a buffer initialized with a copy of the elements.
+            /// @param data elements to copy.
+            TensorBuffer(const std::vector<T> &data)
+                : TensorBuffer(data.size())
+            {
+                std::copy(data.begin(), data.end(), ptr_.get());
+            }
+
+            /// @brief Allocate a buffer initialized with a copy of the elements.
+            /// @param data elements to copy.
+            TensorBuffer(std::initializer_list<T> data)
+                : TensorBuffer(data.size())
+            {
+                std::copy(data.begin(), data.end(), ptr_.get());
+            }
+
+            /// @brief Wrap external memory, deleter is invoked once the last copy is destroyed.
+            /// @param ptr pointer to the first element.
+            /// @param size number of elements.
+            /// @param deleter function releasing ptr.
+            TensorBuffer(T *ptr, const size_t &size, std::function<void(T *)> deleter)
+                : ptr_(ptr, deleter), size_(size) {}
+
+            /// @brief Share ownership of another object that holds the elements.
+            /// @param owner object keeping ptr valid, e.g. an inference result.
+            /// @param ptr pointer to the first element.
+            /// @param size number of elements.
+            template <typename U>
+            TensorBuffer(const std::shared_ptr<U> &owner, T *ptr, const size_t &size)
+                : ptr_(owner, ptr), size_(size) {}
+
+            /// @brief Non-owning view of external memory, caller keeps ptr valid.
+            /// @param ptr pointer to the first element.
+            /// @param size number of elements.
+            /// @return Tensor buffer viewing ptr.
+            static TensorBuffer view(T *ptr, const size_t &size)
+            {
+                return TensorBuffer(std::shared_ptr<T>(), ptr, size);
+            }
+
+            /// @brief Get a range of elements sharing ownership with this buffer.
+            /// @param offset index of the first element.
+            /// @param count number of elements.
+            /// @return Tensor buffer of the range.
+            TensorBuffer slice(const size_t &offset, const size_t &count) const
+            {
+                return TensorBuffer(ptr_, ptr_.get() + offset, count);
+            }
+
+            T *data() const { return ptr_.get(); }
+            size_t size() const { return size_; }
+            bool empty() const { return size_ == 0; }
+            T *begin() const { return ptr_.get(); }
+            T *end() const { return ptr_.get() + size_; }
+            T &operator[](const size_t &idx) const { return ptr_.get()[idx]; }
+
+            /// @brief Number of tensors sharing this memory, 0 for non-owning views.
+            long use_count() const { return ptr_.use_count(); }
+
+        private:
+            std::shared_ptr<T> ptr_;
+            size_t size_{0};
+        };
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        /// @brief Fixed size pool of worker threads executing queued tasks in order.
+        class ThreadPool
+        {
+        public:
+            /// @brief Start worker threads.
+            /// @param num_threads number of worker threads, at least one is started.
+            explicit ThreadPool(const size_t &num_threads);
+
+            /// @brief Run the remaining queued tasks and join worker threads.
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &pool) = delete;
+            ThreadPool &operator=(const ThreadPool &pool) = delete;
+            ThreadPool(ThreadPool &&pool) = delete;
+            ThreadPool &operator=(ThreadPool &&pool) = delete;
+
+            /// @brief Queue a task to be executed by one of the worker threads.
+            /// @param task function to execute.
+            void submit(std::function<void()> task);
+
+            /// @brief Get number of worker threads.
+            size_t size() const { return workers.size(); }
+
+        private:
+            /// @brief Worker loop, pop and execute tasks until stopped.
+            void run();
+
+            std::vector<std::thread> workers;
+            std::deque<std::function<void()>> tasks;
+            std::mutex tasks_mutex;
+            std::condition_variable tasks_cv;
+            bool stop{false};
+        };
+    } // namespace utils
+} // namespace cpp_server
+
+#endif
@@ -0,0 +1,328 @@
+#include "cpp_server/dynamic_batcher.hpp"
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        template <typename T>
+        DynamicBatcher<T>::DynamicBatcher(std::unique_ptr<InferenceEngine<T>> &engine, const BatcherConfig &config)
+            : config(config)
+        {
+            infer_engine = std::move(engine);
+            if (!infer_engine || !infer_engine->isOk())
+            {
+                this->status = false;
+                return;
+            }
+
+            this->model_config = infer_engine->modelConfig();
+
+            // Model specifying maximum batch size of 0 doesn't have a batch dimension,
+            // so each request is executed on its own.
+            int max_rows = 1;
+            if (this->model_config.max_batch_size_ > 0)
+            {
+                max_rows = this->model_config.max_batch_size_;
+                if (config.max_batch_size > 0)
+                {
+                    max_rows = std::min(max_rows, config.max_batch_size);
+                }
+            }
+            this->batch_size = max_rows;
+            this->status = true;
+
+            worker = std::thread(&DynamicBatcher<T>::run, this);
+        }
+
+        template <typename T>
+        DynamicBatcher<T>::~DynamicBatcher()
+        {
+            {
+                std::unique_lock<boost::fibers::mutex> lock(queue_mutex);
+                stop = true;
+            }
+            queue_cv.notify_all();
+            if (worker.joinable())
+            {
+                worker.join();
+            }
+        }
+
+        template <typename T>
+        cps_utils::Error DynamicBatcher<T>::process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
+        {
+            return this->processAwait(infer_data, infer_results);
+        }
+
+        template <typename T>
+        cps_utils::Error DynamicBatcher<T>::processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback)
+        {
+            if (!this->status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Dynamic batcher is not initialized");
+            }
+            if (infer_data.empty())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Inference data is empty.");
+            }
+
+            std::unique_ptr<Request> request(new Request());
+            request->infer_data = &infer_data;
+            request->callback = std::move(callback);
+            request->rows = 1;
+            if (this->model_config.max_batch_size_ > 0 && !infer_data[0].shape.empty())
+            {
+                request->rows = infer_data[0].shape[0];
+            }
+            request->enqueue_time = std::chrono::steady_clock::now();
+            request->deadline = infer_data[0].deadline;
+
+            {
+                std::unique_lock<boost::fibers::mutex> lock(queue_mutex);
+                if (stop)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "Dynamic batcher is stopped");
+                }
+                queued_rows += request->rows;
+                queue.push_back(std::move(request));
+            }
+            queue_cv.notify_all();
+
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        void DynamicBatcher<T>::run()
+        {
+            std::vector<std::unique_ptr<Request>> requests;
+            while (true)
+            {
+                requests.clear();
+                {
+                    std::unique_lock<boost::fibers::mutex> lock(queue_mutex);
+                    queue_cv.wait(lock, [this]()
+                                  { return stop || !queue.empty(); });
+                    if (queue.empty())
+                    {
+                        break;
+                    }
+
+                    // Wait for the batch to fill up, bounded by the delay of the oldest request.
+                    std::chrono::steady_clock::time_point deadline =
+                        queue.front()->enqueue_time + std::chrono::microseconds(config.max_queue_delay_us);
+                    while (!stop && queued_rows < this->batch_size)
+                    {
+                        if (queue_cv.wait_until(lock, deadline) == boost::fibers::cv_status::timeout)
+                        {
+                            break;
+                        }
+                    }
+
+                    int64_t rows = 0;
+                    while (!queue.empty() && (requests.empty() || rows + queue.front()->rows <= this->batch_size))
+                    {
+                        rows += queue.front()->rows;
+                        queued_rows -= queue.front()->rows;
+                        requests.push_back(std::move(queue.front()));
+                        queue.pop_front();
+                    }
+                }
+                execute(requests);
+            }
+        }
+
+        template <typename T>
+        void DynamicBatcher<T>::execute(std::vector<std::unique_ptr<Request>> &requests)
+        {
+            // Requests that can't be concatenated with the head of the batch run on their own.
+            std::shared_ptr<Batch> batch(new Batch());
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            for (std::unique_ptr<Request> &request : requests)
+            {
+                if (now >= request->deadline)
+                {
+                    std::vector<cps_utils::InferenceResult<T>> empty_results;
+                    request->callback(cps_utils::Error(cps_utils::Error::Code::DEADLINE_EXCEEDED, "Request deadline passed while waiting for a batch"), empty_results);
+                    continue;
+                }
+                if (batch->requests.empty() || compatible(*batch->requests[0], *request))
+                {
+                    batch->requests.push_back(std::move(request));
+                    continue;
+                }
+
+                cps_utils::Error p_err;
+                try
+                {
+                    p_err = infer_engine->processAsync(*request->infer_data, request->callback);
+                }
+                catch (const std::exception &ex)
+                {
+                    p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, ex.what());
+                }
+                if (!p_err.IsOk())
+                {
+                    std::vector<cps_utils::InferenceResult<T>> empty_results;
+                    request->callback(p_err, empty_results);
+                }
+            }
+
+            if (batch->requests.empty())
+            {
+                return;
+            }
+
+            cps_utils::Error p_err;
+            try
+            {
+                if (batch->requests.size() == 1)
+                {
+                    p_err = infer_engine->processAsync(*batch->requests[0]->infer_data, batch->requests[0]->callback);
+                }
+                else
+                {
+                    p_err = merge(*batch);
+                    if (p_err.IsOk())
+                    {
+                        p_err = infer_engine->processAsync(
+                            batch->merged,
+                            [batch](cps_utils::Error err, std::vector<cps_utils::InferenceResult<T>> &results)
+                            {
+                                std::vector<std::vector<cps_utils::InferenceResult<T>>> outputs(batch->requests.size());
+                                if (err.IsOk())
+                                {
+                                    err = scatter(results, *batch, outputs);
+                                }
+                                for (size_t i = 0; i < batch->requests.size(); ++i)
+                                {
+                                    batch->requests[i]->callback(err, outputs[i]);
+                                }
+                            });
+                    }
+                }
+            }
+            catch (const std::exception &ex)
+            {
+                p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, ex.what());
+            }
+
+            if (!p_err.IsOk())
+            {
+                std::vector<cps_utils::InferenceResult<T>> empty_results;
+                for (std::unique_ptr<Request> &request : batch->requests)
+                {
+                    request->callback(p_err, empty_results);
+                }
+            }
+        }
+
+        template <typename T>
+        bool DynamicBatcher<T>::compatible(const Request &a, const Request &b) const
+        {
+            if (this->batch_size <= 1 || a.infer_data->size() != b.infer_data->size())
+            {
+                return false;
+            }
+            for (size_t i = 0; i < a.infer_data->size(); ++i)
+            {
+                const cps_utils::InferenceData<T> &lhs = (*a.infer_data)[i];
+                const cps_utils::InferenceData<T> &rhs = (*b.infer_data)[i];
+                if (lhs.name != rhs.name || lhs.data_dtype != rhs.data_dtype || lhs.shape.size() != rhs.shape.size() || lhs.shape.empty())
+                {
+                    return false;
+                }
+                if (!std::equal(lhs.shape.begin() + 1, lhs.shape.end(), rhs.shape.begin() + 1))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        template <typename T>
+        cps_utils::Error DynamicBatcher<T>::merge(Batch &batch)
+        {
+            const std::vector<cps_utils::InferenceData<T>> &head = *batch.requests[0]->infer_data;
+            int64_t total_rows = 0;
+            // The batch is useful until its last request expires.
+            cps_utils::Deadline deadline = batch.requests[0]->deadline;
+            for (const std::unique_ptr<Request> &request : batch.requests)
+            {
+                total_rows += request->rows;
+                deadline = std::max(deadline, request->deadline);
+            }
+
+            for (size_t i = 0; i < head.size(); ++i)
+            {
+                cps_utils::InferenceData<T> input_data;
+                input_data.name = head[i].name;
+                input_data.data_dtype = head[i].data_dtype;
+                input_data.shape = head[i].shape;
+                input_data.shape[0] = total_rows;
+                input_data.deadline = deadline;
+
+                size_t size = 0;
+                for (const std::unique_ptr<Request> &request : batch.requests)
+                {
+                    size += (*request->infer_data)[i].data.size();
+                }
+                input_data.data = cps_utils::TensorBuffer<T>(size);
+
+                T *dst = input_data.data.data();
+                for (const std::unique_ptr<Request> &request : batch.requests)
+                {
+                    const cps_utils::TensorBuffer<T> &data = (*request->infer_data)[i].data;
+                    dst = std::copy(data.begin(), data.end(), dst);
+                }
+                batch.merged.push_back(std::move(input_data));
+            }
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        cps_utils::Error DynamicBatcher<T>::scatter(std::vector<cps_utils::InferenceResult<T>> &results, const Batch &batch,
+                                                    std::vector<std::vector<cps_utils::InferenceResult<T>>> &outputs)
+        {
+            int64_t total_rows = 0;
+            for (const std::unique_ptr<Request> &request : batch.requests)
+            {
+                total_rows += request->rows;
+            }
+
+            for (const cps_utils::InferenceResult<T> &result : results)
+            {
+                if (result.shape.empty() || result.shape[0] != total_rows || result.data.size() % total_rows != 0)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Unable to split batched result " + result.name);
+                }
+            }
+
+            for (const cps_utils::InferenceResult<T> &result : results)
+            {
+                size_t row_size = result.data.size() / total_rows;
+                size_t offset = 0;
+                for (size_t i = 0; i < batch.requests.size(); ++i)
+                {
+                    int64_t rows = batch.requests[i]->rows;
+                    // Each request gets a view sharing the batched result buffer.
+                    cps_utils::InferenceResult<T> output_data;
+                    output_data.data = result.data.slice(offset, rows * row_size);
+                    output_data.data_dtype = result.data_dtype;
+                    output_data.shape = result.shape;
+                    output_data.shape[0] = rows;
+                    output_data.name = result.name;
+                    output_data.byte_size = sizeof(T) * output_data.data.size();
+                    output_data.status = result.status;
+                    outputs[i].push_back(std::move(output_data));
+                    offset += rows * row_size;
+                }
+            }
+            return cps_utils::Error::Success;
+        }
+    }
+}
+
+//  https://isocpp.org/wiki/faq/templates#separate-template-class-defn-from-decl
+//  * NOTE: Solve template function linker problem
+
+template class cpp_server::inferencer::DynamicBatcher<float>;
@@ -0,0 +1,203 @@
+#include "cpp_server/engine_pool.hpp"
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        template <typename T>
+        void EnginePool<T>::Returner::operator()(InferenceEngine<T> *engine) const
+        {
+            if (engine)
+            {
+                pool->release(index);
+            }
+        }
+
+        template <typename T>
+        EnginePool<T>::EnginePool(std::vector<std::unique_ptr<InferenceEngine<T>>> &engines, const EnginePoolConfig &config)
+            : config(config)
+        {
+            if (engines.empty())
+            {
+                this->status = false;
+                return;
+            }
+            for (std::unique_ptr<InferenceEngine<T>> &engine : engines)
+            {
+                if (!engine || !engine->isOk())
+                {
+                    this->status = false;
+                    return;
+                }
+            }
+
+            this->model_config = engines[0]->modelConfig();
+            this->batch_size = this->model_config.max_batch_size_ > 0 ? this->model_config.max_batch_size_ : 1;
+            for (std::unique_ptr<InferenceEngine<T>> &engine : engines)
+            {
+                std::unique_ptr<Slot> slot(new Slot());
+                slot->engine = std::move(engine);
+                this->engines.push_back(std::move(slot));
+            }
+            engines.clear();
+
+            for (size_t i = 0; i < this->engines.size(); ++i)
+            {
+                release(i);
+            }
+            this->status = true;
+        }
+
+        template <typename T>
+        cps_utils::Error EnginePool<T>::process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
+        {
+            if (!this->status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Engine pool is not initialized");
+            }
+            int64_t index = acquire(infer_data.empty() ? cps_utils::no_deadline() : infer_data[0].deadline);
+            if (index < 0)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "No inference engine became available before the checkout timeout");
+            }
+            Lease lease(engines[index]->engine.get(), Returner{this, static_cast<size_t>(index)});
+            return lease->process(infer_data, infer_results);
+        }
+
+        template <typename T>
+        cps_utils::Error EnginePool<T>::processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback)
+        {
+            if (!this->status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Engine pool is not initialized");
+            }
+            int64_t index = acquire(infer_data.empty() ? cps_utils::no_deadline() : infer_data[0].deadline);
+            if (index < 0)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "No inference engine became available before the checkout timeout");
+            }
+
+            cps_utils::Error p_err;
+            try
+            {
+                p_err = engines[index]->engine->processAsync(
+                    infer_data,
+                    [this, index, callback](cps_utils::Error err, std::vector<cps_utils::InferenceResult<T>> &results)
+                    {
+                        // Results own their buffers, the engine can serve the next request right away.
+                        release(index);
+                        callback(err, results);
+                    });
+            }
+            catch (const std::exception &ex)
+            {
+                p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, ex.what());
+            }
+            if (!p_err.IsOk())
+            {
+                // The callback isn't invoked when the request is rejected.
+                release(index);
+            }
+            return p_err;
+        }
+
+        template <typename T>
+        cps_utils::Error EnginePool<T>::checkout(Lease &lease)
+        {
+            if (!this->status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Engine pool is not initialized");
+            }
+            int64_t index = acquire();
+            if (index < 0)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "No inference engine became available before the checkout timeout");
+            }
+            lease = Lease(engines[index]->engine.get(), Returner{this, static_cast<size_t>(index)});
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        int64_t EnginePool<T>::tryAcquire()
+        {
+            uint64_t head = free_head.load();
+            while (true)
+            {
+                uint32_t top = static_cast<uint32_t>(head);
+                if (top == 0)
+                {
+                    return -1;
+                }
+                // Reading next of a slot popped meanwhile is harmless, the tag makes the exchange fail.
+                uint64_t next = engines[top - 1]->next.load(std::memory_order_relaxed);
+                uint64_t new_head = ((head >> 32) + 1) << 32 | next;
+                if (free_head.compare_exchange_weak(head, new_head))
+                {
+                    free_count--;
+                    return top - 1;
+                }
+            }
+        }
+
+        template <typename T>
+        int64_t EnginePool<T>::acquire(const cps_utils::Deadline &deadline)
+        {
+            int64_t index = tryAcquire();
+            if (index >= 0 || config.checkout_timeout_us == 0)
+            {
+                return index;
+            }
+
+            cps_utils::Deadline wait_deadline = deadline;
+            if (config.checkout_timeout_us > 0)
+            {
+                wait_deadline = std::min(wait_deadline, std::chrono::steady_clock::now() + std::chrono::microseconds(config.checkout_timeout_us));
+            }
+            std::unique_lock<boost::fibers::mutex> lock(wait_mutex);
+            // Registered before retrying, so an engine returned after the retry sees the waiter and notifies.
+            waiters++;
+            while ((index = tryAcquire()) < 0)
+            {
+                if (wait_deadline == cps_utils::no_deadline())
+                {
+                    wait_cv.wait(lock);
+                }
+                else if (wait_cv.wait_until(lock, wait_deadline) == boost::fibers::cv_status::timeout)
+                {
+                    index = tryAcquire();
+                    break;
+                }
+            }
+            waiters--;
+            return index;
+        }
+
+        template <typename T>
+        void EnginePool<T>::release(const size_t &index)
+        {
+            // Counted before the push, so available() never drops below zero when the engine is popped right away.
+            free_count++;
+            uint64_t head = free_head.load();
+            uint64_t new_head;
+            do
+            {
+                engines[index]->next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+                new_head = ((head >> 32) + 1) << 32 | (index + 1);
+            } while (!free_head.compare_exchange_weak(head, new_head));
+
+            if (waiters > 0)
+            {
+                // Taking the mutex orders the notification after a waiter that failed its retry started waiting.
+                {
+                    std::unique_lock<boost::fibers::mutex> lock(wait_mutex);
+                }
+                wait_cv.notify_one();
+            }
+        }
+    }
+}
+
+//  https://isocpp.org/wiki/faq/templates#separate-template-class-defn-from-decl
+//  * NOTE: Solve template function linker problem
+
+template class cpp_server::inferencer::EnginePool<float>;
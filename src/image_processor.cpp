@@ -4,82 +4,128 @@ namespace cpp_server
 {
     namespace processor
     {
-        ImageProcessor::ImageProcessor(std::unique_ptr<cps_inferencer::InferenceEngine<float>> &engine)
+        ImageProcessor::ImageProcessor(std::unique_ptr<cps_inferencer::InferenceEngine<float>> &engine,
+                                       const cps_utils::PreprocessConfig &preprocess_config,
+                                       std::shared_ptr<cps_utils::ThreadPool> preprocess_pool,
+                                       const size_t &top_k)
+            : preprocess_config(preprocess_config), preprocess_pool(std::move(preprocess_pool)), top_k(std::max<size_t>(top_k, 1))
         {
             infer_engine = std::move(engine);
-        }
-
-        void ImageProcessor::apply_softmax(std::vector<float> &input)
-        {
-            // Source: https://codereview.stackexchange.com/a/180506
-            float m, sum;
-
-            m = -INFINITY;
-            for (int i = 0; i < input.size(); ++i)
-            {
-                if (m < input[i])
-                {
-                    m = input[i];
-                }
-            }
-
-            sum = 0.0;
-            for (int i = 0; i < input.size(); ++i)
+            if (!infer_engine || !infer_engine->isOk())
             {
-                sum += exp(input[i] - m);
+                return;
             }
 
-            const float constant = m + log(sum);
-            for (int i = 0; i < input.size(); ++i)
+            preprocess_status = cps_utils::resolve_preprocess_config(infer_engine->modelConfig(), this->preprocess_config);
+            if (!preprocess_status.IsOk())
             {
-                input[i] = exp(input[i] - constant);
+                std::cerr << "Invalid preprocess config: " << preprocess_status.Message() << std::endl;
             }
         }
 
-        cpp_server::utils::Error ImageProcessor::preprocess_data(const std::string &ss, std::vector<float> &output)
+        cpp_server::utils::Error ImageProcessor::preprocess_data(const char *data, const size_t &size, float *output)
         {
-            std::string decoded_string = cpp_server::utils::base64_decode(ss);
-            std::vector<uchar> data(decoded_string.begin(), decoded_string.end());
-            std::vector<int> network_shape;
-            if (infer_engine->modelConfig().input_shape_.size() > 2)
-                network_shape = std::vector<int>{
-                    infer_engine->modelConfig().input_shape_.end() - std::min<int>(infer_engine->modelConfig().input_shape_.size(), 2),
-                    infer_engine->modelConfig().input_shape_.end()};
-            else
+            if (!data || size == 0)
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::INVALID_DATA, "Empty image data");
+            // Header over the caller buffer, the encoded bytes are not copied before decoding.
+            cv::Mat encoded(1, size, CV_8UC1, const_cast<char *>(data));
+            // Large JPEGs are decoded at a reduced DCT scale that still covers the network input,
+            // which skips most of the IDCT work and memory of a full resolution decode.
+            int flags = cv::IMREAD_COLOR;
+            int width = 0, height = 0;
+            if (cps_utils::jpeg_size(data, size, width, height))
             {
-                network_shape = std::vector<int>{384, 384};
+                switch (cps_utils::jpeg_scale_denominator(width, height, preprocess_config.width, preprocess_config.height))
+                {
+                case 8:
+                    flags = cv::IMREAD_REDUCED_COLOR_8;
+                    break;
+                case 4:
+                    flags = cv::IMREAD_REDUCED_COLOR_4;
+                    break;
+                case 2:
+                    flags = cv::IMREAD_REDUCED_COLOR_2;
+                    break;
+                default:
+                    break;
+                }
             }
-            cv::Mat image = cv::imdecode(data, cv::IMREAD_UNCHANGED);
+            cv::Mat image = cv::imdecode(encoded, flags);
             if (image.data == NULL)
                 return cpp_server::utils::Error(cpp_server::utils::Error::Code::INVALID_DATA, "Invalid image data");
-            cv::cvtColor(image, image, cv::COLOR_BGR2RGB);
+
+            cv::Mat resized;
+            cpp_server::utils::Error p_err = resize_image(image, resized);
+            if (!p_err.IsOk())
+                return p_err;
+            // Color order, scaling, normalization and layout are applied together in one pass.
+            cps_utils::pack_image(resized.data, resized.step, resized.cols, resized.rows, preprocess_config, output);
+
+            return cpp_server::utils::Error::Success;
+        }
+
+        cpp_server::utils::Error ImageProcessor::resize_image(const cv::Mat &image, cv::Mat &output)
+        {
+            const cv::Size target(preprocess_config.width, preprocess_config.height);
+            // Interpolation values match cv::InterpolationFlags.
+            const int interpolation = static_cast<int>(preprocess_config.interpolation);
+            cv::Mat source = image;
+            cv::Rect roi(0, 0, target.width, target.height);
             try
             {
-                cv::resize(image, image, cv::Size(network_shape[0], network_shape[1]), cv::INTER_CUBIC);
-            }
-            catch (cv::Exception &e)
-            {
-                return cpp_server::utils::Error(cpp_server::utils::Error::Code::INVALID_DATA, "Input image is smaller than required output");
-            }
-            // TODO: Fix Image normalization with Imagenet std and mean.
-            image.convertTo(image, CV_32FC3, 1.f / 255);
-            // cv::subtract(cv::Scalar(0.485, 0.456, 0.406), image, image);
-            // cv::divide(0.226, image, image); // divide by average std per channel
-            output.resize(image.channels() * image.rows * image.cols);
+                switch (preprocess_config.resize_mode)
+                {
+                case cps_utils::ResizeMode::LETTERBOX:
+                {
+                    double scale = std::min(static_cast<double>(target.width) / image.cols, static_cast<double>(target.height) / image.rows);
+                    roi.width = std::min(target.width, std::max(1, static_cast<int>(std::round(image.cols * scale))));
+                    roi.height = std::min(target.height, std::max(1, static_cast<int>(std::round(image.rows * scale))));
+                    roi.x = (target.width - roi.width) / 2;
+                    roi.y = (target.height - roi.height) / 2;
 
-            // Store image to float as CHW
-            for (int y = 0; y < image.rows; ++y)
-            {
-                for (int x = 0; x < image.cols; ++x)
+                    // Only the borders are filled, the image area is written once by the resize below.
+                    output.create(target, image.type());
+                    const cv::Scalar pad = cv::Scalar::all(preprocess_config.pad_value);
+                    output.rowRange(0, roi.y).setTo(pad);
+                    output.rowRange(roi.y + roi.height, target.height).setTo(pad);
+                    output(cv::Rect(0, roi.y, roi.x, roi.height)).setTo(pad);
+                    output(cv::Rect(roi.x + roi.width, roi.y, target.width - roi.x - roi.width, roi.height)).setTo(pad);
+                    break;
+                }
+                case cps_utils::ResizeMode::CENTER_CROP:
                 {
-                    for (int c = 0; c < image.channels(); ++c)
+                    // Crop before resizing, pixels outside the center are never interpolated.
+                    double scale = std::max(static_cast<double>(target.width) / image.cols, static_cast<double>(target.height) / image.rows);
+                    int crop_width = std::min(image.cols, std::max(1, static_cast<int>(std::round(target.width / scale))));
+                    int crop_height = std::min(image.rows, std::max(1, static_cast<int>(std::round(target.height / scale))));
+                    source = image(cv::Rect((image.cols - crop_width) / 2, (image.rows - crop_height) / 2, crop_width, crop_height));
+                    break;
+                }
+                default:
+                    break;
+                }
+
+                if (preprocess_config.resize_mode != cps_utils::ResizeMode::LETTERBOX)
+                {
+                    if (source.size() == target)
                     {
-                        output[c * (image.rows * image.cols) + y * image.cols + x] =
-                            image.at<cv::Vec3f>(y, x)[c];
+                        // Already at the input size, the packing pass reads the image in place.
+                        output = source;
+                        return cpp_server::utils::Error::Success;
                     }
+                    cv::resize(source, output, target, 0, 0, interpolation);
+                }
+                else
+                {
+                    // Resize into the letterbox area, create() keeps the ROI since size and type match.
+                    cv::Mat area = output(roi);
+                    cv::resize(source, area, roi.size(), 0, 0, interpolation);
                 }
             }
-
+            catch (cv::Exception &e)
+            {
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::INVALID_DATA, e.what());
+            }
             return cpp_server::utils::Error::Success;
         }
 
@@ -89,20 +135,29 @@ namespace cpp_server
             {
                 for (const cpp_server::utils::InferenceResult<float> &result : infer_results)
                 {
+                    if (result.shape.size() < 2 || result.shape[1] <= 0 || result.data.size() < static_cast<size_t>(result.shape[0] * result.shape[1]))
+                    {
+                        return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Unexpected classification output shape of " + result.name);
+                    }
                     int row_num = result.shape[0], col_num = result.shape[1];
-                    cpp_server::utils::ClassificationResult output_data;
+                    std::vector<std::pair<int, float>> best;
                     for (int i = 0; i < row_num; i++)
                     {
-                        int start_range = i * col_num, end_range = (i + 1) * col_num;
-                        std::vector<float> batch_output((result.data.begin() + start_range), (result.data.begin() + end_range));
-                        apply_softmax(batch_output);
-                        int maxElementIndex = std::max_element(batch_output.begin(), batch_output.end()) - batch_output.begin();
-                        float maxElement = *std::max_element(batch_output.begin(), batch_output.end());
-                        output_data.class_idx = maxElementIndex + 1; // zero index
-                        output_data.score = maxElement;
+                        // Softmax runs in place on the result buffer, each row is one image of the batch.
+                        float *row = result.data.data() + i * col_num;
+                        cps_utils::softmax(row, col_num);
+                        cps_utils::top_k(row, col_num, top_k, best);
+
+                        cpp_server::utils::ClassificationResult output_data;
+                        for (const std::pair<int, float> &item : best)
+                        {
+                            output_data.top_classes.push_back(std::make_pair(item.first + 1, item.second)); // zero index
+                        }
+                        output_data.class_idx = output_data.top_classes[0].first;
+                        output_data.score = output_data.top_classes[0].second;
                         output_data.name = "temp";
+                        output.push_back(output_data);
                     }
-                    output.push_back(output_data);
                 }
             }
             catch (std::exception &ex)
@@ -112,60 +167,236 @@ namespace cpp_server
             return cpp_server::utils::Error::Success;
         }
 
-        cpp_server::utils::Error ImageProcessor::process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc)
+        cpp_server::utils::Error ImageProcessor::process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                                                         const cpp_server::utils::Deadline &deadline)
+        {
+            // Images stay base64 encoded here, each one is decoded by the worker preprocessing it.
+            const rapidjson::Value &image = data_doc["image"];
+            std::vector<EncodedImage> images;
+            if (image.IsString())
+            {
+                images.push_back(EncodedImage{image.GetString(), image.GetStringLength(), true});
+            }
+            else if (image.IsArray())
+            {
+                for (rapidjson::SizeType i = 0; i < image.Size(); ++i)
+                {
+                    if (!image[i].IsString())
+                    {
+                        return cpp_server::utils::Error(cpp_server::utils::Error::Code::VALIDATION_ERROR, "Image must be a base64 encoded string");
+                    }
+                    images.push_back(EncodedImage{image[i].GetString(), image[i].GetStringLength(), true});
+                }
+            }
+            if (images.empty())
+            {
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::VALIDATION_ERROR, "Image must be a base64 encoded string or a non-empty array of them");
+            }
+            return process_images(images, result_doc, deadline);
+        }
+
+        cpp_server::utils::Error ImageProcessor::process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                                                         const cpp_server::utils::Deadline &deadline)
+        {
+            return process_images(std::vector<EncodedImage>{EncodedImage{data, size, false}}, result_doc, deadline);
+        }
+
+        cpp_server::utils::Error ImageProcessor::preprocess_image(const EncodedImage &image, float *output)
+        {
+            try
+            {
+                if (!image.base64)
+                {
+                    return preprocess_data(image.data, image.size, output);
+                }
+                // Decode straight from the JSON string into a buffer of the exact decoded size.
+                std::vector<char> decoded(cpp_server::utils::base64_decoded_size(image.data, image.size));
+                cpp_server::utils::Error p_err = cpp_server::utils::base64_decode(image.data, image.size, decoded.data(), decoded.size());
+                if (!p_err.IsOk())
+                {
+                    return p_err;
+                }
+                return preprocess_data(decoded.data(), decoded.size(), output);
+            }
+            catch (std::exception &ex)
+            {
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::INTERNAL, ex.what());
+            }
+        }
+
+        cpp_server::utils::Error ImageProcessor::process_images(const std::vector<EncodedImage> &images, rapidjson::Document &result_doc,
+                                                                const cpp_server::utils::Deadline &deadline)
         {
             if (!infer_engine || !infer_engine->isOk())
             {
                 return cpp_server::utils::Error(cpp_server::utils::Error::Code::INTERNAL, "Can't intialize inference system");
             }
-
-            std::vector<float> array_float;
-            cpp_server::utils::Error p_err;
-            p_err = preprocess_data(data_doc["image"].GetString(), array_float);
-            if (!p_err.IsOk())
+            if (!preprocess_status.IsOk())
             {
-                return p_err;
+                return preprocess_status;
+            }
+            if (std::chrono::steady_clock::now() >= deadline)
+            {
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::DEADLINE_EXCEEDED, "Request deadline passed before preprocessing");
+            }
+            const int64_t batch = images.size();
+            if (batch > 1 && infer_engine->modelConfig().max_batch_size_ <= 0)
+            {
+                return cpp_server::utils::Error(cpp_server::utils::Error::Code::VALIDATION_ERROR, "Model doesn't support batched images");
             }
 
-            std::vector<cpp_server::utils::InferenceData<float>> inference_datas;
-            std::vector<cpp_server::utils::InferenceResult<float>> inference_results;
+            // Every image is written straight into its slot of one contiguous batch tensor.
+            const size_t image_size = 3 * static_cast<size_t>(preprocess_config.width) * preprocess_config.height;
+            cps_utils::TensorBuffer<float> array_float(batch * image_size);
+            std::vector<cpp_server::utils::Error> errors(batch);
+            if (!preprocess_pool || batch == 1)
+            {
+                for (int64_t i = 0; i < batch; ++i)
+                {
+                    errors[i] = preprocess_image(images[i], array_float.data() + i * image_size);
+                }
+            }
+            else
+            {
+                // Fiber-aware wait, the service thread keeps serving other requests meanwhile.
+                boost::fibers::mutex done_mutex;
+                boost::fibers::condition_variable done_cv;
+                int64_t remaining = batch;
+                for (int64_t i = 0; i < batch; ++i)
+                {
+                    preprocess_pool->submit([&, i]()
+                                            {
+                                                errors[i] = preprocess_image(images[i], array_float.data() + i * image_size);
+                                                std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+                                                --remaining;
+                                                done_cv.notify_all(); });
+                }
+                std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+                done_cv.wait(lock, [&remaining]()
+                             { return remaining == 0; });
+            }
+            for (const cpp_server::utils::Error &err : errors)
+            {
+                if (!err.IsOk())
+                {
+                    return err;
+                }
+            }
 
-            // ! NOTE: Change to move method
-            cpp_server::utils::InferenceData<float> input_data;
+            // Engines take at most max batch size images at once, larger requests are split into
+            // batches sent concurrently. Batches are views of the batch tensor, images are not copied.
+            const int64_t max_batch_size = infer_engine->modelConfig().max_batch_size_;
+            const int64_t batch_rows = max_batch_size > 0 ? std::min(max_batch_size, batch) : batch;
+            const size_t num_batches = (batch + batch_rows - 1) / batch_rows;
+            std::vector<std::vector<cpp_server::utils::InferenceData<float>>> inference_datas(num_batches);
             try
             {
-                input_data.data = array_float;
-                input_data.name = "input";
+                cpp_server::utils::InferenceData<float> input_data;
+                input_data.name = infer_engine->modelConfig().input_name_;
                 input_data.data_dtype = "FP32";
+                input_data.deadline = deadline;
                 input_data.shape = infer_engine->modelConfig().input_shape_;
-                inference_datas.push_back(input_data);
+                if (input_data.shape.size() >= 3)
+                {
+                    // Image dimensions replace variable-size dimensions of the model input.
+                    std::vector<int64_t> image_shape{3, preprocess_config.height, preprocess_config.width};
+                    if (preprocess_config.layout == cps_utils::TensorLayout::NHWC)
+                    {
+                        image_shape = {preprocess_config.height, preprocess_config.width, 3};
+                    }
+                    std::copy(image_shape.begin(), image_shape.end(), input_data.shape.end() - 3);
+                }
+                for (size_t k = 0; k < num_batches; ++k)
+                {
+                    const int64_t offset = k * batch_rows;
+                    const int64_t rows = std::min(batch_rows, batch - offset);
+                    input_data.data = array_float.slice(offset * image_size, rows * image_size);
+                    if (max_batch_size > 0 && !input_data.shape.empty())
+                    {
+                        // Images of the request form the batch, further batching is done by the inference engine.
+                        input_data.shape[0] = rows;
+                    }
+                    inference_datas[k].push_back(input_data);
+                }
             }
             catch (std::exception &ex)
             {
                 return cps_utils::Error(cps_utils::Error::Code::INTERNAL, ex.what());
             }
 
-            p_err = infer_engine->process(inference_datas, inference_results);
-            if (!p_err.IsOk())
+            // Fiber-aware wait for every batch, callbacks may run on the engine threads.
+            std::vector<cpp_server::utils::Error> batch_errors(num_batches);
+            std::vector<std::vector<cpp_server::utils::InferenceResult<float>>> batch_results(num_batches);
+            boost::fibers::mutex done_mutex;
+            boost::fibers::condition_variable done_cv;
+            size_t remaining = num_batches;
+            for (size_t k = 0; k < num_batches; ++k)
             {
-                return p_err;
+                cpp_server::utils::Error p_err = infer_engine->processAsync(
+                    inference_datas[k],
+                    [&, k](cpp_server::utils::Error err, std::vector<cpp_server::utils::InferenceResult<float>> &results)
+                    {
+                        batch_errors[k] = err;
+                        batch_results[k] = std::move(results);
+                        std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+                        --remaining;
+                        done_cv.notify_all();
+                    });
+                if (!p_err.IsOk())
+                {
+                    // The callback isn't invoked for a rejected batch.
+                    batch_errors[k] = p_err;
+                    std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+                    --remaining;
+                }
+            }
+            {
+                std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+                done_cv.wait(lock, [&remaining]()
+                             { return remaining == 0; });
+            }
+
+            std::vector<cpp_server::utils::InferenceResult<float>> inference_results;
+            for (size_t k = 0; k < num_batches; ++k)
+            {
+                if (!batch_errors[k].IsOk())
+                {
+                    return batch_errors[k];
+                }
+                std::move(batch_results[k].begin(), batch_results[k].end(), std::back_inserter(inference_results));
             }
 
             std::vector<cpp_server::utils::ClassificationResult> classification_output;
-            p_err = postprocess_classifaction(inference_results, classification_output);
+            cpp_server::utils::Error p_err = postprocess_classifaction(inference_results, classification_output);
             if (!p_err.IsOk())
             {
                 return p_err;
             }
 
-            result_doc.Parse("{\"results\":[]}");
+            // Built with the allocator of the document, no JSON text is parsed to create the result.
+            result_doc.SetObject();
+            rapidjson::Value results(rapidjson::kArrayType);
+            results.Reserve(classification_output.size(), result_doc.GetAllocator());
             for (cpp_server::utils::ClassificationResult &output : classification_output)
             {
                 rapidjson::Value obj(rapidjson::kObjectType);
                 obj.AddMember("score", output.score, result_doc.GetAllocator());
                 obj.AddMember("class", output.class_idx, result_doc.GetAllocator());
-                rapidjson::SetValueByPointer(result_doc, "/results/-", obj);
+                if (top_k > 1)
+                {
+                    rapidjson::Value top_classes(rapidjson::kArrayType);
+                    for (const std::pair<int, float> &item : output.top_classes)
+                    {
+                        rapidjson::Value top_class(rapidjson::kObjectType);
+                        top_class.AddMember("score", item.second, result_doc.GetAllocator());
+                        top_class.AddMember("class", item.first, result_doc.GetAllocator());
+                        top_classes.PushBack(top_class, result_doc.GetAllocator());
+                    }
+                    obj.AddMember("top_k", top_classes, result_doc.GetAllocator());
+                }
+                results.PushBack(obj, result_doc.GetAllocator());
             }
+            result_doc.AddMember("results", results, result_doc.GetAllocator());
 
             return cpp_server::utils::Error::Success;
         }
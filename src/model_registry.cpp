@@ -0,0 +1,351 @@
+#include "cpp_server/model_registry.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/// @brief List the subdirectories of a directory, hidden ones excluded.
+static bool list_directories(const std::string &path, std::vector<std::string> &names)
+{
+    DIR *dir = opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return false;
+    }
+    while (struct dirent *entry = readdir(dir))
+    {
+        std::string name(entry->d_name);
+        struct stat entry_stat;
+        if (name.empty() || name[0] == '.' || stat((path + "/" + name).c_str(), &entry_stat) != 0 || !S_ISDIR(entry_stat.st_mode))
+        {
+            continue;
+        }
+        names.push_back(name);
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+    return true;
+}
+
+/// @brief Get the last modification time of a path in nanoseconds, 0 if it doesn't exist.
+static int64_t modification_time(const std::string &path)
+{
+    struct stat path_stat;
+    if (stat(path.c_str(), &path_stat) != 0)
+    {
+        return 0;
+    }
+    return static_cast<int64_t>(path_stat.st_mtim.tv_sec) * 1000000000 + path_stat.st_mtim.tv_nsec;
+}
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        bool parse_model_version(const std::string &version, int64_t &number)
+        {
+            if (version.empty() || version.size() > 18 || !std::all_of(version.begin(), version.end(), [](const char &c)
+                                                                         { return c >= '0' && c <= '9'; }))
+            {
+                return false;
+            }
+            number = std::stoll(version);
+            return true;
+        }
+
+        cps_utils::Error ModelRegistry::scan(const std::string &repository, std::vector<ModelSpec> &specs)
+        {
+            std::vector<std::string> names;
+            if (!list_directories(repository, names))
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INVALID_DATA, "Unable to read model repository " + repository);
+            }
+
+            for (const std::string &name : names)
+            {
+                ModelSpec model;
+                model.name = name;
+                model.model_path = repository + "/" + name;
+
+                // Preprocessing is shared by the versions of a model.
+                std::string config_path = model.model_path + "/preprocess.json";
+                int64_t config_modified = modification_time(config_path);
+                if (config_modified > 0)
+                {
+                    cps_utils::Error p_err = cps_utils::load_preprocess_config(config_path, model.preprocess_config);
+                    if (!p_err.IsOk())
+                    {
+                        return p_err;
+                    }
+                }
+
+                std::vector<std::string> versions;
+                list_directories(model.model_path, versions);
+                std::vector<std::pair<int64_t, std::string>> numeric_versions;
+                for (const std::string &version : versions)
+                {
+                    int64_t number;
+                    if (parse_model_version(version, number))
+                    {
+                        numeric_versions.emplace_back(number, version);
+                    }
+                }
+                std::sort(numeric_versions.begin(), numeric_versions.end());
+                for (const std::pair<int64_t, std::string> &version : numeric_versions)
+                {
+                    ModelSpec spec = model;
+                    spec.version = version.second;
+                    spec.version_path = model.model_path + "/" + version.second;
+                    // Model files are replaced by renaming them into the version directory, which updates it.
+                    spec.modified = std::max(modification_time(spec.version_path), config_modified);
+                    spec.position = specs.size();
+                    specs.push_back(spec);
+                }
+            }
+            return cps_utils::Error::Success;
+        }
+
+        cps_utils::Error ModelRegistry::load(const std::string &repository, const ModelFactory &factory)
+        {
+            std::vector<ModelSpec> specs;
+            cps_utils::Error p_err = scan(repository, specs);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+
+            for (const ModelSpec &spec : specs)
+            {
+                std::unique_ptr<Processor> processor;
+                try
+                {
+                    processor = factory(spec);
+                }
+                catch (const std::exception &ex)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to load model " + spec.name + " version " + spec.version + ": " + ex.what());
+                }
+                if (!processor)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to load model " + spec.name + " version " + spec.version);
+                }
+                p_err = add(spec, processor);
+                if (!p_err.IsOk())
+                {
+                    return p_err;
+                }
+            }
+            return cps_utils::Error::Success;
+        }
+
+        cps_utils::Error ModelRegistry::reload(const std::string &repository, const ModelFactory &factory,
+                                               const WarmupFunction &warmup, const ReloadConfig &config)
+        {
+            std::unique_lock<std::mutex> lock(update_mutex);
+            std::vector<ModelSpec> specs;
+            cps_utils::Error p_err = scan(repository, specs);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+
+            std::shared_ptr<const Models> current = snapshot();
+            std::shared_ptr<Models> updated(new Models());
+            std::vector<Entry> retired;
+            cps_utils::Error result;
+            for (const ModelSpec &spec : specs)
+            {
+                int64_t version;
+                parse_model_version(spec.version, version);
+                const Entry *existing = nullptr;
+                Models::const_iterator model = current->find(spec.name);
+                if (model != current->end())
+                {
+                    std::map<int64_t, Entry>::const_iterator entry = model->second.find(version);
+                    existing = entry != model->second.end() ? &entry->second : nullptr;
+                }
+                if (existing && existing->spec.modified == spec.modified)
+                {
+                    (*updated)[spec.name][version] = *existing;
+                    continue;
+                }
+
+                // Built while the current version keeps serving requests.
+                std::unique_ptr<Processor> processor;
+                try
+                {
+                    processor = factory(spec);
+                    if (!processor)
+                    {
+                        p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to load model " + spec.name + " version " + spec.version);
+                    }
+                    else
+                    {
+                        p_err = warmup ? warmup(*processor, spec) : cps_utils::Error::Success;
+                    }
+                }
+                catch (const std::exception &ex)
+                {
+                    p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to load model " + spec.name + " version " + spec.version + ": " + ex.what());
+                }
+                if (!p_err.IsOk())
+                {
+                    std::cerr << p_err.AsString() << std::endl;
+                    result = p_err;
+                    if (existing)
+                    {
+                        (*updated)[spec.name][version] = *existing;
+                    }
+                    continue;
+                }
+
+                (*updated)[spec.name][version] = createEntry(spec, processor);
+                if (existing)
+                {
+                    retired.push_back(*existing);
+                }
+            }
+
+            // Versions gone from the repository.
+            for (const std::pair<const std::string, std::map<int64_t, Entry>> &model : *current)
+            {
+                for (const std::pair<const int64_t, Entry> &entry : model.second)
+                {
+                    Models::const_iterator updated_model = updated->find(model.first);
+                    if (updated_model == updated->end() || updated_model->second.count(entry.first) == 0)
+                    {
+                        retired.push_back(entry.second);
+                    }
+                }
+            }
+
+            std::atomic_store(&current_models, std::shared_ptr<const Models>(std::move(updated)));
+            current.reset();
+            // Replaced versions are out of the snapshot, updates no longer wait for their requests.
+            lock.unlock();
+            drain(retired, config);
+            return result;
+        }
+
+        cps_utils::Error ModelRegistry::add(const ModelSpec &spec, std::unique_ptr<Processor> &processor)
+        {
+            int64_t version;
+            if (!parse_model_version(spec.version, version))
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INVALID_DATA, "Model version must be a number: " + spec.version);
+            }
+            if (!processor)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INVALID_DATA, "Model " + spec.name + " has no processor");
+            }
+
+            std::lock_guard<std::mutex> lock(update_mutex);
+            std::shared_ptr<const Models> current = snapshot();
+            Models::const_iterator model = current->find(spec.name);
+            if (model != current->end() && model->second.count(version) > 0)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::ALREADY_EXISTS, "Model " + spec.name + " version " + spec.version + " is already registered");
+            }
+
+            std::shared_ptr<Models> updated(new Models(*current));
+            (*updated)[spec.name][version] = createEntry(spec, processor);
+            std::atomic_store(&current_models, std::shared_ptr<const Models>(std::move(updated)));
+            return cps_utils::Error::Success;
+        }
+
+        cps_utils::Error ModelRegistry::find(const std::string &name, const std::string &version, std::shared_ptr<Processor> &processor) const
+        {
+            std::shared_ptr<const Models> current = snapshot();
+            Models::const_iterator model = current->find(name);
+            if (model == current->end() || model->second.empty())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::NOT_FOUND, "Model " + name + " is not registered");
+            }
+            if (version.empty())
+            {
+                processor = model->second.rbegin()->second.processor;
+                return cps_utils::Error::Success;
+            }
+
+            int64_t number;
+            std::map<int64_t, Entry>::const_iterator entry;
+            if (!parse_model_version(version, number) || (entry = model->second.find(number)) == model->second.end())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::NOT_FOUND, "Model " + name + " has no version " + version);
+            }
+            processor = entry->second.processor;
+            return cps_utils::Error::Success;
+        }
+
+        std::vector<ModelSpec> ModelRegistry::models() const
+        {
+            std::vector<ModelSpec> specs;
+            for (const std::pair<const std::string, std::map<int64_t, Entry>> &model : *snapshot())
+            {
+                for (const std::pair<const int64_t, Entry> &entry : model.second)
+                {
+                    specs.push_back(entry.second.spec);
+                }
+            }
+            return specs;
+        }
+
+        size_t ModelRegistry::size() const
+        {
+            size_t count = 0;
+            for (const std::pair<const std::string, std::map<int64_t, Entry>> &model : *snapshot())
+            {
+                count += model.second.size();
+            }
+            return count;
+        }
+
+        std::shared_ptr<const ModelRegistry::Models> ModelRegistry::snapshot() const
+        {
+            return std::atomic_load(&current_models);
+        }
+
+        void ModelRegistry::Releaser::operator()(Processor * /*processor*/) const
+        {
+            {
+                std::lock_guard<std::mutex> lock(lifetime->mutex);
+                lifetime->released = true;
+            }
+            lifetime->released_cv.notify_all();
+        }
+
+        ModelRegistry::Entry ModelRegistry::createEntry(const ModelSpec &spec, std::unique_ptr<Processor> &processor)
+        {
+            Entry entry;
+            entry.spec = spec;
+            entry.lifetime = std::make_shared<Lifetime>();
+            entry.lifetime->processor = std::move(processor);
+            entry.processor = std::shared_ptr<Processor>(entry.lifetime->processor.get(), Releaser{entry.lifetime});
+            return entry;
+        }
+
+        void ModelRegistry::drain(std::vector<Entry> &retired, const ReloadConfig &config)
+        {
+            std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(config.drain_timeout_ms);
+            for (Entry &entry : retired)
+            {
+                // Requests in flight hold a handle, the last one to finish wakes us.
+                entry.processor.reset();
+                std::unique_lock<std::mutex> lock(entry.lifetime->mutex);
+                if (!entry.lifetime->released_cv.wait_until(lock, deadline, [&entry]()
+                                                            { return entry.lifetime->released; }))
+                {
+                    std::cerr << "Replaced model still in use after the drain timeout, freed by its last request" << std::endl;
+                    continue;
+                }
+                std::unique_ptr<Processor> processor = std::move(entry.lifetime->processor);
+                lock.unlock();
+                processor.reset();
+            }
+            retired.clear();
+        }
+    }
+}
@@ -0,0 +1,80 @@
+#include "cpp_server/model_watcher.hpp"
+
+#include <chrono>
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        ModelWatcher::ModelWatcher(ModelRegistry &registry, const std::string &repository, const ModelRegistry::ModelFactory &factory,
+                                   const ModelRegistry::WarmupFunction &warmup, const WatcherConfig &config)
+            : registry(registry), repository(repository), factory(factory), warmup(warmup), config(config)
+        {
+            thread = std::thread(&ModelWatcher::run, this);
+        }
+
+        ModelWatcher::~ModelWatcher()
+        {
+            {
+                std::unique_lock<std::mutex> lock(watcher_mutex);
+                stop = true;
+            }
+            watcher_cv.notify_all();
+            if (thread.joinable())
+            {
+                thread.join();
+            }
+        }
+
+        void ModelWatcher::trigger()
+        {
+            {
+                std::unique_lock<std::mutex> lock(watcher_mutex);
+                triggered = true;
+            }
+            watcher_cv.notify_all();
+        }
+
+        size_t ModelWatcher::reloads() const
+        {
+            std::unique_lock<std::mutex> lock(watcher_mutex);
+            return reload_count;
+        }
+
+        cps_utils::Error ModelWatcher::status() const
+        {
+            std::unique_lock<std::mutex> lock(watcher_mutex);
+            return reload_status;
+        }
+
+        void ModelWatcher::run()
+        {
+            std::unique_lock<std::mutex> lock(watcher_mutex);
+            while (!stop)
+            {
+                if (config.poll_interval_ms > 0)
+                {
+                    watcher_cv.wait_for(lock, std::chrono::milliseconds(config.poll_interval_ms), [this]()
+                                        { return stop || triggered; });
+                }
+                else
+                {
+                    watcher_cv.wait(lock, [this]()
+                                    { return stop || triggered; });
+                }
+                if (stop)
+                {
+                    break;
+                }
+                triggered = false;
+
+                // Unchanged versions are kept, a check without changes costs a scan of the repository.
+                lock.unlock();
+                cps_utils::Error p_err = registry.reload(repository, factory, warmup, config.reload_config);
+                lock.lock();
+                reload_count++;
+                reload_status = p_err;
+            }
+        }
+    }
+}
@@ -5,14 +5,88 @@ namespace cpp_server
     namespace inferencer
     {
         template <typename T>
-        ONNXRTEngine<T>::ONNXRTEngine(const std::string &model_path, const int &batch_size)
+        ONNXRTEngine<T>::ONNXRTEngine(const std::string &model_path, const int &batch_size, const int &num_workers)
+            : ONNXRTEngine(model_path, batch_size, ONNXRTConfig(), num_workers) {}
+
+        template <typename T>
+        ONNXRTEngine<T>::ONNXRTEngine(const std::string &model_path, const int &batch_size, const ONNXRTConfig &config, const int &num_workers)
         {
-            ort_runner.reset(new ORTRunner(model_path));
+            this->batch_size = batch_size;
+            thread_pool.reset(new cps_utils::ThreadPool(num_workers));
+            ort_runner.reset(new ORTRunner(model_path, config));
             if (ort_runner->isValid())
             {
-                model_configs = ort_runner->getModelConfigs();
-                this->model_config = model_configs[0];
-                this->status = true;
+                this->model_config = ort_runner->getModelConfig();
+                bool dynamic_batch = this->model_config.max_batch_size_ < 0;
+
+                // Tensors are bound as T buffers whose first dimension is the batch.
+                const std::string datatype = getONNXStrElementType(Ort::TypeToTensorType<T>::type);
+                std::vector<std::string> unsupported;
+                std::vector<cps_utils::TensorConfig *> tensors;
+                for (cps_utils::TensorConfig &input : this->model_config.inputs_)
+                {
+                    tensors.push_back(&input);
+                }
+                for (cps_utils::TensorConfig &output : this->model_config.outputs_)
+                {
+                    tensors.push_back(&output);
+                }
+                for (cps_utils::TensorConfig *tensor : tensors)
+                {
+                    // Outputs with a variable first dimension are allocated by ONNXRuntime and checked after the run.
+                    bool batched = !tensor->shape_.empty() && (tensor->shape_[0] < 0 || (!dynamic_batch && tensor->shape_[0] == this->model_config.max_batch_size_));
+                    if (!batched)
+                    {
+                        unsupported.push_back("Model tensor " + tensor->name_ + " has no batch dimension");
+                    }
+                    if (tensor->datatype_ != datatype)
+                    {
+                        unsupported.push_back("Model tensor " + tensor->name_ + " of type " + tensor->datatype_ + " doesn't match engine type " + datatype);
+                    }
+                    // Dynamic batch dimension is bounded by the desired batch size.
+                    if (dynamic_batch && !tensor->shape_.empty() && tensor->shape_[0] < 0)
+                    {
+                        tensor->shape_[0] = batch_size;
+                    }
+                    tensor->byte_size_ = 1;
+                    for (const int64_t &dim : tensor->shape_)
+                    {
+                        tensor->byte_size_ = dim < 0 || tensor->byte_size_ < 0 ? -1 : tensor->byte_size_ * dim;
+                    }
+                    if (tensor->byte_size_ > 0)
+                    {
+                        tensor->byte_size_ *= cps_utils::ElementStrTypeSize[tensor->datatype_];
+                    }
+                }
+                if (dynamic_batch)
+                {
+                    this->model_config.max_batch_size_ = batch_size;
+                }
+                this->model_config.syncFirstTensors();
+
+                // Dynamic batch is served by power of two buckets up to the batch size, so padding
+                // wastes at most half of a run. Static batch has a single bucket.
+                if (dynamic_batch)
+                {
+                    for (int64_t rows = 1; rows < batch_size; rows *= 2)
+                    {
+                        batch_buckets.push_back(rows);
+                    }
+                }
+                batch_buckets.push_back(std::max(this->model_config.max_batch_size_, 1));
+
+                for (const cps_utils::TensorConfig &input : this->model_config.inputs_)
+                {
+                    if (input.byte_size_ < 0)
+                    {
+                        unsupported.push_back("Variable-size dimension in model input " + input.name_);
+                    }
+                }
+                for (const std::string &message : unsupported)
+                {
+                    std::cerr << message << " is not supported" << std::endl;
+                }
+                this->status = unsupported.empty();
             }
             else
             {
@@ -20,79 +94,109 @@ namespace cpp_server
             }
         }
 
+        template <typename T>
+        int ONNXRTEngine<T>::inputIndex(const std::vector<cps_utils::InferenceData<T>> &infer_data, const size_t &i) const
+        {
+            // Inputs are matched by name, unnamed data follows the model input order.
+            return infer_data[i].name.empty() ? static_cast<int>(i) : this->model_config.inputIndex(infer_data[i].name);
+        }
+
         template <typename T>
         cps_utils::Error ONNXRTEngine<T>::validate(const std::vector<cps_utils::InferenceData<T>> &infer_data)
         {
-            if (infer_data.size() != this->batch_size)
+            const std::vector<cps_utils::TensorConfig> &inputs = this->model_config.inputs_;
+            if (infer_data.size() != inputs.size())
             {
-                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Number of data is different from batch size.");
+                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Number of data is different from number of model inputs.");
             }
 
             for(size_t i = 0; i < infer_data.size(); ++i)
             {
+                int index = inputIndex(infer_data, i);
+                bool duplicated = false;
+                for (size_t j = 0; j < i; ++j)
+                {
+                    duplicated = duplicated || inputIndex(infer_data, j) == index;
+                }
+                if (index < 0 || duplicated)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Unknown or duplicated model input " + infer_data[i].name);
+                }
+
+                if (infer_data[i].shape.empty() || infer_data[i].shape[0] < 1)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Data batch size must be positive.");
+                }
+                if (infer_data[i].shape[0] > this->model_config.max_batch_size_ || infer_data[i].shape[0] != infer_data[0].shape[0])
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Data batch size is larger than model batch size or differs between inputs.");
+                }
+
                 size_t data_byte_size = sizeof(T) * infer_data[i].data.size();
+                size_t row_byte_size = inputs[index].byte_size_ / std::max<int64_t>(inputs[index].shape_[0], 1);
 
-                if (data_byte_size > model_configs[i].input_byte_size_)
+                if (data_byte_size != infer_data[i].shape[0] * row_byte_size)
                 {
-                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Total data bytesize is different from allocated bytesize.");
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Total data bytesize is different from allocated bytesize for input " + inputs[index].name_);
                 }
             }
             return cps_utils::Error::Success;
         }
 
         template <typename T>
-        cps_utils::Error ONNXRTEngine<T>::process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
+        cps_utils::Error ONNXRTEngine<T>::createSlot(const int64_t &rows, std::unique_ptr<BindingSlot> &slot)
         {
-            cps_utils::Error p_err;
-            p_err = validate(infer_data);
+            slot.reset(new BindingSlot());
+            slot->rows = rows;
+
+            cps_utils::Error p_err = ort_runner->createIoBinding(slot->binding);
             if (!p_err.IsOk())
             {
                 return p_err;
             }
 
-            std::vector<Ort::Value> inputTensors_;
-            std::vector<Ort::Value> outputTensors_;
             try
             {
-                Ort::MemoryInfo memoryInfo = Ort::MemoryInfo::CreateCpu(
-                    OrtAllocatorType::OrtArenaAllocator, OrtMemType::OrtMemTypeDefault);
+                Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(
+                    OrtAllocatorType::OrtDeviceAllocator, OrtMemType::OrtMemTypeDefault);
 
-                for(size_t i = 0; i < infer_data.size(); ++i)
+                for (const cps_utils::TensorConfig &input : this->model_config.inputs_)
                 {
-                    inputTensors_.push_back(
+                    std::vector<int64_t> input_shape = input.shape_;
+                    input_shape[0] = rows;
+                    slot->inputs.push_back(cps_utils::TensorBuffer<T>(cps_utils::vectorProduct(input_shape)));
+                    slot->input_values.push_back(
                         Ort::Value::CreateTensor<T>(
-                            memoryInfo,
-                            const_cast<T*>(infer_data[i].data.data()),
-                            cps_utils::vectorProduct(infer_data[i].shape)  * cps_utils::ElementStrTypeSize[infer_data[i].data_dtype],
-                            infer_data[i].shape.data(),
-                            infer_data[i].shape.size()
-                        )
-                    );
-                }
-
-                {
-                    std::vector<T> output_data(cps_utils::vectorProduct(model_configs[0].output_shape_));
-                    infer_results.push_back(
-                        cps_utils::InferenceResult<T>{
-                            output_data,
-                            "FP32",
-                            model_configs[0].output_shape_,
-                            model_configs[0].output_name_,
-                            static_cast<uint64_t>(model_configs[0].output_byte_size_),
-                            false
-                        }
-                    );
+                            memory_info,
+                            slot->inputs.back().data(),
+                            slot->inputs.back().size(),
+                            input_shape.data(),
+                            input_shape.size()));
+                    slot->binding->BindInput(input.name_.c_str(), slot->input_values.back());
+                }
 
-                    // TODO: Find a way to initialize with multiple inputs/outputs
-                    outputTensors_.push_back(
+                for (const cps_utils::TensorConfig &output : this->model_config.outputs_)
+                {
+                    if (output.byte_size_ < 0)
+                    {
+                        // Shape is only known after the run, ONNXRuntime allocates the output.
+                        slot->outputs.push_back(cps_utils::TensorBuffer<T>());
+                        slot->output_values.push_back(Ort::Value(nullptr));
+                        slot->binding->BindOutput(output.name_.c_str(), memory_info);
+                        continue;
+                    }
+
+                    std::vector<int64_t> output_shape = output.shape_;
+                    output_shape[0] = rows;
+                    slot->outputs.push_back(cps_utils::TensorBuffer<T>(cps_utils::vectorProduct(output_shape)));
+                    slot->output_values.push_back(
                         Ort::Value::CreateTensor<T>(
-                        memoryInfo,
-                        infer_results[0].data.data(),
-                        infer_results[0].byte_size,
-                        infer_results[0].shape.data(),
-                        infer_results[0].shape.size()
-                        )
-                    );
+                            memory_info,
+                            slot->outputs.back().data(),
+                            slot->outputs.back().size(),
+                            output_shape.data(),
+                            output_shape.size()));
+                    slot->binding->BindOutput(output.name_.c_str(), slot->output_values.back());
                 }
             }
             catch (const std::exception &ex)
@@ -102,26 +206,166 @@ namespace cpp_server
                     std::string("Failed to initialize OrtTensor: ") + std::string(ex.what())
                 );
             }
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        cps_utils::Error ONNXRTEngine<T>::acquireSlot(const int64_t &rows, BindingSlot *&slot)
+        {
+            std::vector<int64_t>::const_iterator bucket = std::lower_bound(batch_buckets.begin(), batch_buckets.end(), rows);
+            if (bucket == batch_buckets.end())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Data batch size is larger than model batch size.");
+            }
+
+            std::lock_guard<std::mutex> lock(slots_mutex);
+            std::vector<std::unique_ptr<BindingSlot>> &slots = binding_slots[*bucket];
+            for (std::unique_ptr<BindingSlot> &candidate : slots)
+            {
+                bool idle = !candidate->busy;
+                for (const cps_utils::TensorBuffer<T> &output : candidate->outputs)
+                {
+                    idle = idle && output.use_count() <= 1;
+                }
+                if (idle)
+                {
+                    candidate->busy = true;
+                    slot = candidate.get();
+                    return cps_utils::Error::Success;
+                }
+            }
+
+            // Every slot is running or its results are still held, allocate another one.
+            std::unique_ptr<BindingSlot> new_slot;
+            cps_utils::Error p_err = createSlot(*bucket, new_slot);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+            new_slot->busy = true;
+            slot = new_slot.get();
+            slots.push_back(std::move(new_slot));
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        void ONNXRTEngine<T>::releaseSlot(BindingSlot *slot)
+        {
+            std::lock_guard<std::mutex> lock(slots_mutex);
+            slot->busy = false;
+        }
+
+        template <typename T>
+        cps_utils::Error ONNXRTEngine<T>::process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
+        {
+            cps_utils::Error p_err = validate(infer_data);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+            // Requests that expired while queued on the engine workers are dropped before running.
+            if (std::chrono::steady_clock::now() >= infer_data[0].deadline)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::DEADLINE_EXCEEDED, "Request deadline passed before inference");
+            }
+
+            // Results of a previous call are replaced, releasing their buffers lets their slot run this call.
+            for (cps_utils::InferenceResult<T> &result : infer_results)
+            {
+                result.data = cps_utils::TensorBuffer<T>();
+            }
+
+            const int64_t rows = infer_data[0].shape[0];
+            BindingSlot *slot = nullptr;
+            p_err = acquireSlot(rows, slot);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+
+            // Rows past the request in a larger bucket keep stale data, their outputs are not returned.
+            for (size_t i = 0; i < infer_data.size(); ++i)
+            {
+                std::copy(infer_data[i].data.begin(), infer_data[i].data.end(), slot->inputs[inputIndex(infer_data, i)].data());
+            }
+
+            p_err = ort_runner->process(*slot->binding);
+            if (!p_err.IsOk())
+            {
+                releaseSlot(slot);
+                return p_err;
+            }
 
             try
             {
-                p_err = ort_runner->process(inputTensors_, outputTensors_);
-                if (!p_err.IsOk())
+                // Entries of a results vector reused across calls keep their capacity, so the steady
+                // state doesn't allocate. ONNXRuntime-allocated outputs are new values on every run.
+                infer_results.resize(this->model_config.outputs_.size());
+                std::vector<Ort::Value> allocated_values;
+                for (size_t o = 0; o < this->model_config.outputs_.size(); ++o)
                 {
-                    return p_err;
+                    const cps_utils::TensorConfig &output = this->model_config.outputs_[o];
+                    cps_utils::InferenceResult<T> &result = infer_results[o];
+                    if (output.byte_size_ < 0)
+                    {
+                        // Output allocated by ONNXRuntime, the buffer shares ownership of its value.
+                        if (allocated_values.empty())
+                        {
+                            allocated_values = slot->binding->GetOutputValues();
+                        }
+                        std::shared_ptr<Ort::Value> value(new Ort::Value(std::move(allocated_values[o])));
+                        result.shape = value->GetTensorTypeAndShapeInfo().GetShape();
+                        result.data = cps_utils::TensorBuffer<T>(value, value->GetTensorMutableData<T>(), value->GetTensorTypeAndShapeInfo().GetElementCount());
+                        // Output covers every row of the bucket, rows past the request are dropped.
+                        if (!result.shape.empty() && result.shape[0] == slot->rows)
+                        {
+                            result.shape[0] = rows;
+                            result.data = result.data.slice(0, result.data.size() / slot->rows * rows);
+                        }
+                    }
+                    else
+                    {
+                        // Results share the slot output buffer, the slot is reused once they are released.
+                        result.shape.assign(output.shape_.begin(), output.shape_.end());
+                        result.shape[0] = rows;
+                        result.data = slot->outputs[o].slice(0, slot->outputs[o].size() / slot->rows * rows);
+                    }
+                    result.data_dtype = output.datatype_;
+                    result.name = output.name_;
+                    result.byte_size = sizeof(T) * result.data.size();
+                    result.status = true;
                 }
-                infer_results[0].status = true;
             }
             catch (const std::exception &ex)
             {
+                releaseSlot(slot);
                 return cpp_server::utils::Error(
                     cpp_server::utils::Error::Code::INTERNAL,
-                    std::string("Failed to inference data: ") + std::string(ex.what())
+                    std::string("Failed to read inference outputs: ") + std::string(ex.what())
                 );
             }
+            releaseSlot(slot);
 
             return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        cps_utils::Error ONNXRTEngine<T>::processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback)
+        {
+            if (!this->status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "ONNXRT session is not initialized");
+            }
 
+            // ORT sessions are safe to run concurrently, each worker runs a full process call.
+            thread_pool->submit(
+                [this, &infer_data, callback]()
+                {
+                    std::vector<cps_utils::InferenceResult<T>> infer_results;
+                    cps_utils::Error p_err = process(infer_data, infer_results);
+                    callback(p_err, infer_results);
+                });
+            return cps_utils::Error::Success;
         }
     }
 }
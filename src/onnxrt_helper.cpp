@@ -1,14 +1,103 @@
 #include "cpp_server/onnxrt_helper.hpp"
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "cpp_server/utils/simd.hpp"
+
+namespace
+{
+    // ONNXRuntime keeps a single environment per process, global thread pools can only be
+    // requested by whoever creates it.
+    std::mutex env_mutex;
+    std::weak_ptr<Ort::Env> shared_env;
+    bool shared_env_global_pool = false;
+
+    /// @brief FNV-1a hash, chained through seed.
+    uint64_t fnv1a(const char *data, const size_t &size, uint64_t seed = 14695981039346656037ULL)
+    {
+        for (size_t i = 0; i < size; ++i)
+        {
+            seed ^= static_cast<unsigned char>(data[i]);
+            seed *= 1099511628211ULL;
+        }
+        return seed;
+    }
+
+    /// @brief Byte size of a tensor, -1 when the shape has variable-size dimensions.
+    int64_t getByteSize(const cps_utils::TensorConfig &tensor)
+    {
+        for (const int64_t &dim : tensor.shape_)
+        {
+            if (dim < 0)
+            {
+                return -1;
+            }
+        }
+        return cps_utils::vectorProduct(tensor.shape_) * cps_utils::ElementStrTypeSize[tensor.datatype_];
+    }
+
+    /// @brief Build the optimized model cache path for a model and configuration.
+    cps_utils::Error cachedModelPath(const std::string &model_path, const cpp_server::inferencer::ONNXRTConfig &config, std::string &cache_path)
+    {
+        std::ifstream file(model_path, std::ios::binary);
+        if (!file)
+        {
+            return cps_utils::Error(cps_utils::Error::Code::INVALID_DATA, "Unable to read model " + model_path);
+        }
+        uint64_t model_hash = fnv1a(nullptr, 0);
+        std::vector<char> chunk(1 << 20);
+        while (file.read(chunk.data(), chunk.size()) || file.gcount() > 0)
+        {
+            model_hash = fnv1a(chunk.data(), file.gcount(), model_hash);
+        }
+
+        // Only options changing the optimized graph are part of the key. Layout optimizations of
+        // ORT_ENABLE_ALL depend on the CPU, so the SIMD level is included as well.
+        std::string options = std::string(OrtGetApiBase()->GetVersionString()) +
+                              ";opt=" + std::to_string(config.graph_optimization_level) +
+                              ";exec=" + std::to_string(config.execution_mode) +
+                              ";simd=" + cps_utils::simdLevelName(cps_utils::detectSimdLevel());
+        uint64_t options_hash = fnv1a(options.data(), options.size());
+
+        char key[34];
+        std::snprintf(key, sizeof(key), "%016" PRIx64 "%016" PRIx64, model_hash, options_hash);
+        cache_path = config.optimized_model_cache_dir + "/" + key + ".ort";
+        return cps_utils::Error::Success;
+    }
+}
 
 namespace cpp_server
 {
     namespace inferencer
     {
-        ORTRunner::ORTRunner(const std::string &model_path)
+        ORTRunner::ORTRunner(const std::string &model_path, const ONNXRTConfig &config)
         {
-            session_.reset(new Ort::Session(env_, model_path.c_str(), Ort::SessionOptions{nullptr}));
-
             cps_utils::Error p_err;
+            p_err = acquireEnv(config);
+            if (!p_err.IsOk())
+            {
+                std::cerr << p_err.AsString() << std::endl;
+                return;
+            }
+
+            if (config.optimized_model_cache_dir.empty())
+            {
+                Ort::SessionOptions options = createSessionOptions(config);
+                p_err = createSession(model_path, config, options);
+            }
+            else
+            {
+                p_err = createCachedSession(model_path, config);
+            }
+            if (!p_err.IsOk())
+            {
+                std::cerr << p_err.AsString() << std::endl;
+                return;
+            }
+
             p_err = readModelConfigs();
             if (!p_err.IsOk())
             {
@@ -17,31 +106,189 @@ namespace cpp_server
 
         }
 
+        cps_utils::Error ORTRunner::acquireEnv(const ONNXRTConfig &config)
+        {
+            std::lock_guard<std::mutex> lock(env_mutex);
+            env_ = shared_env.lock();
+            if (env_)
+            {
+                if (config.use_global_thread_pool && !shared_env_global_pool)
+                {
+                    env_.reset();
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR,
+                                            "ONNXRT environment is already created without global thread pools");
+                }
+                return cps_utils::Error::Success;
+            }
+
+            try
+            {
+                if (config.use_global_thread_pool)
+                {
+                    Ort::ThreadingOptions threading_options;
+                    threading_options.SetGlobalIntraOpNumThreads(config.intra_op_num_threads);
+                    threading_options.SetGlobalInterOpNumThreads(config.inter_op_num_threads);
+                    env_ = std::make_shared<Ort::Env>(threading_options, ORT_LOGGING_LEVEL_WARNING, "cpp-server");
+                }
+                else
+                {
+                    env_ = std::make_shared<Ort::Env>(ORT_LOGGING_LEVEL_WARNING, "cpp-server");
+                }
+            }
+            catch (const std::exception &ex)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to create ONNXRT environment, " + std::string(ex.what()));
+            }
+            shared_env = env_;
+            shared_env_global_pool = config.use_global_thread_pool;
+            return cps_utils::Error::Success;
+        }
+
+        Ort::SessionOptions ORTRunner::createSessionOptions(const ONNXRTConfig &config)
+        {
+            Ort::SessionOptions options;
+            if (config.use_global_thread_pool)
+            {
+                // Thread counts are set on the environment instead.
+                options.DisablePerSessionThreads();
+            }
+            else
+            {
+                if (config.intra_op_num_threads > 0)
+                {
+                    options.SetIntraOpNumThreads(config.intra_op_num_threads);
+                }
+                if (config.inter_op_num_threads > 0)
+                {
+                    options.SetInterOpNumThreads(config.inter_op_num_threads);
+                }
+            }
+            options.SetGraphOptimizationLevel(config.graph_optimization_level);
+            options.SetExecutionMode(config.execution_mode);
+            if (config.enable_mem_pattern)
+            {
+                options.EnableMemPattern();
+            }
+            else
+            {
+                options.DisableMemPattern();
+            }
+            if (config.enable_cpu_mem_arena)
+            {
+                options.EnableCpuMemArena();
+            }
+            else
+            {
+                options.DisableCpuMemArena();
+            }
+            return options;
+        }
+
+        cps_utils::Error ORTRunner::createSession(const std::string &model_path, const ONNXRTConfig &config, Ort::SessionOptions &options)
+        {
+            // Session may reference the previous mapping, release it first.
+            session_.reset(nullptr);
+            model_file_.reset(nullptr);
+            try
+            {
+                if (!config.mmap_model)
+                {
+                    session_.reset(new Ort::Session(*env_, model_path.c_str(), options));
+                    return cps_utils::Error::Success;
+                }
+
+                model_file_.reset(new cps_utils::MappedFile(model_path));
+                if (!model_file_->isValid())
+                {
+                    model_file_.reset(nullptr);
+                    return cps_utils::Error(cps_utils::Error::Code::INVALID_DATA, "Unable to map model " + model_path);
+                }
+
+                // ORT format models carry the "ORTM" flatbuffer identifier. Their initializers can point
+                // into the mapping, so weights stay in shared page cache instead of the process heap.
+                const char *bytes = static_cast<const char *>(model_file_->data());
+                if (model_file_->size() > 8 && std::memcmp(bytes + 4, "ORTM", 4) == 0)
+                {
+                    options.AddConfigEntry("session.load_model_format", "ORT");
+                    options.AddConfigEntry("session.use_ort_model_bytes_directly", "1");
+                    options.AddConfigEntry("session.use_ort_model_bytes_for_initializers", "1");
+                }
+                session_.reset(new Ort::Session(*env_, model_file_->data(), model_file_->size(), options));
+            }
+            catch (const std::exception &ex)
+            {
+                session_.reset(nullptr);
+                model_file_.reset(nullptr);
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to create ONNXRT session, " + std::string(ex.what()));
+            }
+            return cps_utils::Error::Success;
+        }
+
+        cps_utils::Error ORTRunner::createCachedSession(const std::string &model_path, const ONNXRTConfig &config)
+        {
+            std::string cache_path;
+            cps_utils::Error p_err = cachedModelPath(model_path, config, cache_path);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+
+            struct stat cache_stat;
+            if (stat(cache_path.c_str(), &cache_stat) == 0)
+            {
+                // Cached model is already optimized, only load it.
+                Ort::SessionOptions options = createSessionOptions(config);
+                options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_DISABLE_ALL);
+                options.AddConfigEntry("session.load_model_format", "ORT");
+                p_err = createSession(cache_path, config, options);
+                if (p_err.IsOk())
+                {
+                    return p_err;
+                }
+                std::cerr << "Ignoring invalid optimized model " << cache_path << ", " << p_err.Message() << std::endl;
+            }
+
+            if (mkdir(config.optimized_model_cache_dir.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                std::cerr << "Unable to create model cache directory " << config.optimized_model_cache_dir << std::endl;
+                Ort::SessionOptions options = createSessionOptions(config);
+                return createSession(model_path, config, options);
+            }
+
+            // Written under a temporary name, so concurrent replicas never load a partial model.
+            std::string tmp_path = cache_path + ".tmp" + std::to_string(getpid());
+            Ort::SessionOptions options = createSessionOptions(config);
+            options.SetOptimizedModelFilePath(tmp_path.c_str());
+            options.AddConfigEntry("session.save_model_format", "ORT");
+            p_err = createSession(model_path, config, options);
+            if (p_err.IsOk() && std::rename(tmp_path.c_str(), cache_path.c_str()) != 0)
+            {
+                std::cerr << "Unable to store optimized model " << cache_path << std::endl;
+            }
+            std::remove(tmp_path.c_str());
+            return p_err;
+        }
+
         cps_utils::Error ORTRunner::readModelConfigs()
         {
             Ort::AllocatorWithDefaultOptions allocator;
+            model_config_ = cps_utils::ModelConfig();
 
             try
             {
                 for(size_t i = 0; i < session_->GetInputCount(); ++i)
                 {
-                    cps_utils::ModelConfig config_;
-                    auto inputNodeName = session_->GetInputNameAllocated(0, allocator);
-                    config_.input_name_ = std::string(inputNodeName.get());
+                    cps_utils::TensorConfig input;
+                    auto inputNodeName = session_->GetInputNameAllocated(i, allocator);
+                    input.name_ = std::string(inputNodeName.get());
 
-                    Ort::TypeInfo inputTypeInfo = session_->GetInputTypeInfo(0);
+                    Ort::TypeInfo inputTypeInfo = session_->GetInputTypeInfo(i);
                     auto inputTensorInfo = inputTypeInfo.GetTensorTypeAndShapeInfo();
-                    config_.input_shape_ = inputTensorInfo.GetShape();
-                    config_.max_batch_size_ = config_.input_shape_[0];
-                    config_.channel_first_ = config_.input_shape_[1] == 3 ? true : false;
-
-                    ONNXTensorElementDataType inputType = inputTensorInfo.GetElementType();
-                    config_.input_datatype_ = getONNXStrElementType(inputType);
-                    config_.input_byte_size_ = cps_utils::vectorProduct(config_.input_shape_) * cps_utils::ElementStrTypeSize[config_.input_datatype_];
-
-                    model_configs_.push_back(config_);
-                    input_node_names_.push_back(model_configs_[i].input_name_.c_str());
-
+                    input.shape_ = inputTensorInfo.GetShape();
+                    input.datatype_ = getONNXStrElementType(inputTensorInfo.GetElementType());
+                    input.format_ = input.shape_.size() == 4 && input.shape_[1] == 3 ? "FORMAT_NCHW" : "FORMAT_NONE";
+                    input.byte_size_ = getByteSize(input);
+                    model_config_.inputs_.push_back(input);
                 }
             }
             catch (std::exception &ex)
@@ -53,18 +300,16 @@ namespace cpp_server
             {
                 for(size_t i = 0; i < session_->GetOutputCount(); ++i)
                 {
-                    auto outputNodeName = session_->GetOutputNameAllocated(0, allocator);
-                    model_configs_[i].output_name_ = std::string(outputNodeName.get());
-                    output_node_names_.push_back(model_configs_[i].output_name_.c_str());
+                    cps_utils::TensorConfig output;
+                    auto outputNodeName = session_->GetOutputNameAllocated(i, allocator);
+                    output.name_ = std::string(outputNodeName.get());
 
-                    Ort::TypeInfo outputTypeInfo = session_->GetOutputTypeInfo(0);
+                    Ort::TypeInfo outputTypeInfo = session_->GetOutputTypeInfo(i);
                     auto outputTensorInfo = outputTypeInfo.GetTensorTypeAndShapeInfo();
-
-                    model_configs_[i].output_shape_ = outputTensorInfo.GetShape();
-
-                    ONNXTensorElementDataType outputType = outputTensorInfo.GetElementType();
-                    model_configs_[i].output_datatype_ = getONNXStrElementType(outputType);
-                    model_configs_[i].output_byte_size_ = cps_utils::vectorProduct(model_configs_[i].output_shape_) * cps_utils::ElementStrTypeSize[model_configs_[i].input_datatype_];
+                    output.shape_ = outputTensorInfo.GetShape();
+                    output.datatype_ = getONNXStrElementType(outputTensorInfo.GetElementType());
+                    output.byte_size_ = getByteSize(output);
+                    model_config_.outputs_.push_back(output);
                 }
             }
             catch (std::exception &ex)
@@ -72,6 +317,28 @@ namespace cpp_server
                 return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to read model output metadata, " + std::string(ex.what()));
             }
 
+            if (model_config_.inputs_.empty() || model_config_.outputs_.empty())
+            {
+                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Model has no inputs or outputs");
+            }
+
+            // Names are stored first, so the pointers don't move.
+            input_node_names_.clear();
+            output_node_names_.clear();
+            for (const cps_utils::TensorConfig &input : model_config_.inputs_)
+            {
+                input_node_names_.push_back(input.name_.c_str());
+            }
+            for (const cps_utils::TensorConfig &output : model_config_.outputs_)
+            {
+                output_node_names_.push_back(output.name_.c_str());
+            }
+
+            const std::vector<int64_t> &first_shape = model_config_.inputs_[0].shape_;
+            model_config_.max_batch_size_ = first_shape.empty() ? 0 : first_shape[0];
+            model_config_.channel_first_ = model_config_.inputs_[0].format_ == "FORMAT_NCHW";
+            model_config_.syncFirstTensors();
+
             return cps_utils::Error::Success;
         }
 
@@ -93,5 +360,42 @@ namespace cpp_server
 
             return cps_utils::Error::Success;
         }
+
+        cps_utils::Error ORTRunner::createIoBinding(std::unique_ptr<Ort::IoBinding> &binding)
+        {
+            if (!session_)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "ONNXRT session is not initialized");
+            }
+
+            try
+            {
+                binding.reset(new Ort::IoBinding(*session_));
+            }
+            catch (const std::exception &ex)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to create IO binding, " + std::string(ex.what()));
+            }
+            return cps_utils::Error::Success;
+        }
+
+        cps_utils::Error ORTRunner::process(Ort::IoBinding &binding)
+        {
+            if (!session_)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "ONNXRT session is not initialized");
+            }
+
+            try
+            {
+                session_->Run(run_options_, binding);
+            }
+            catch (const std::exception& ex)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, std::string(ex.what()));
+            }
+
+            return cps_utils::Error::Success;
+        }
     }
 } // namespace cpp_server
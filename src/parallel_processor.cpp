@@ -0,0 +1,206 @@
+#include "cpp_server/parallel_processor.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+#include <boost/fiber/operations.hpp>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static void pin_thread(const int &core)
+{
+#if defined(__linux__)
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset) != 0)
+    {
+        std::cerr << "Unable to pin worker thread to core " << core << std::endl;
+    }
+#endif
+}
+
+namespace cpp_server
+{
+    namespace processor
+    {
+        ParallelProcessor::ParallelProcessor(const ProcessorFactory &factory, const WorkerConfig &config)
+        {
+            size_t num_cores = std::thread::hardware_concurrency();
+            size_t num_workers = config.num_workers > 0 ? config.num_workers : std::max<size_t>(num_cores, 1);
+
+            workers.reserve(num_workers);
+            for (size_t i = 0; i < num_workers; ++i)
+            {
+                workers.emplace_back(new Worker());
+            }
+            for (size_t i = 0; i < num_workers; ++i)
+            {
+                int core = config.pin_workers && num_cores > 0 ? static_cast<int>((config.first_core + i) % num_cores) : -1;
+                workers[i]->thread = std::thread(&ParallelProcessor::run, this, std::ref(*workers[i]), i, std::cref(factory), core);
+            }
+
+            // The factory is only referenced until every worker created its processor.
+            std::unique_lock<boost::fibers::mutex> lock(start_mutex);
+            start_cv.wait(lock, [this, num_workers]()
+                          { return started == num_workers; });
+            status = true;
+            for (const std::unique_ptr<Worker> &worker : workers)
+            {
+                status = status && worker->processor;
+            }
+        }
+
+        ParallelProcessor::~ParallelProcessor()
+        {
+            stop = true;
+            for (std::unique_ptr<Worker> &worker : workers)
+            {
+                {
+                    std::unique_lock<boost::fibers::mutex> lock(worker->tasks_mutex);
+                }
+                worker->tasks_cv.notify_all();
+            }
+            for (std::unique_ptr<Worker> &worker : workers)
+            {
+                if (worker->thread.joinable())
+                {
+                    worker->thread.join();
+                }
+            }
+        }
+
+        cps_utils::Error ParallelProcessor::process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                                                    const cps_utils::Deadline &deadline)
+        {
+            return dispatch([&data_doc, &result_doc, &deadline](Processor &processor)
+                            { return processor.process(data_doc, result_doc, deadline); },
+                            deadline);
+        }
+
+        cps_utils::Error ParallelProcessor::process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                                                    const cps_utils::Deadline &deadline)
+        {
+            return dispatch([data, &size, &result_doc, &deadline](Processor &processor)
+                            { return processor.process(data, size, result_doc, deadline); },
+                            deadline);
+        }
+
+        void ParallelProcessor::run(Worker &worker, const size_t &worker_id, const ProcessorFactory &factory, const int &core)
+        {
+            if (core >= 0)
+            {
+                pin_thread(core);
+            }
+
+            // Created on the worker thread, so engine memory is first touched from the core using it.
+            std::unique_ptr<Processor> processor;
+            try
+            {
+                processor = factory(worker_id);
+            }
+            catch (const std::exception &ex)
+            {
+                std::cerr << "Unable to create processor of worker " << worker_id << ": " << ex.what() << std::endl;
+            }
+            {
+                std::unique_lock<boost::fibers::mutex> lock(start_mutex);
+                worker.processor = std::move(processor);
+                started++;
+            }
+            start_cv.notify_all();
+
+            while (true)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<boost::fibers::mutex> lock(worker.tasks_mutex);
+                    worker.tasks_cv.wait(lock, [this, &worker]()
+                                         { return stop || !worker.tasks.empty(); });
+                    if (worker.tasks.empty())
+                    {
+                        // Stopped, requests still running on fibers of this thread finish first.
+                        worker.tasks_cv.wait(lock, [&worker]()
+                                             { return worker.load == 0; });
+                        break;
+                    }
+                    task = std::move(worker.tasks.front());
+                    worker.tasks.pop_front();
+                }
+                boost::fibers::fiber(std::move(task)).detach();
+            }
+            worker.processor.reset();
+        }
+
+        cps_utils::Error ParallelProcessor::dispatch(const std::function<cps_utils::Error(Processor &)> &function, const cps_utils::Deadline &deadline)
+        {
+            if (!status)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Parallel processor is not initialized");
+            }
+
+            // Least loaded worker, the search starts at a rotating index so idle workers take turns.
+            size_t start = next_worker++;
+            Worker *worker = workers[start % workers.size()].get();
+            for (size_t i = 1; i < workers.size(); ++i)
+            {
+                Worker *other = workers[(start + i) % workers.size()].get();
+                if (other->load < worker->load)
+                {
+                    worker = other;
+                }
+            }
+
+            cps_utils::Error p_err;
+            bool done = false;
+            boost::fibers::mutex done_mutex;
+            boost::fibers::condition_variable done_cv;
+            {
+                std::unique_lock<boost::fibers::mutex> lock(worker->tasks_mutex);
+                if (stop)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "Parallel processor is stopped");
+                }
+                worker->load++;
+                worker->tasks.push_back([&, worker]()
+                                        {
+                                            cps_utils::Error err;
+                                            try
+                                            {
+                                                // Requests that expired while queued on a busy worker are dropped.
+                                                if (std::chrono::steady_clock::now() >= deadline)
+                                                {
+                                                    err = cps_utils::Error(cps_utils::Error::Code::DEADLINE_EXCEEDED, "Request deadline passed while queued on a worker");
+                                                }
+                                                else
+                                                {
+                                                    err = function(*worker->processor);
+                                                }
+                                            }
+                                            catch (const std::exception &ex)
+                                            {
+                                                err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, ex.what());
+                                            }
+                                            {
+                                                std::unique_lock<boost::fibers::mutex> done_lock(done_mutex);
+                                                p_err = err;
+                                                done = true;
+                                                done_cv.notify_all();
+                                            }
+                                            // The caller may have returned, only the worker is used from here.
+                                            std::unique_lock<boost::fibers::mutex> tasks_lock(worker->tasks_mutex);
+                                            worker->load--;
+                                            worker->tasks_cv.notify_all(); });
+            }
+            worker->tasks_cv.notify_all();
+
+            std::unique_lock<boost::fibers::mutex> lock(done_mutex);
+            done_cv.wait(lock, [&done]()
+                         { return done; });
+            return p_err;
+        }
+    }
+}
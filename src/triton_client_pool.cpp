@@ -0,0 +1,313 @@
+#include "cpp_server/triton_client_pool.hpp"
+
+namespace cpp_server
+{
+    namespace inferencer
+    {
+        TritonClientPool::TritonClientPool(const ClientConfig &client_config)
+            : client_config_(client_config)
+        {
+            std::vector<std::string> urls = client_config.urls;
+            if (urls.empty())
+            {
+                urls.push_back(client_config.url);
+            }
+            int connections_per_endpoint = std::max(client_config.connections_per_endpoint, 1);
+
+            for (const std::string &url : urls)
+            {
+                std::unique_ptr<Endpoint> endpoint(new Endpoint());
+                endpoint->url = url;
+                for (int c = 0; c < connections_per_endpoint; ++c)
+                {
+                    std::unique_ptr<TritonConnection> connection(new TritonConnection());
+                    connection->protocol = client_config.protocol;
+                    connection->endpoint = endpoints_.size();
+
+                    tc::Error tc_err;
+                    if (client_config.protocol == ProtocolType::HTTP)
+                    {
+                        tc_err = tc::InferenceServerHttpClient::Create(
+                            &connection->client.http_client_, url, client_config.verbose);
+                    }
+                    else
+                    {
+                        tc_err = tc::InferenceServerGrpcClient::Create(
+                            &connection->client.grpc_client_, url, client_config.verbose);
+                    }
+                    if (!tc_err.IsOk())
+                    {
+                        std::cerr << "Unable to create client for " << url << ": " << tc_err.Message() << std::endl;
+                        return;
+                    }
+                    endpoint->connections.push_back(std::move(connection));
+                }
+                endpoints_.push_back(std::move(endpoint));
+            }
+
+            if (client_config.use_streaming)
+            {
+                if (client_config.protocol != ProtocolType::GRPC)
+                {
+                    std::cerr << "Streaming is only supported with gRPC, using unary requests" << std::endl;
+                }
+                else
+                {
+                    streaming_ = true;
+                    for (const std::unique_ptr<Endpoint> &endpoint : endpoints_)
+                    {
+                        for (const std::unique_ptr<TritonConnection> &connection : endpoint->connections)
+                        {
+                            tc::Error tc_err = startStream(*connection);
+                            if (!tc_err.IsOk())
+                            {
+                                std::cerr << "Unable to start stream to " << endpoint->url << ": " << tc_err.Message() << std::endl;
+                                return;
+                            }
+                        }
+                    }
+                }
+            }
+            valid_ = true;
+
+            if (client_config.health_check_interval_ms > 0)
+            {
+                health_thread_ = std::thread(&TritonClientPool::checkHealth, this);
+            }
+        }
+
+        TritonClientPool::~TritonClientPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(health_mutex_);
+                stop_ = true;
+            }
+            health_cv_.notify_all();
+            if (health_thread_.joinable())
+            {
+                health_thread_.join();
+            }
+        }
+
+        TritonConnection *TritonClientPool::acquire()
+        {
+            Endpoint *endpoint = selectEndpoint();
+            if (!endpoint)
+            {
+                return nullptr;
+            }
+
+            TritonConnection *connection = endpoint->connections[0].get();
+            for (const std::unique_ptr<TritonConnection> &candidate : endpoint->connections)
+            {
+                if (candidate->outstanding < connection->outstanding)
+                {
+                    connection = candidate.get();
+                }
+            }
+            connection->outstanding++;
+            endpoint->outstanding++;
+            return connection;
+        }
+
+        void TritonClientPool::release(TritonConnection *connection, const bool &success)
+        {
+            Endpoint &endpoint = *endpoints_[connection->endpoint];
+            connection->outstanding--;
+            endpoint.outstanding--;
+
+            if (success)
+            {
+                endpoint.failures = 0;
+                return;
+            }
+            if (++endpoint.failures >= std::max(client_config_.max_consecutive_failures, 1) && endpoint.healthy.exchange(false))
+            {
+                std::cerr << "Ejecting Triton endpoint " << endpoint.url << " after " << endpoint.failures << " failures" << std::endl;
+            }
+        }
+
+        std::vector<TritonConnection *> TritonClientPool::endpointConnections() const
+        {
+            std::vector<TritonConnection *> connections;
+            for (const std::unique_ptr<Endpoint> &endpoint : endpoints_)
+            {
+                connections.push_back(endpoint->connections[0].get());
+            }
+            return connections;
+        }
+
+        TritonClientPool::Endpoint *TritonClientPool::selectEndpoint()
+        {
+            if (client_config_.load_balancing == LoadBalancingPolicy::POWER_OF_TWO_CHOICES)
+            {
+                std::vector<Endpoint *> healthy;
+                for (const std::unique_ptr<Endpoint> &endpoint : endpoints_)
+                {
+                    if (endpoint->healthy)
+                    {
+                        healthy.push_back(endpoint.get());
+                    }
+                }
+                if (healthy.size() <= 1)
+                {
+                    return healthy.empty() ? nullptr : healthy[0];
+                }
+
+                // Two distinct random endpoints, the less loaded one wins.
+                static thread_local std::minstd_rand rng(std::random_device{}());
+                size_t a = rng() % healthy.size();
+                size_t b = (a + 1 + rng() % (healthy.size() - 1)) % healthy.size();
+                return healthy[b]->outstanding < healthy[a]->outstanding ? healthy[b] : healthy[a];
+            }
+
+            Endpoint *selected = nullptr;
+            size_t start = next_endpoint_++;
+            for (size_t i = 0; i < endpoints_.size(); ++i)
+            {
+                Endpoint *endpoint = endpoints_[(start + i) % endpoints_.size()].get();
+                if (endpoint->healthy && (!selected || endpoint->outstanding < selected->outstanding))
+                {
+                    selected = endpoint;
+                }
+            }
+            return selected;
+        }
+
+        void TritonClientPool::checkHealth()
+        {
+            std::unique_lock<std::mutex> lock(health_mutex_);
+            while (!stop_)
+            {
+                health_cv_.wait_for(lock, std::chrono::milliseconds(client_config_.health_check_interval_ms));
+                if (stop_)
+                {
+                    break;
+                }
+
+                lock.unlock();
+                for (const std::unique_ptr<Endpoint> &endpoint : endpoints_)
+                {
+                    bool ready = isReady(*endpoint);
+                    if (ready && streaming_)
+                    {
+                        // Streams closed by a server restart or network error are reopened here.
+                        for (const std::unique_ptr<TritonConnection> &connection : endpoint->connections)
+                        {
+                            bool active;
+                            {
+                                std::lock_guard<std::mutex> stream_lock(connection->stream_mutex);
+                                active = connection->stream_active;
+                            }
+                            ready = ready && (active || startStream(*connection).IsOk());
+                        }
+                    }
+                    if (ready && !endpoint->healthy)
+                    {
+                        endpoint->failures = 0;
+                        endpoint->healthy = true;
+                        std::cerr << "Re-adding Triton endpoint " << endpoint->url << std::endl;
+                    }
+                    else if (!ready && endpoint->healthy.exchange(false))
+                    {
+                        std::cerr << "Ejecting Triton endpoint " << endpoint->url << ", server is not ready" << std::endl;
+                    }
+                }
+                lock.lock();
+            }
+        }
+
+        bool TritonClientPool::isReady(Endpoint &endpoint)
+        {
+            bool ready = false;
+            tc::Error tc_err;
+            TritonConnection &connection = *endpoint.connections[0];
+            if (client_config_.protocol == ProtocolType::HTTP)
+            {
+                tc_err = connection.client.http_client_->IsServerReady(&ready, client_config_.http_headers);
+            }
+            else
+            {
+                tc_err = connection.client.grpc_client_->IsServerReady(&ready, client_config_.http_headers);
+            }
+            return tc_err.IsOk() && ready;
+        }
+    
+        tc::Error TritonClientPool::asyncStreamInfer(TritonConnection *connection, tc::OnCompleteFn callback, tc::InferOptions &options,
+                                                     const std::vector<tc::InferInput *> &inputs, const std::vector<const tc::InferRequestedOutput *> &outputs)
+        {
+            // The callback is registered before sending, the response may arrive before AsyncStreamInfer returns.
+            options.request_id_ = std::to_string(next_stream_id_++);
+            {
+                std::lock_guard<std::mutex> lock(connection->stream_mutex);
+                if (!connection->stream_active)
+                {
+                    return tc::Error("Stream to Triton endpoint is closed");
+                }
+                connection->stream_callbacks[options.request_id_] = std::move(callback);
+            }
+
+            tc::Error tc_err = connection->client.grpc_client_->AsyncStreamInfer(options, inputs, outputs);
+            if (!tc_err.IsOk())
+            {
+                std::lock_guard<std::mutex> lock(connection->stream_mutex);
+                connection->stream_callbacks.erase(options.request_id_);
+            }
+            return tc_err;
+        }
+
+        tc::Error TritonClientPool::startStream(TritonConnection &connection)
+        {
+            connection.client.grpc_client_->StopStream();
+            tc::Error tc_err = connection.client.grpc_client_->StartStream(
+                [this, &connection](tc::InferResult *result)
+                {
+                    onStreamResult(connection, result);
+                },
+                false, 0, client_config_.http_headers);
+
+            std::lock_guard<std::mutex> lock(connection.stream_mutex);
+            connection.stream_active = tc_err.IsOk();
+            return tc_err;
+        }
+
+        void TritonClientPool::onStreamResult(TritonConnection &connection, tc::InferResult *result)
+        {
+            std::string id;
+            result->Id(&id);
+
+            tc::OnCompleteFn callback;
+            std::unordered_map<std::string, tc::OnCompleteFn> orphans;
+            {
+                std::lock_guard<std::mutex> lock(connection.stream_mutex);
+                auto it = connection.stream_callbacks.find(id);
+                if (it != connection.stream_callbacks.end())
+                {
+                    callback = std::move(it->second);
+                    connection.stream_callbacks.erase(it);
+                }
+                else if (!result->RequestStatus().IsOk())
+                {
+                    // An error without a known request id closes the stream, every pending request is failed.
+                    connection.stream_active = false;
+                    orphans.swap(connection.stream_callbacks);
+                }
+            }
+
+            if (callback)
+            {
+                callback(result);
+                return;
+            }
+            if (!orphans.empty())
+            {
+                std::cerr << "Triton stream closed: " << result->RequestStatus().Message() << std::endl;
+            }
+            delete result;
+            for (auto &orphan : orphans)
+            {
+                orphan.second(nullptr);
+            }
+        }
+    }
+}
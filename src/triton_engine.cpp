@@ -10,42 +10,144 @@ namespace cpp_server
         {
             this->batch_size = batch_size;
 
-            tc::Error tc_err;
-            if (client_config.protocol == ProtocolType::HTTP)
-            {
-                tc_err = tc::InferenceServerHttpClient::Create(
-                    &triton_client.http_client_, client_config.url, client_config.verbose);
-            }
-            else
-            {
-                tc_err = tc::InferenceServerGrpcClient::Create(
-                    &triton_client.grpc_client_, client_config.url, client_config.verbose);
-            }
-            // TODO: Move to error code or status
-            if (!tc_err.IsOk())
+            client_pool.reset(new TritonClientPool(client_config));
+            if (!client_pool->isValid())
             {
-                std::cout << tc_err.Message() << std::endl;
                 this->status = false;
+                return;
             }
             cps_utils::Error p_err;
             p_err = readModelConfig();
-            if (!tc_err.IsOk())
+            if (!p_err.IsOk())
             {
-                std::cout << tc_err.Message() << std::endl;
+                std::cout << p_err.AsString() << std::endl;
                 this->status = false;
+                return;
             }
-            p_err = initializeMemory();
-            if (!tc_err.IsOk())
+            if (client_config.use_shared_memory)
             {
-                std::cout << tc_err.Message() << std::endl;
-                this->status = false;
+                initializeSharedMemory();
             }
             this->status = true;
         }
 
+        template <typename T>
+        TritonEngine<T>::~TritonEngine()
+        {
+            // Regions are unlinked with the last slot reference, results may still hold some.
+            std::vector<TritonConnection *> connections = client_pool->endpointConnections();
+            for (const std::shared_ptr<SharedMemorySlot> &slot : shm_slots)
+            {
+                for (const size_t &endpoint : slot->endpoints)
+                {
+                    registerSharedMemory(*slot, connections[endpoint], false);
+                }
+            }
+        }
+
+        template <typename T>
+        void TritonEngine<T>::initializeSharedMemory()
+        {
+            // Tensors are 64 bytes aligned, a slot holds one batch of max_batch_size rows.
+            const size_t alignment = 64;
+            int64_t slot_rows = std::max(this->model_config.max_batch_size_, 1);
+            int64_t config_rows = this->model_config.max_batch_size_ > 0 ? this->batch_size : 1;
+            shm_slot_size = 0;
+
+            auto layout = [&](const std::vector<cps_utils::TensorConfig> &tensors, std::vector<size_t> &offsets, std::vector<size_t> &sizes)
+            {
+                for (const cps_utils::TensorConfig &tensor : tensors)
+                {
+                    if (tensor.byte_size_ < 0)
+                    {
+                        offsets.push_back(std::string::npos);
+                        sizes.push_back(0);
+                        continue;
+                    }
+                    size_t byte_size = tensor.byte_size_ / config_rows * slot_rows;
+                    offsets.push_back(shm_slot_size);
+                    sizes.push_back(byte_size);
+                    shm_slot_size += (byte_size + alignment - 1) / alignment * alignment;
+                }
+            };
+            layout(this->model_config.inputs_, shm_input_offsets, shm_input_sizes);
+            layout(this->model_config.outputs_, shm_output_offsets, shm_output_sizes);
+        }
+
+        template <typename T>
+        cps_utils::Error TritonEngine<T>::acquireSharedMemory(std::shared_ptr<SharedMemorySlot> &slot, TritonConnection *connection)
+        {
+            {
+                std::lock_guard<std::mutex> lock(shm_mutex);
+                for (const std::shared_ptr<SharedMemorySlot> &candidate : shm_slots)
+                {
+                    // Only the slot list holds an idle slot, results alias slots they were written to.
+                    if (!candidate->busy && candidate.use_count() == 1)
+                    {
+                        candidate->busy = true;
+                        slot = candidate;
+                        break;
+                    }
+                }
+
+                if (!slot)
+                {
+                    std::shared_ptr<SharedMemorySlot> new_slot(new SharedMemorySlot());
+                    new_slot->name = "cps_" + std::to_string(getpid()) + "_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + "_" + std::to_string(shm_slots.size());
+                    new_slot->region.reset(new cps_utils::SharedMemoryRegion("/" + new_slot->name, shm_slot_size));
+                    if (!new_slot->region->isValid())
+                    {
+                        return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to create shared memory region " + new_slot->name);
+                    }
+                    new_slot->busy = true;
+                    shm_slots.push_back(new_slot);
+                    slot = new_slot;
+                }
+            }
+
+            // The busy slot is only used by this batch, it is registered without holding the lock and
+            // only on endpoints that receive a batch, ejected ones never get it.
+            if (slot->endpoints.count(connection->endpoint))
+            {
+                return cps_utils::Error::Success;
+            }
+            tc::Error tc_err = registerSharedMemory(*slot, connection, true);
+            if (!tc_err.IsOk())
+            {
+                // The server may hold a partial registration, it is dropped so the next attempt doesn't conflict.
+                registerSharedMemory(*slot, connection, false);
+                releaseSharedMemory(slot);
+                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to register shared memory region, " + tc_err.Message());
+            }
+            slot->endpoints.insert(connection->endpoint);
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        tc::Error TritonEngine<T>::registerSharedMemory(const SharedMemorySlot &slot, TritonConnection *connection, const bool &registered)
+        {
+            if (client_config.protocol == ProtocolType::HTTP)
+            {
+                if (registered)
+                {
+                    return connection->client.http_client_->RegisterSystemSharedMemory(
+                        slot.name, slot.region->key(), shm_slot_size, 0, client_config.http_headers);
+                }
+                return connection->client.http_client_->UnregisterSystemSharedMemory(slot.name, client_config.http_headers);
+            }
+            if (registered)
+            {
+                return connection->client.grpc_client_->RegisterSystemSharedMemory(
+                    slot.name, slot.region->key(), shm_slot_size, 0, client_config.http_headers);
+            }
+            return connection->client.grpc_client_->UnregisterSystemSharedMemory(slot.name, client_config.http_headers);
+        }
+
         template <typename T>
         cps_utils::Error TritonEngine<T>::readModelConfig()
         {
+            // Every endpoint is expected to serve the same model, configuration is read from the first one.
+            TritonClient &triton_client = client_pool->endpointConnections()[0]->client;
             tc::Error tc_err;
             if (client_config.protocol == ProtocolType::HTTP)
             {
@@ -76,7 +178,7 @@ namespace cpp_server
                     return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Failed to parse triton model config");
                 }
                 if (!ParseModelHttp(
-                        model_metadata_json, model_config_json, this->batch_size, &model_config))
+                        model_metadata_json, model_config_json, this->batch_size, &this->model_config))
                 {
                     return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Failed to parse model configuration and metadata");
                 }
@@ -97,7 +199,7 @@ namespace cpp_server
                 {
                     return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Failed to get triton model config");
                 }
-                if (!ParseModelGrpc(model_metadata_response, model_config_response, this->batch_size, &model_config))
+                if (!ParseModelGrpc(model_metadata_response, model_config_response, this->batch_size, &this->model_config))
                 {
                     return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Failed to parse model configuration and metadata");
                 }
@@ -106,60 +208,104 @@ namespace cpp_server
         }
 
         template <typename T>
-        cps_utils::Error TritonEngine<T>::initializeMemory()
+        void TritonEngine<T>::releaseSharedMemory(std::shared_ptr<SharedMemorySlot> &slot)
+        {
+            // The slot is reused once the results aliasing its outputs are released.
+            if (slot)
+            {
+                std::lock_guard<std::mutex> lock(shm_mutex);
+                slot->busy = false;
+            }
+            slot.reset();
+        }
+
+        template <typename T>
+        void TritonEngine<T>::releaseConnection(AsyncChunk &chunk, const bool &success)
+        {
+            releaseSharedMemory(chunk.shm_slot);
+            client_pool->release(chunk.connection, success);
+            chunk.connection = nullptr;
+        }
+
+        template <typename T>
+        cps_utils::Error TritonEngine<T>::initializeMemory(AsyncChunk &chunk)
         {
             // Initialize the inputs with the data.
-            tc::InferInput *input;
             tc::Error tc_err;
-            tc_err = tc::InferInput::Create(
-                &input, model_config.input_name_, model_config.input_shape_, model_config.input_datatype_);
-            if (!tc_err.IsOk())
+            for (const cps_utils::TensorConfig &input_config : this->model_config.inputs_)
             {
-                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get TritonClient::Input input");
+                tc::InferInput *input;
+                tc_err = tc::InferInput::Create(
+                    &input, input_config.name_, input_config.shape_, input_config.datatype_);
+                if (!tc_err.IsOk())
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get TritonClient::Input " + input_config.name_);
+                }
+                chunk.inputs.emplace_back(input);
             }
-            input_ptr.reset(input);
 
-            tc::InferRequestedOutput *output;
-            // Set the number of classification expected
-            tc_err =
-                tc::InferRequestedOutput::Create(&output, model_config.output_name_);
-            if (!tc_err.IsOk())
+            for (const cps_utils::TensorConfig &output_config : this->model_config.outputs_)
             {
-                return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get TritonClient::Output output");
+                tc::InferRequestedOutput *output;
+                tc_err =
+                    tc::InferRequestedOutput::Create(&output, output_config.name_);
+                if (!tc_err.IsOk())
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get TritonClient::Output " + output_config.name_);
+                }
+                chunk.outputs.emplace_back(output);
             }
-            output_ptr.reset(output);
 
-            // The inference settings. Will be using default for now.
-            infer_options.model_name_ = client_config.model_name;
-            infer_options.model_version_ = client_config.model_version;
-
-            infer_inputs.push_back(input_ptr.get());   //! Moving raw pointer
-            infer_outputs.push_back(output_ptr.get()); //! Moving raw pointer
             return cps_utils::Error::Success;
         }
 
         template <typename T>
-        cps_utils::Error TritonEngine<T>::validate(const std::vector<cps_utils::InferenceData<uint8_t>> &data)
+        cps_utils::Error TritonEngine<T>::validate(const std::vector<cps_utils::InferenceData<T>> &data, std::vector<int> &input_indices)
         {
-            if (data.size() != this->batch_size)
+            const std::vector<cps_utils::TensorConfig> &inputs = this->model_config.inputs_;
+            if (data.size() != inputs.size())
             {
-                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Number of data is different from batch size.");
+                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Number of data is different from number of model inputs.");
             }
-            size_t data_byte_size = 0;
-            for (const cps_utils::InferenceData<uint8_t> &d : data)
-            {
-                data_byte_size += sizeof(uint8_t) * d.data.size();
-            }
-            if (data_byte_size > model_config.input_byte_size_)
+
+            input_indices.assign(data.size(), -1);
+            for (size_t i = 0; i < data.size(); ++i)
             {
-                return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Total data bytesize is different from allocated bytesize.");
+                // Inputs are matched by name, unnamed data follows the model input order.
+                const cps_utils::InferenceData<T> &d = data[i];
+                int index = d.name.empty() ? i : this->model_config.inputIndex(d.name);
+                if (index < 0 || std::find(input_indices.begin(), input_indices.end(), index) != input_indices.end())
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Unknown or duplicated model input " + d.name);
+                }
+                input_indices[i] = index;
+
+                // Each row must match the allocated bytesize of a single batch item.
+                int64_t rows = 1;
+                int64_t row_byte_size = inputs[index].byte_size_;
+                if (this->model_config.max_batch_size_ > 0)
+                {
+                    rows = d.shape.empty() ? 0 : d.shape[0];
+                    row_byte_size /= this->batch_size;
+                }
+                int64_t first_rows = this->model_config.max_batch_size_ > 0 && !data[0].shape.empty() ? data[0].shape[0] : 1;
+                if (rows <= 0 || rows != first_rows)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Data batch size must be positive and equal for all inputs.");
+                }
+                // Inputs with variable-size dimensions are checked by the server.
+                if (row_byte_size >= 0 && sizeof(T) * d.data.size() != rows * row_byte_size)
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Total data bytesize is different from allocated bytesize for input " + inputs[index].name_);
+                }
             }
 
             return cps_utils::Error::Success;
         }
 
         template <typename T>
-        cps_utils::Error TritonEngine<T>::postprocess(const std::unique_ptr<tc::InferResult> &result, cps_utils::InferenceResult<T> &res, const size_t &batch_size, const std::string &output_name)
+        cps_utils::Error TritonEngine<T>::postprocess(const std::shared_ptr<tc::InferResult> &result, cps_utils::InferenceResult<T> &res,
+                                                      const size_t &output_index, const std::shared_ptr<SharedMemorySlot> &shm_slot)
         {
             if (!result->RequestStatus().IsOk())
             {
@@ -167,6 +313,7 @@ namespace cpp_server
             }
 
             // Get and validate the shape and datatype
+            const std::string &output_name = this->model_config.outputs_[output_index].name_;
             tc::Error err = result->Shape(output_name, &res.shape);
             if (!err.IsOk())
             {
@@ -179,14 +326,42 @@ namespace cpp_server
                 return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get datatype for output " + output_name);
             }
 
-            std::shared_ptr<uint8_t> buf_ptr(new uint8_t);
-            err = result->RawData(output_name, (const uint8_t **)&buf_ptr, &res.byte_size);
+            // Output written by the server into shared memory, the buffer keeps the slot alive.
+            if (shm_slot && shm_output_offsets[output_index] != std::string::npos)
+            {
+                size_t size = 1;
+                for (const int64_t &dim : res.shape)
+                {
+                    size *= dim;
+                }
+                res.byte_size = size * sizeof(T);
+                if (res.byte_size > shm_output_sizes[output_index])
+                {
+                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Shared memory output is larger than allocated for " + output_name);
+                }
+                T *ptr = reinterpret_cast<T *>(static_cast<uint8_t *>(shm_slot->region->data()) + shm_output_offsets[output_index]);
+                res.data = cps_utils::TensorBuffer<T>(shm_slot, ptr, size);
+                return cps_utils::Error::Success;
+            }
+
+            const uint8_t *buf_ptr;
+            err = result->RawData(output_name, &buf_ptr, &res.byte_size);
             if (!err.IsOk())
             {
                 return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to get data for output " + output_name);
             }
-            std::vector<uint8_t> uint8_blob_= std::vector<uint8_t>(buf_ptr.get(), buf_ptr.get() + res.byte_size);
-            res.data = cpp_server::utils::blob_to_vectorT<T>(uint8_blob_);
+
+            // Raw data lives inside the result, only copy when it isn't aligned for T.
+            size_t size = res.byte_size / sizeof(T);
+            if (reinterpret_cast<uintptr_t>(buf_ptr) % alignof(T) == 0)
+            {
+                res.data = cps_utils::TensorBuffer<T>(result, reinterpret_cast<T *>(const_cast<uint8_t *>(buf_ptr)), size);
+            }
+            else
+            {
+                res.data = cps_utils::TensorBuffer<T>(size);
+                memcpy(res.data.data(), buf_ptr, size * sizeof(T));
+            }
 
             return cps_utils::Error::Success;
         }
@@ -194,100 +369,277 @@ namespace cpp_server
         template <typename T>
         cps_utils::Error TritonEngine<T>::process(const std::vector<cps_utils::InferenceData<T>> &infer_data, std::vector<cps_utils::InferenceResult<T>> &infer_results)
         {
-            std::vector<cps_utils::InferenceData<uint8_t>> input_uint8_;
-            for(auto &T_data: infer_data)
-            {
-                cpp_server::utils::InferenceData<uint8_t> tdata_;
-                std::vector<uint8_t> array_uint8 = cpp_server::utils::vectorT_to_blob<T>(T_data.data);
-                tdata_.data = array_uint8;
-
-                tdata_.name = T_data.name;
-                tdata_.data_dtype = T_data.data_dtype;
-                tdata_.shape = T_data.shape;
-                input_uint8_.push_back(tdata_);
-            }
+            return this->processAwait(infer_data, infer_results);
+        }
 
+        template <typename T>
+        cps_utils::Error TritonEngine<T>::processAsync(const std::vector<cps_utils::InferenceData<T>> &infer_data, typename InferenceEngine<T>::ProcessCallback callback)
+        {
             cps_utils::Error p_err;
-            p_err = validate(input_uint8_);
+            std::vector<int> input_indices;
+            p_err = validate(infer_data, input_indices);
             if (!p_err.IsOk())
             {
                 return p_err;
             }
 
-            size_t data_idx = 0;
-            size_t done_cnt = 0;
-            size_t sent_count = 0;
-            bool last_request = false;
-            tc::Error tc_err;
-            std::vector<std::unique_ptr<tc::InferResult>> results;
+            // Inference data shares its tensor buffers, so the request keeps them alive without copying.
+            std::shared_ptr<AsyncRequest> request(new AsyncRequest());
+            request->input_data.resize(infer_data.size());
+            for (size_t i = 0; i < infer_data.size(); ++i)
+            {
+                request->input_data[input_indices[i]] = infer_data[i];
+            }
 
-            while (!last_request)
+            // Requests with more rows than the model max batch size are split into batches sent concurrently.
+            int64_t batch_rows = 1;
+            if (this->model_config.max_batch_size_ > 0)
             {
-                // Reset the input for new request.
-                tc_err = input_ptr->Reset();
-                if (!tc_err.IsOk())
+                request->total_rows = request->input_data[0].shape[0];
+                batch_rows = this->model_config.max_batch_size_;
+            }
+            for (const cps_utils::InferenceData<T> &input_data : request->input_data)
+            {
+                request->row_sizes.push_back(input_data.data.size() / request->total_rows);
+            }
+
+            std::vector<cps_utils::BatchRange> batches = cps_utils::split_batches(request->total_rows, batch_rows);
+            request->chunks.resize(batches.size());
+            for (size_t k = 0; k < batches.size(); ++k)
+            {
+                AsyncChunk &chunk = request->chunks[k];
+                chunk.offset = batches[k].offset;
+                chunk.rows = batches[k].rows;
+                p_err = initializeMemory(chunk);
+                if (!p_err.IsOk())
                 {
-                    return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed resetting input ptr");
+                    return p_err;
                 }
+            }
+            request->callback = std::move(callback);
+            request->pipeline.reset(new cps_utils::BatchPipeline(request->chunks.size(), std::max(client_config.max_outstanding_requests, 1)));
 
-                // Set input to be the next 'batch_size' images (preprocessed).
-                for (int idx = 0; idx < this->batch_size; ++idx)
+            // The first batch is sent here so that a failure is reported to the caller without the callback.
+            size_t index;
+            request->pipeline->next(index);
+            p_err = sendChunk(request, index);
+            if (!p_err.IsOk())
+            {
+                return p_err;
+            }
+            sendPending(request);
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        void TritonEngine<T>::sendPending(const std::shared_ptr<AsyncRequest> &request)
+        {
+            size_t index;
+            while (request->pipeline->next(index))
+            {
+                cps_utils::Error p_err = sendChunk(request, index);
+                if (!p_err.IsOk())
                 {
-                    tc_err = input_ptr->AppendRaw(input_uint8_[data_idx].data);
-                    if (!tc_err.IsOk())
+                    if (request->pipeline->complete(p_err))
                     {
-                        return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed setting input");
+                        finish(*request);
                     }
+                    return;
+                }
+            }
+        }
 
-                    data_idx = (data_idx + 1) % input_uint8_.size();
-                    if (data_idx == 0)
-                    {
-                        last_request = true;
-                    }
+        template <typename T>
+        cps_utils::Error TritonEngine<T>::sendChunk(const std::shared_ptr<AsyncRequest> &request, const size_t &index)
+        {
+            AsyncChunk &chunk = request->chunks[index];
+
+            // Batches of an expired request aren't sent, the ones in flight time out on the client.
+            const cps_utils::Deadline &deadline = request->input_data[0].deadline;
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::DEADLINE_EXCEEDED, "Request deadline passed before inference");
+            }
+
+            cps_utils::Error p_err;
+            chunk.connection = client_pool->acquire();
+            if (!chunk.connection)
+            {
+                return cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "No healthy Triton endpoint available");
+            }
+            if (client_config.use_shared_memory && shm_slot_size > 0)
+            {
+                p_err = acquireSharedMemory(chunk.shm_slot, chunk.connection);
+                if (!p_err.IsOk())
+                {
+                    releaseConnection(chunk, true);
+                    return p_err;
                 }
+            }
+            uint8_t *shm_ptr = chunk.shm_slot ? static_cast<uint8_t *>(chunk.shm_slot->region->data()) : nullptr;
 
-                infer_options.request_id_ = std::to_string(sent_count);
+            tc::Error tc_err;
+            std::vector<tc::InferInput *> infer_inputs;
+            for (size_t i = 0; i < chunk.inputs.size(); ++i)
+            {
+                const cps_utils::InferenceData<T> &input_data = request->input_data[i];
+                tc::InferInput *input = chunk.inputs[i].get();
 
-                tc::InferResult *result;
-                if (client_config.protocol == ProtocolType::HTTP)
+                std::vector<int64_t> shape = input_data.shape;
+                if (this->model_config.max_batch_size_ > 0)
                 {
-                    tc_err = triton_client.http_client_->Infer(
-                        &result, infer_options, infer_inputs, infer_outputs, client_config.http_headers);
+                    shape[0] = chunk.rows;
+                }
+                tc_err = input->SetShape(shape);
+                if (!tc_err.IsOk())
+                {
+                    releaseConnection(chunk, true);
+                    return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed setting input shape");
+                }
+
+                // Set input to be the 'rows' items of the batch, written to shared memory when the input has a fixed size.
+                const uint8_t *input_ptr = reinterpret_cast<const uint8_t *>(input_data.data.data() + chunk.offset * request->row_sizes[i]);
+                size_t input_byte_size = sizeof(T) * chunk.rows * request->row_sizes[i];
+                if (shm_ptr && shm_input_offsets[i] != std::string::npos)
+                {
+                    memcpy(shm_ptr + shm_input_offsets[i], input_ptr, input_byte_size);
+                    tc_err = input->SetSharedMemory(chunk.shm_slot->name, input_byte_size, shm_input_offsets[i]);
                 }
                 else
                 {
-                    tc_err = triton_client.grpc_client_->Infer(
-                        &result, infer_options, infer_inputs, infer_outputs, client_config.http_headers);
+                    tc_err = input->AppendRaw(input_ptr, input_byte_size);
                 }
                 if (!tc_err.IsOk())
                 {
-                    return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed sending synchronous infer request");
+                    releaseConnection(chunk, true);
+                    return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed setting input");
                 }
-                results.emplace_back(std::move(std::unique_ptr<tc::InferResult>(result)));
-                sent_count++;
+                infer_inputs.push_back(input);
             }
 
-            // Post-process the results to make prediction(s)
-            for (size_t idx = 0; idx < results.size(); idx++)
+            // The inference settings. Will be using default for now.
+            tc::InferOptions infer_options(client_config.model_name);
+            infer_options.model_version_ = client_config.model_version;
+            infer_options.request_id_ = std::to_string(index);
+            if (deadline != cps_utils::no_deadline())
             {
-                cps_utils::InferenceResult<T> output_data;
-                cps_utils::Error p_err;
-                try
+                infer_options.client_timeout_ = std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count();
+            }
+
+            std::vector<const tc::InferRequestedOutput *> infer_outputs;
+            for (size_t o = 0; o < chunk.outputs.size(); ++o)
+            {
+                tc::InferRequestedOutput *output = chunk.outputs[o].get();
+                if (shm_ptr && shm_output_offsets[o] != std::string::npos)
                 {
-                    p_err = postprocess(results[idx], output_data, this->batch_size, model_config.output_name_);
-                    if (!p_err.IsOk())
+                    tc_err = output->SetSharedMemory(chunk.shm_slot->name, shm_output_sizes[o], shm_output_offsets[o]);
+                    if (!tc_err.IsOk())
                     {
-                        return p_err;
+                        releaseConnection(chunk, true);
+                        return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed setting shared memory output");
                     }
-                    infer_results.push_back(output_data);
+                }
+                infer_outputs.push_back(output);
+            }
+            auto on_complete = [this, request, index](tc::InferResult *result)
+            {
+                onResult(request, index, result);
+            };
+
+            TritonClient &triton_client = chunk.connection->client;
+            if (client_pool->isStreaming())
+            {
+                tc_err = client_pool->asyncStreamInfer(chunk.connection, on_complete, infer_options, infer_inputs, infer_outputs);
+            }
+            else if (client_config.protocol == ProtocolType::HTTP)
+            {
+                tc_err = triton_client.http_client_->AsyncInfer(
+                    on_complete, infer_options, infer_inputs, infer_outputs, client_config.http_headers);
+            }
+            else
+            {
+                tc_err = triton_client.grpc_client_->AsyncInfer(
+                    on_complete, infer_options, infer_inputs, infer_outputs, client_config.http_headers);
+            }
+            if (!tc_err.IsOk())
+            {
+                releaseConnection(chunk, false);
+                return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Failed sending asynchronous infer request");
+            }
+            return cps_utils::Error::Success;
+        }
+
+        template <typename T>
+        void TritonEngine<T>::onResult(const std::shared_ptr<AsyncRequest> &request, const size_t &index, tc::InferResult *result)
+        {
+            std::shared_ptr<tc::InferResult> result_ptr(result);
+            AsyncChunk &chunk = request->chunks[index];
+
+            if (!result_ptr)
+            {
+                // Stream closed before the response arrived.
+                releaseConnection(chunk, false);
+                if (request->pipeline->complete(cps_utils::Error(cps_utils::Error::Code::UNAVAILABLE, "Triton stream closed")))
+                {
+                    finish(*request);
+                }
+                return;
+            }
+
+            chunk.results.resize(this->model_config.outputs_.size());
+            cps_utils::Error p_err;
+            for (size_t o = 0; o < chunk.results.size() && p_err.IsOk(); ++o)
+            {
+                try
+                {
+                    p_err = postprocess(result_ptr, chunk.results[o], o, chunk.shm_slot);
                 }
                 catch (std::exception &e)
                 {
                     std::cout << e.what() << std::endl;
-                    return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to run postprocessing for " + model_config.output_name_);
+                    p_err = cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Unable to run postprocessing for " + this->model_config.outputs_[o].name_);
                 }
             }
-            return cps_utils::Error::Success;
+            // Only a failed request status counts against the endpoint, postprocessing errors are local.
+            releaseConnection(chunk, result_ptr->RequestStatus().IsOk());
+
+            if (request->pipeline->complete(p_err))
+            {
+                finish(*request);
+                return;
+            }
+            sendPending(request);
+        }
+
+        template <typename T>
+        void TritonEngine<T>::finish(AsyncRequest &request)
+        {
+            std::vector<cps_utils::InferenceResult<T>> infer_results;
+            cps_utils::Error p_err = request.pipeline->error();
+            if (p_err.IsOk())
+            {
+                // Batches are joined back in request id order, whatever order their responses arrived in.
+                std::vector<std::vector<cps_utils::InferenceResult<T>>> batch_results;
+                for (AsyncChunk &chunk : request.chunks)
+                {
+                    batch_results.push_back(std::move(chunk.results));
+                }
+                p_err = cps_utils::join_batches(batch_results, infer_results);
+            }
+            if (!p_err.IsOk())
+            {
+                infer_results.clear();
+                request.callback(p_err, infer_results);
+                return;
+            }
+
+            for (size_t o = 0; o < infer_results.size(); ++o)
+            {
+                infer_results[o].name = this->model_config.outputs_[o].name_;
+                infer_results[o].status = true;
+            }
+            request.callback(cps_utils::Error::Success, infer_results);
         }
     };
 };
@@ -295,4 +647,4 @@ namespace cpp_server
 //  https://isocpp.org/wiki/faq/templates#separate-template-class-defn-from-decl
 //  * NOTE: Solve template function linker problem
 
-template class cpp_server::inferencer::TritonEngine<float>;
+template class cpp_server::inferencer::TritonEngine<float>;
\ No newline at end of file
@@ -0,0 +1,155 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include "cpp_server/utils/admission.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        void AdmissionController::Releaser::operator()(AdmissionController *controller) const
+        {
+            if (controller)
+            {
+                controller->release(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+            }
+        }
+
+        AdmissionController::AdmissionController(const AdmissionConfig &config)
+            : config(config)
+        {
+            this->config.max_in_flight = std::max<size_t>(this->config.max_in_flight, 1);
+        }
+
+        Error AdmissionController::admit(const Deadline &deadline, Ticket &ticket)
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= deadline)
+            {
+                return Error(Error::Code::DEADLINE_EXCEEDED, "Request deadline passed before admission");
+            }
+
+            // Requests don't overtake the queue, a free slot goes to the waiting requests first.
+            if (waiting == 0 && tryAdmit())
+            {
+                ticket = Ticket(this, Releaser{now});
+                return Error::Success;
+            }
+            if (config.max_queue_delay_us == 0)
+            {
+                return Error(Error::Code::UNAVAILABLE, "Maximum number of requests in flight reached");
+            }
+
+            size_t position = ++waiting;
+            if (position > config.max_queue)
+            {
+                waiting--;
+                return Error(Error::Code::RESOURCE_EXHAUSTED, "Admission queue is full");
+            }
+
+            Deadline wait_deadline = deadline;
+            if (config.max_queue_delay_us > 0)
+            {
+                wait_deadline = std::min(wait_deadline, now + std::chrono::microseconds(config.max_queue_delay_us));
+            }
+            // Rejected right away rather than after waiting, the client can retry elsewhere in the meantime.
+            if (wait_deadline != no_deadline() && now + std::chrono::microseconds(expectedWait(position)) > wait_deadline)
+            {
+                waiting--;
+                return Error(Error::Code::UNAVAILABLE, "Request would not be admitted before its deadline");
+            }
+
+            bool admitted = false;
+            {
+                std::unique_lock<boost::fibers::mutex> lock(wait_mutex);
+                while (!(admitted = tryAdmit()))
+                {
+                    if (wait_deadline == no_deadline())
+                    {
+                        wait_cv.wait(lock);
+                    }
+                    else if (wait_cv.wait_until(lock, wait_deadline) == boost::fibers::cv_status::timeout)
+                    {
+                        admitted = tryAdmit();
+                        break;
+                    }
+                }
+            }
+            waiting--;
+            if (!admitted)
+            {
+                return Error(Error::Code::UNAVAILABLE, "Request was not admitted before its deadline");
+            }
+            // Service time is measured from admission, the queueing time is accounted by expectedWait.
+            ticket = Ticket(this, Releaser{std::chrono::steady_clock::now()});
+            return Error::Success;
+        }
+
+        int AdmissionController::retryAfter() const
+        {
+            int64_t wait_us = expectedWait(waiting + 1);
+            return static_cast<int>(std::max<int64_t>((wait_us + 999999) / 1000000, 1));
+        }
+
+        bool AdmissionController::tryAdmit()
+        {
+            size_t current = in_flight.load();
+            while (current < config.max_in_flight)
+            {
+                if (in_flight.compare_exchange_weak(current, current + 1))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        int64_t AdmissionController::expectedWait(const size_t &position) const
+        {
+            // Every in flight slot completes a request per service time on average.
+            return static_cast<int64_t>(position) * service_time_us / static_cast<int64_t>(config.max_in_flight);
+        }
+
+        void AdmissionController::release(const int64_t &elapsed_us)
+        {
+            int64_t average = service_time_us.load();
+            int64_t updated;
+            do
+            {
+                // Moving average weighting the last request by 1/8, the first one sets it.
+                updated = average == 0 ? elapsed_us : average + (elapsed_us - average) / 8;
+            } while (!service_time_us.compare_exchange_weak(average, updated));
+
+            in_flight--;
+            if (waiting > 0)
+            {
+                // Taking the mutex orders the notification after a waiter that failed its retry started waiting.
+                {
+                    std::unique_lock<boost::fibers::mutex> lock(wait_mutex);
+                }
+                wait_cv.notify_one();
+            }
+        }
+
+        Error parse_request_timeout(const std::string &timeout_ms, Deadline &deadline)
+        {
+            if (timeout_ms.empty())
+            {
+                deadline = no_deadline();
+                return Error::Success;
+            }
+
+            char *end = nullptr;
+            errno = 0;
+            long long value = std::strtoll(timeout_ms.c_str(), &end, 10);
+            if (errno != 0 || end != timeout_ms.c_str() + timeout_ms.size() || value <= 0)
+            {
+                return Error(Error::Code::INVALID_DATA, "Request timeout must be a positive number of milliseconds");
+            }
+            // Clamped to a day so the deadline can't overflow the clock.
+            value = std::min<long long>(value, 86400000LL);
+            deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(value);
+            return Error::Success;
+        }
+    } // namespace utils
+} // namespace cpp_server
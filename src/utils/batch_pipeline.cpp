@@ -0,0 +1,58 @@
+#include "cpp_server/utils/batch_pipeline.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        std::vector<BatchRange> split_batches(const int64_t &total_rows, const int64_t &batch_rows)
+        {
+            const int64_t rows = std::max<int64_t>(batch_rows, 1);
+            std::vector<BatchRange> batches;
+            for (int64_t offset = 0; offset < total_rows; offset += rows)
+            {
+                batches.push_back(BatchRange{offset, std::min(rows, total_rows - offset)});
+            }
+            return batches;
+        }
+
+        BatchPipeline::BatchPipeline(const size_t &num_batches, const size_t &max_outstanding)
+            : num_batches(num_batches), max_outstanding(std::max<size_t>(max_outstanding, 1)) {}
+
+        bool BatchPipeline::next(size_t &index)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!first_error.IsOk() || next_batch >= num_batches || in_flight >= max_outstanding)
+            {
+                return false;
+            }
+            index = next_batch++;
+            in_flight++;
+            return true;
+        }
+
+        bool BatchPipeline::complete(const Error &err)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            in_flight--;
+            if (!err.IsOk() && first_error.IsOk())
+            {
+                first_error = err;
+            }
+
+            // Complete once nothing is in flight and either every batch is sent or one of them failed.
+            bool done = in_flight == 0 && (!first_error.IsOk() || next_batch == num_batches);
+            if (!done || finished)
+            {
+                return false;
+            }
+            finished = true;
+            return true;
+        }
+
+        Error BatchPipeline::error()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return first_error;
+        }
+    } // namespace utils
+} // namespace cpp_server
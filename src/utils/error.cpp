@@ -63,6 +63,12 @@ namespace cpp_server
                 return "Unsupported";
             case Error::Code::ALREADY_EXISTS:
                 return "Already exists";
+            case Error::Code::RESOURCE_EXHAUSTED:
+                return "Resource exhausted";
+            case Error::Code::DEADLINE_EXCEEDED:
+                return "Deadline exceeded";
+            case Error::Code::NOT_FOUND:
+                return "Not found";
             default:
                 break;
             }
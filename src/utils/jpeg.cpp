@@ -0,0 +1,78 @@
+#include "cpp_server/utils/jpeg.hpp"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        bool jpeg_size(const char *data, const size_t &size, int &width, int &height)
+        {
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+            if (!data || size < 4 || bytes[0] != 0xff || bytes[1] != 0xd8)
+            {
+                return false;
+            }
+
+            size_t pos = 2;
+            while (pos + 4 <= size)
+            {
+                if (bytes[pos] != 0xff)
+                {
+                    return false;
+                }
+                uint8_t marker = bytes[pos + 1];
+                // Markers may be preceded by any number of 0xff fill bytes.
+                if (marker == 0xff)
+                {
+                    ++pos;
+                    continue;
+                }
+                // Standalone markers without a length field.
+                if (marker == 0x01 || (marker >= 0xd0 && marker <= 0xd7))
+                {
+                    pos += 2;
+                    continue;
+                }
+                if (marker == 0xd9 || marker == 0xda)
+                {
+                    // End of image or start of scan before any frame header.
+                    return false;
+                }
+
+                size_t length = bytes[pos + 2] << 8 | bytes[pos + 3];
+                if (length < 2 || pos + 2 + length > size)
+                {
+                    return false;
+                }
+                // SOF0 to SOF15, except DHT (c4), JPG (c8) and DAC (cc).
+                if (marker >= 0xc0 && marker <= 0xcf && marker != 0xc4 && marker != 0xc8 && marker != 0xcc)
+                {
+                    if (length < 7)
+                    {
+                        return false;
+                    }
+                    height = bytes[pos + 5] << 8 | bytes[pos + 6];
+                    width = bytes[pos + 7] << 8 | bytes[pos + 8];
+                    return width > 0 && height > 0;
+                }
+                pos += 2 + length;
+            }
+            return false;
+        }
+
+        int jpeg_scale_denominator(const int &width, const int &height, const int &target_width, const int &target_height)
+        {
+            int image_side = std::min(width, height);
+            int target_side = std::max(target_width, target_height);
+            int denominator = 1;
+            // Scaled decoders round up, a side of n pixels becomes ceil(n / denominator).
+            while (denominator < 8 && (image_side + 2 * denominator - 1) / (2 * denominator) >= target_side)
+            {
+                denominator *= 2;
+            }
+            return denominator;
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,65 @@
+#include "cpp_server/utils/json_writer.hpp"
+
+#include <vector>
+#include <rapidjson/writer.h>
+
+/// @brief Maximum number of idle buffers kept per thread, beyond that buffers are deleted.
+static const size_t max_free_buffers = 16;
+
+static std::vector<std::unique_ptr<cpp_server::utils::JsonBuffer>> &free_buffers()
+{
+    static thread_local std::vector<std::unique_ptr<cpp_server::utils::JsonBuffer>> buffers;
+    return buffers;
+}
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        JsonBuffer::JsonBuffer()
+            : pool_allocator(inline_buffer, inline_size)
+        {
+        }
+
+        void JsonBuffer::Releaser::operator()(JsonBuffer *buffer) const
+        {
+            // Chunks that overflowed the inline buffer go back to the heap, the inline buffer is reset.
+            buffer->pool_allocator.Clear();
+            std::vector<std::unique_ptr<JsonBuffer>> &buffers = free_buffers();
+            if (buffers.size() < max_free_buffers)
+            {
+                buffers.emplace_back(buffer);
+            }
+            else
+            {
+                delete buffer;
+            }
+        }
+
+        JsonBuffer::Ptr JsonBuffer::acquire()
+        {
+            std::vector<std::unique_ptr<JsonBuffer>> &buffers = free_buffers();
+            if (buffers.empty())
+            {
+                return Ptr(new JsonBuffer());
+            }
+            Ptr buffer(buffers.back().release());
+            buffers.pop_back();
+            return buffer;
+        }
+
+        void write_json(const rapidjson::Value &value, std::string &output, JsonBuffer &buffer, const int &max_decimal_places)
+        {
+            // Responses of one endpoint have similar sizes, so the previous size avoids regrowing output.
+            output.reserve(output.size() + buffer.last_output_size);
+            size_t start = output.size();
+
+            StringOutputStream stream(output);
+            rapidjson::Writer<StringOutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, JsonBuffer::Allocator> writer(stream, &buffer.allocator());
+            writer.SetMaxDecimalPlaces(max_decimal_places);
+            value.Accept(writer);
+
+            buffer.last_output_size = output.size() - start;
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,42 @@
+#include "cpp_server/utils/mapped_file.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        MappedFile::MappedFile(const std::string &path)
+        {
+            int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                return;
+            }
+
+            struct stat file_stat;
+            if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0)
+            {
+                void *addr = mmap(nullptr, file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    data_ = addr;
+                    size_ = file_stat.st_size;
+                }
+            }
+            // Mapping stays valid after the descriptor is closed.
+            close(fd);
+        }
+
+        MappedFile::~MappedFile()
+        {
+            if (data_ != nullptr)
+            {
+                munmap(data_, size_);
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,142 @@
+#include "cpp_server/utils/multipart.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+static std::string to_lower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c)
+                   { return std::tolower(c); });
+    return value;
+}
+
+static std::string trim(const std::string &value)
+{
+    size_t first = value.find_first_not_of(" \t");
+    if (first == std::string::npos)
+    {
+        return "";
+    }
+    size_t last = value.find_last_not_of(" \t");
+    return value.substr(first, last - first + 1);
+}
+
+/// @brief Get a parameter of a header value such as `form-data; name="image"`, quotes are removed.
+static std::string header_parameter(const std::string &header, const std::string &key)
+{
+    size_t pos = 0;
+    while ((pos = header.find(';', pos)) != std::string::npos)
+    {
+        ++pos;
+        size_t eq = header.find('=', pos);
+        if (eq == std::string::npos)
+        {
+            break;
+        }
+        if (to_lower(trim(header.substr(pos, eq - pos))) != key)
+        {
+            continue;
+        }
+
+        size_t start = eq + 1;
+        if (start < header.size() && header[start] == '"')
+        {
+            size_t end = header.find('"', start + 1);
+            return header.substr(start + 1, end == std::string::npos ? std::string::npos : end - start - 1);
+        }
+        size_t end = header.find(';', start);
+        return trim(header.substr(start, end == std::string::npos ? std::string::npos : end - start));
+    }
+    return "";
+}
+
+static const char *find(const char *begin, const char *end, const std::string &pattern)
+{
+    const char *pos = std::search(begin, end, pattern.begin(), pattern.end());
+    return pos == end ? nullptr : pos;
+}
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        bool multipart_boundary(const std::string &content_type, std::string &boundary)
+        {
+            if (to_lower(trim(content_type.substr(0, content_type.find(';')))) != "multipart/form-data")
+            {
+                return false;
+            }
+            boundary = header_parameter(content_type, "boundary");
+            return !boundary.empty();
+        }
+
+        Error parse_multipart(const char *body, const size_t &size, const std::string &boundary, std::vector<MultipartPart> &parts)
+        {
+            const char *end = body + size;
+            const std::string delimiter = "--" + boundary;
+            const std::string next_delimiter = "\r\n" + delimiter;
+
+            // Anything before the first delimiter is a preamble and ignored.
+            const char *pos = find(body, end, delimiter);
+            if (!pos)
+            {
+                return Error(Error::Code::INVALID_DATA, "Multipart boundary not found");
+            }
+            pos += delimiter.size();
+
+            while (true)
+            {
+                if (end - pos >= 2 && pos[0] == '-' && pos[1] == '-')
+                {
+                    return Error::Success;
+                }
+                if (end - pos < 2 || pos[0] != '\r' || pos[1] != '\n')
+                {
+                    return Error(Error::Code::INVALID_DATA, "Malformed multipart delimiter");
+                }
+                pos += 2;
+
+                const char *headers_end = find(pos, end, "\r\n\r\n");
+                if (!headers_end)
+                {
+                    return Error(Error::Code::INVALID_DATA, "Malformed multipart headers");
+                }
+
+                MultipartPart part;
+                const char *line = pos;
+                while (line < headers_end)
+                {
+                    const char *line_end = find(line, headers_end, "\r\n");
+                    line_end = line_end ? line_end : headers_end;
+                    const char *colon = std::find(line, line_end, ':');
+                    if (colon != line_end)
+                    {
+                        std::string name = to_lower(trim(std::string(line, colon)));
+                        std::string value = trim(std::string(colon + 1, line_end));
+                        if (name == "content-disposition")
+                        {
+                            part.name = header_parameter(value, "name");
+                            part.filename = header_parameter(value, "filename");
+                        }
+                        else if (name == "content-type")
+                        {
+                            part.content_type = value;
+                        }
+                    }
+                    line = line_end + 2;
+                }
+
+                part.data = headers_end + 4;
+                const char *part_end = find(part.data, end, next_delimiter);
+                if (!part_end)
+                {
+                    return Error(Error::Code::INVALID_DATA, "Multipart body is not terminated");
+                }
+                part.size = part_end - part.data;
+                parts.push_back(std::move(part));
+                pos = part_end + next_delimiter.size();
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,171 @@
+#include "cpp_server/utils/normalize.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+    /// @brief Convert one row, channel c of every pixel goes to dst[c] as src * scale[c] + bias[c].
+    typedef void (*RowKernel)(const uint8_t *src, const int &width, const float *scale, const float *bias, float *const *dst);
+
+    void row_scalar(const uint8_t *src, const int &width, const float *scale, const float *bias, float *const *dst)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            dst[0][x] = src[3 * x] * scale[0] + bias[0];
+            dst[1][x] = src[3 * x + 1] * scale[1] + bias[1];
+            dst[2][x] = src[3 * x + 2] * scale[2] + bias[2];
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // Byte shuffles gathering channel c of 16 pixels from three 16-byte loads, -1 zeroes the byte.
+    alignas(16) const int8_t deinterleave_masks[3][3][16] = {
+        {{0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13}},
+        {{1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14}},
+        {{2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1},
+         {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15}}};
+
+    __attribute__((target("ssse3"))) inline __m128i deinterleave(const __m128i &a0, const __m128i &a1, const __m128i &a2, const int &c)
+    {
+        __m128i m0 = _mm_load_si128(reinterpret_cast<const __m128i *>(deinterleave_masks[c][0]));
+        __m128i m1 = _mm_load_si128(reinterpret_cast<const __m128i *>(deinterleave_masks[c][1]));
+        __m128i m2 = _mm_load_si128(reinterpret_cast<const __m128i *>(deinterleave_masks[c][2]));
+        return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, m0), _mm_shuffle_epi8(a1, m1)), _mm_shuffle_epi8(a2, m2));
+    }
+
+    __attribute__((target("avx2,fma"))) void row_avx2(const uint8_t *src, const int &width, const float *scale, const float *bias, float *const *dst)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8_t *p = src + 3 * x;
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+            __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+            for (int c = 0; c < 3; ++c)
+            {
+                __m128i v = deinterleave(a0, a1, a2, c);
+                __m256 s = _mm256_set1_ps(scale[c]);
+                __m256 b = _mm256_set1_ps(bias[c]);
+                __m256 lo = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(v));
+                __m256 hi = _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+                _mm256_storeu_ps(dst[c] + x, _mm256_fmadd_ps(lo, s, b));
+                _mm256_storeu_ps(dst[c] + x + 8, _mm256_fmadd_ps(hi, s, b));
+            }
+        }
+        float *const tail[3] = {dst[0] + x, dst[1] + x, dst[2] + x};
+        row_scalar(src + 3 * x, width - x, scale, bias, tail);
+    }
+
+    __attribute__((target("avx512f,avx512bw"))) void row_avx512(const uint8_t *src, const int &width, const float *scale, const float *bias, float *const *dst)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            const uint8_t *p = src + 3 * x;
+            __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+            __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+            __m128i a2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 32));
+            for (int c = 0; c < 3; ++c)
+            {
+                __m512 v = _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(deinterleave(a0, a1, a2, c)));
+                _mm512_storeu_ps(dst[c] + x, _mm512_fmadd_ps(v, _mm512_set1_ps(scale[c]), _mm512_set1_ps(bias[c])));
+            }
+        }
+        float *const tail[3] = {dst[0] + x, dst[1] + x, dst[2] + x};
+        row_scalar(src + 3 * x, width - x, scale, bias, tail);
+    }
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+    inline void store_neon(const uint8x16_t &v, const float32x4_t &scale, const float32x4_t &bias, float *dst)
+    {
+        uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+        uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+        vst1q_f32(dst, vmlaq_f32(bias, vcvtq_f32_u32(vmovl_u16(vget_low_u16(lo))), scale));
+        vst1q_f32(dst + 4, vmlaq_f32(bias, vcvtq_f32_u32(vmovl_u16(vget_high_u16(lo))), scale));
+        vst1q_f32(dst + 8, vmlaq_f32(bias, vcvtq_f32_u32(vmovl_u16(vget_low_u16(hi))), scale));
+        vst1q_f32(dst + 12, vmlaq_f32(bias, vcvtq_f32_u32(vmovl_u16(vget_high_u16(hi))), scale));
+    }
+
+    void row_neon(const uint8_t *src, const int &width, const float *scale, const float *bias, float *const *dst)
+    {
+        int x = 0;
+        for (; x + 16 <= width; x += 16)
+        {
+            // vld3q deinterleaves the three channels of 16 pixels.
+            uint8x16x3_t px = vld3q_u8(src + 3 * x);
+            for (int c = 0; c < 3; ++c)
+            {
+                store_neon(px.val[c], vdupq_n_f32(scale[c]), vdupq_n_f32(bias[c]), dst[c] + x);
+            }
+        }
+        float *const tail[3] = {dst[0] + x, dst[1] + x, dst[2] + x};
+        row_scalar(src + 3 * x, width - x, scale, bias, tail);
+    }
+#endif
+
+    RowKernel select_kernel(const cpp_server::utils::SimdLevel &level)
+    {
+        if (!cpp_server::utils::simdSupported(level))
+        {
+            return row_scalar;
+        }
+        switch (level)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case cpp_server::utils::SimdLevel::AVX512:
+            return row_avx512;
+        case cpp_server::utils::SimdLevel::AVX2:
+            return row_avx2;
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+        case cpp_server::utils::SimdLevel::NEON:
+            return row_neon;
+#endif
+        default:
+            break;
+        }
+        return row_scalar;
+    }
+} // namespace
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        void bgr_to_chw_normalize(const uint8_t *src, const size_t &src_step, const int &width, const int &height,
+                                  const bool &swap_rb, const NormalizeParams &params, float *dst,
+                                  const SimdLevel &level)
+        {
+            // Fold scaling to [0, 1] and normalization into one multiply-add per source channel.
+            const size_t plane = static_cast<size_t>(width) * height;
+            float scale[3], bias[3];
+            float *planes[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                int oc = swap_rb ? 2 - c : c;
+                scale[c] = 1.f / (255.f * params.std[oc]);
+                bias[c] = -params.mean[oc] / params.std[oc];
+                planes[c] = dst + oc * plane;
+            }
+
+            RowKernel kernel = select_kernel(level);
+            for (int y = 0; y < height; ++y)
+            {
+                float *const row_dst[3] = {planes[0] + y * width, planes[1] + y * width, planes[2] + y * width};
+                kernel(src + y * src_step, width, scale, bias, row_dst);
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,241 @@
+#include "cpp_server/utils/preprocess.hpp"
+
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <vector>
+
+static const std::map<std::string, cpp_server::utils::ResizeMode> resize_modes{
+    {"stretch", cpp_server::utils::ResizeMode::STRETCH},
+    {"letterbox", cpp_server::utils::ResizeMode::LETTERBOX},
+    {"center_crop", cpp_server::utils::ResizeMode::CENTER_CROP},
+};
+
+static const std::map<std::string, cpp_server::utils::Interpolation> interpolations{
+    {"nearest", cpp_server::utils::Interpolation::NEAREST},
+    {"linear", cpp_server::utils::Interpolation::LINEAR},
+    {"cubic", cpp_server::utils::Interpolation::CUBIC},
+    {"area", cpp_server::utils::Interpolation::AREA},
+};
+
+static const std::map<std::string, cpp_server::utils::ColorOrder> color_orders{
+    {"RGB", cpp_server::utils::ColorOrder::RGB},
+    {"BGR", cpp_server::utils::ColorOrder::BGR},
+};
+
+static const std::map<std::string, cpp_server::utils::TensorLayout> layouts{
+    {"NCHW", cpp_server::utils::TensorLayout::NCHW},
+    {"NHWC", cpp_server::utils::TensorLayout::NHWC},
+};
+
+/// @brief Images are packed to float tensors, the element type of every inference engine.
+static bool supported_datatype(const std::string &datatype)
+{
+    return datatype == "FP32";
+}
+
+template <typename E>
+static bool parse_enum(const rapidjson::Value &option, const std::map<std::string, E> &names, E &value)
+{
+    if (!option.IsString())
+    {
+        return false;
+    }
+    typename std::map<std::string, E>::const_iterator it = names.find(option.GetString());
+    if (it == names.end())
+    {
+        return false;
+    }
+    value = it->second;
+    return true;
+}
+
+static cpp_server::utils::Error invalid_option(const std::string &key)
+{
+    return cpp_server::utils::Error(cpp_server::utils::Error::Code::VALIDATION_ERROR, "Invalid value of preprocess option " + key);
+}
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        Error parse_preprocess_config(const rapidjson::Value &value, PreprocessConfig &config)
+        {
+            if (!value.IsObject())
+            {
+                return Error(Error::Code::VALIDATION_ERROR, "Preprocess config must be a JSON object");
+            }
+
+            for (rapidjson::Value::ConstMemberIterator it = value.MemberBegin(); it != value.MemberEnd(); ++it)
+            {
+                std::string key(it->name.GetString(), it->name.GetStringLength());
+                const rapidjson::Value &option = it->value;
+                if (key == "width" || key == "height")
+                {
+                    if (!option.IsInt() || option.GetInt() < 0)
+                    {
+                        return invalid_option(key);
+                    }
+                    (key == "width" ? config.width : config.height) = option.GetInt();
+                }
+                else if (key == "resize_mode")
+                {
+                    if (!parse_enum(option, resize_modes, config.resize_mode))
+                    {
+                        return invalid_option(key);
+                    }
+                }
+                else if (key == "interpolation")
+                {
+                    if (!parse_enum(option, interpolations, config.interpolation))
+                    {
+                        return invalid_option(key);
+                    }
+                }
+                else if (key == "pad_value")
+                {
+                    if (!option.IsInt() || option.GetInt() < 0 || option.GetInt() > 255)
+                    {
+                        return invalid_option(key);
+                    }
+                    config.pad_value = option.GetInt();
+                }
+                else if (key == "color_order")
+                {
+                    if (!parse_enum(option, color_orders, config.color_order))
+                    {
+                        return invalid_option(key);
+                    }
+                }
+                else if (key == "mean" || key == "std")
+                {
+                    if (!option.IsArray() || option.Size() != 3)
+                    {
+                        return invalid_option(key);
+                    }
+                    float *values = key == "mean" ? config.normalize.mean : config.normalize.std;
+                    for (rapidjson::SizeType c = 0; c < 3; ++c)
+                    {
+                        if (!option[c].IsNumber() || (key == "std" && option[c].GetDouble() <= 0))
+                        {
+                            return invalid_option(key);
+                        }
+                        values[c] = option[c].GetDouble();
+                    }
+                }
+                else if (key == "layout")
+                {
+                    if (!parse_enum(option, layouts, config.layout))
+                    {
+                        return invalid_option(key);
+                    }
+                }
+                else if (key == "datatype")
+                {
+                    if (!option.IsString() || !supported_datatype(option.GetString()))
+                    {
+                        return invalid_option(key);
+                    }
+                    config.datatype = option.GetString();
+                }
+                else
+                {
+                    return Error(Error::Code::VALIDATION_ERROR, "Unknown preprocess option " + key);
+                }
+            }
+            return Error::Success;
+        }
+
+        Error load_preprocess_config(const std::string &path, PreprocessConfig &config)
+        {
+            std::ifstream file(path);
+            if (!file)
+            {
+                return Error(Error::Code::INVALID_DATA, "Unable to open preprocess config " + path);
+            }
+            std::stringstream content;
+            content << file.rdbuf();
+
+            rapidjson::Document doc;
+            if (doc.Parse(content.str().c_str()).HasParseError())
+            {
+                return Error(Error::Code::INVALID_DATA, "Unable to parse preprocess config " + path);
+            }
+            return parse_preprocess_config(doc, config);
+        }
+
+        Error resolve_preprocess_config(const ModelConfig &model_config, PreprocessConfig &config)
+        {
+            if (config.layout == TensorLayout::AUTO)
+            {
+                config.layout = model_config.input_format_ == "FORMAT_NHWC" ? TensorLayout::NHWC : TensorLayout::NCHW;
+            }
+            if (config.datatype.empty())
+            {
+                config.datatype = model_config.input_datatype_;
+            }
+            if (!supported_datatype(config.datatype))
+            {
+                return Error(Error::Code::UNSUPPORTED, "Unsupported image tensor datatype " + config.datatype);
+            }
+
+            // Spatial dimensions of the model input, variable-size dimensions fall back to 384.
+            const std::vector<int64_t> &shape = model_config.input_shape_;
+            int64_t height = 0, width = 0;
+            if (shape.size() >= 3)
+            {
+                size_t h_index = config.layout == TensorLayout::NCHW ? shape.size() - 2 : shape.size() - 3;
+                height = shape[h_index];
+                width = shape[h_index + 1];
+            }
+            // Images are packed at the configured size, a fixed model dimension can't take another one.
+            if ((width > 0 && config.width > 0 && config.width != width) || (height > 0 && config.height > 0 && config.height != height))
+            {
+                return Error(Error::Code::VALIDATION_ERROR, "Image size " + std::to_string(config.width) + "x" + std::to_string(config.height) +
+                                                                " doesn't match model input size " + std::to_string(width) + "x" + std::to_string(height));
+            }
+            if (config.width <= 0)
+            {
+                config.width = width > 0 ? width : 384;
+            }
+            if (config.height <= 0)
+            {
+                config.height = height > 0 ? height : 384;
+            }
+            return Error::Success;
+        }
+
+        void pack_image(const uint8_t *src, const size_t &src_step, const int &width, const int &height,
+                        const PreprocessConfig &config, float *dst, const SimdLevel &level)
+        {
+            const bool swap_rb = config.color_order == ColorOrder::RGB;
+            if (config.layout != TensorLayout::NHWC)
+            {
+                bgr_to_chw_normalize(src, src_step, width, height, swap_rb, config.normalize, dst, level);
+                return;
+            }
+
+            // Interleaved output keeps the pixel order, channels are reordered and normalized in place.
+            float scale[3], bias[3];
+            for (int c = 0; c < 3; ++c)
+            {
+                int oc = swap_rb ? 2 - c : c;
+                scale[c] = 1.f / (255.f * config.normalize.std[oc]);
+                bias[c] = -config.normalize.mean[oc] / config.normalize.std[oc];
+            }
+            for (int y = 0; y < height; ++y)
+            {
+                const uint8_t *pixels = src + y * src_step;
+                float *out = dst + y * 3 * width;
+                for (int x = 0; x < width; ++x)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        int oc = swap_rb ? 2 - c : c;
+                        out[3 * x + oc] = pixels[3 * x + c] * scale[c] + bias[c];
+                    }
+                }
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,62 @@
+#include "cpp_server/utils/shared_memory.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        SharedMemoryRegion::SharedMemoryRegion(const std::string &key, const size_t &byte_size, const bool &create)
+            : key_(key)
+        {
+            if (byte_size == 0)
+            {
+                return;
+            }
+
+            int flags = create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR;
+            int fd = shm_open(key.c_str(), flags, S_IRUSR | S_IWUSR);
+            if (fd < 0)
+            {
+                return;
+            }
+            if (create && ftruncate(fd, byte_size) != 0)
+            {
+                close(fd);
+                shm_unlink(key.c_str());
+                return;
+            }
+
+            void *addr = mmap(nullptr, byte_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            // Mapping stays valid after the descriptor is closed.
+            close(fd);
+            if (addr == MAP_FAILED)
+            {
+                if (create)
+                {
+                    shm_unlink(key.c_str());
+                }
+                return;
+            }
+
+            data_ = addr;
+            size_ = byte_size;
+            owner_ = create;
+        }
+
+        SharedMemoryRegion::~SharedMemoryRegion()
+        {
+            if (data_ != nullptr)
+            {
+                munmap(data_, size_);
+            }
+            if (owner_)
+            {
+                shm_unlink(key_.c_str());
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
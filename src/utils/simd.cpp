@@ -0,0 +1,68 @@
+#include "cpp_server/utils/simd.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        bool simdSupported(const SimdLevel &level)
+        {
+            switch (level)
+            {
+            case SimdLevel::SCALAR:
+                return true;
+#if defined(__x86_64__) || defined(__i386__)
+            case SimdLevel::SSSE3:
+                return __builtin_cpu_supports("ssse3");
+            case SimdLevel::AVX2:
+                return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+            case SimdLevel::AVX512:
+                return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+            case SimdLevel::NEON:
+                return true;
+#endif
+            default:
+                break;
+            }
+            return false;
+        }
+
+        SimdLevel detectSimdLevel()
+        {
+            static const SimdLevel level = []()
+            {
+                const SimdLevel levels[] = {SimdLevel::NEON, SimdLevel::AVX512, SimdLevel::AVX2, SimdLevel::SSSE3};
+                for (const SimdLevel &l : levels)
+                {
+                    if (simdSupported(l))
+                    {
+                        return l;
+                    }
+                }
+                return SimdLevel::SCALAR;
+            }();
+            return level;
+        }
+
+        const char *simdLevelName(const SimdLevel &level)
+        {
+            switch (level)
+            {
+            case SimdLevel::SCALAR:
+                return "SCALAR";
+            case SimdLevel::SSSE3:
+                return "SSSE3";
+            case SimdLevel::AVX2:
+                return "AVX2";
+            case SimdLevel::AVX512:
+                return "AVX512";
+            case SimdLevel::NEON:
+                return "NEON";
+            default:
+                break;
+            }
+            return "<invalid level>";
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,235 @@
+#include "cpp_server/utils/softmax.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+    /// @brief Softmax of one row in place, max subtracted for numerical stability.
+    typedef void (*SoftmaxKernel)(float *data, const size_t &size);
+
+    void softmax_scalar(float *data, const size_t &size)
+    {
+        float max_value = -std::numeric_limits<float>::infinity();
+        for (size_t i = 0; i < size; ++i)
+        {
+            max_value = std::max(max_value, data[i]);
+        }
+        float sum = 0.f;
+        for (size_t i = 0; i < size; ++i)
+        {
+            data[i] = std::exp(data[i] - max_value);
+            sum += data[i];
+        }
+        const float scale = 1.f / sum;
+        for (size_t i = 0; i < size; ++i)
+        {
+            data[i] *= scale;
+        }
+    }
+
+#if defined(__x86_64__) || defined(__i386__)
+    // exp(x) = 2^n * exp(r) with n = round(x / ln2) and |r| <= ln2 / 2, exp(r) from the Cephes expf polynomial.
+    // Inputs are clamped to the normal float range, which only affects probabilities below 1e-38.
+    const float exp_lo = -87.3365447f;
+    const float exp_hi = 88.3762626f;
+    const float log2e = 1.44269504088896341f;
+    const float ln2_hi = 0.693359375f;
+    const float ln2_lo = -2.12194440e-4f;
+    const float exp_poly[6] = {1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f, 4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+
+    __attribute__((target("avx2,fma"))) inline __m256 exp_avx2(__m256 x)
+    {
+        x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(exp_lo)), _mm256_set1_ps(exp_hi));
+        __m256 n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2_hi), x);
+        r = _mm256_fnmadd_ps(n, _mm256_set1_ps(ln2_lo), r);
+
+        __m256 y = _mm256_set1_ps(exp_poly[0]);
+        for (int i = 1; i < 6; ++i)
+        {
+            y = _mm256_fmadd_ps(y, r, _mm256_set1_ps(exp_poly[i]));
+        }
+        y = _mm256_fmadd_ps(y, _mm256_mul_ps(r, r), _mm256_add_ps(r, _mm256_set1_ps(1.f)));
+
+        __m256i exponent = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+        return _mm256_mul_ps(y, _mm256_castsi256_ps(exponent));
+    }
+
+    __attribute__((target("avx2,fma"))) void softmax_avx2(float *data, const size_t &size)
+    {
+        size_t i = 0;
+        __m256 max_vec = _mm256_set1_ps(-std::numeric_limits<float>::infinity());
+        for (; i + 8 <= size; i += 8)
+        {
+            max_vec = _mm256_max_ps(max_vec, _mm256_loadu_ps(data + i));
+        }
+        alignas(32) float lanes[8];
+        _mm256_store_ps(lanes, max_vec);
+        float max_value = *std::max_element(lanes, lanes + 8);
+        for (; i < size; ++i)
+        {
+            max_value = std::max(max_value, data[i]);
+        }
+
+        const __m256 max_broadcast = _mm256_set1_ps(max_value);
+        __m256 sum_vec = _mm256_setzero_ps();
+        for (i = 0; i + 8 <= size; i += 8)
+        {
+            __m256 e = exp_avx2(_mm256_sub_ps(_mm256_loadu_ps(data + i), max_broadcast));
+            _mm256_storeu_ps(data + i, e);
+            sum_vec = _mm256_add_ps(sum_vec, e);
+        }
+        _mm256_store_ps(lanes, sum_vec);
+        float sum = 0.f;
+        for (int l = 0; l < 8; ++l)
+        {
+            sum += lanes[l];
+        }
+        // The tail goes through the same approximation, so every value is rounded alike.
+        if (i < size)
+        {
+            std::fill(lanes, lanes + 8, 0.f);
+            std::copy(data + i, data + size, lanes);
+            _mm256_store_ps(lanes, exp_avx2(_mm256_sub_ps(_mm256_load_ps(lanes), max_broadcast)));
+            for (size_t l = 0; i + l < size; ++l)
+            {
+                data[i + l] = lanes[l];
+                sum += lanes[l];
+            }
+        }
+
+        const __m256 scale = _mm256_set1_ps(1.f / sum);
+        for (i = 0; i + 8 <= size; i += 8)
+        {
+            _mm256_storeu_ps(data + i, _mm256_mul_ps(_mm256_loadu_ps(data + i), scale));
+        }
+        for (; i < size; ++i)
+        {
+            data[i] *= 1.f / sum;
+        }
+    }
+
+    __attribute__((target("avx512f"))) inline __m512 exp_avx512(__m512 x)
+    {
+        x = _mm512_min_ps(_mm512_max_ps(x, _mm512_set1_ps(exp_lo)), _mm512_set1_ps(exp_hi));
+        __m512 n = _mm512_roundscale_ps(_mm512_mul_ps(x, _mm512_set1_ps(log2e)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2_hi), x);
+        r = _mm512_fnmadd_ps(n, _mm512_set1_ps(ln2_lo), r);
+
+        __m512 y = _mm512_set1_ps(exp_poly[0]);
+        for (int i = 1; i < 6; ++i)
+        {
+            y = _mm512_fmadd_ps(y, r, _mm512_set1_ps(exp_poly[i]));
+        }
+        y = _mm512_fmadd_ps(y, _mm512_mul_ps(r, r), _mm512_add_ps(r, _mm512_set1_ps(1.f)));
+
+        __m512i exponent = _mm512_slli_epi32(_mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+        return _mm512_mul_ps(y, _mm512_castsi512_ps(exponent));
+    }
+
+    __attribute__((target("avx512f"))) void softmax_avx512(float *data, const size_t &size)
+    {
+        // Masked loads and stores handle the tail without a scalar loop.
+        const __m512 neg_inf = _mm512_set1_ps(-std::numeric_limits<float>::infinity());
+        __m512 max_vec = neg_inf;
+        for (size_t i = 0; i < size; i += 16)
+        {
+            __mmask16 mask = size - i >= 16 ? 0xffff : static_cast<__mmask16>((1u << (size - i)) - 1);
+            max_vec = _mm512_max_ps(max_vec, _mm512_mask_loadu_ps(neg_inf, mask, data + i));
+        }
+        const __m512 max_broadcast = _mm512_set1_ps(_mm512_reduce_max_ps(max_vec));
+
+        __m512 sum_vec = _mm512_setzero_ps();
+        for (size_t i = 0; i < size; i += 16)
+        {
+            __mmask16 mask = size - i >= 16 ? 0xffff : static_cast<__mmask16>((1u << (size - i)) - 1);
+            __m512 e = exp_avx512(_mm512_sub_ps(_mm512_maskz_loadu_ps(mask, data + i), max_broadcast));
+            _mm512_mask_storeu_ps(data + i, mask, e);
+            sum_vec = _mm512_mask_add_ps(sum_vec, mask, sum_vec, e);
+        }
+
+        const __m512 scale = _mm512_set1_ps(1.f / _mm512_reduce_add_ps(sum_vec));
+        for (size_t i = 0; i < size; i += 16)
+        {
+            __mmask16 mask = size - i >= 16 ? 0xffff : static_cast<__mmask16>((1u << (size - i)) - 1);
+            _mm512_mask_storeu_ps(data + i, mask, _mm512_mul_ps(_mm512_maskz_loadu_ps(mask, data + i), scale));
+        }
+    }
+#endif
+
+    SoftmaxKernel select_kernel(const cpp_server::utils::SimdLevel &level)
+    {
+        if (!cpp_server::utils::simdSupported(level))
+        {
+            return softmax_scalar;
+        }
+        switch (level)
+        {
+#if defined(__x86_64__) || defined(__i386__)
+        case cpp_server::utils::SimdLevel::AVX512:
+            return softmax_avx512;
+        case cpp_server::utils::SimdLevel::AVX2:
+            return softmax_avx2;
+#endif
+        default:
+            break;
+        }
+        return softmax_scalar;
+    }
+
+    /// @brief Order of the top-k heap, the root is the smallest value with the highest index.
+    bool ranks_higher(const std::pair<int, float> &a, const std::pair<int, float> &b)
+    {
+        return a.second > b.second || (a.second == b.second && a.first < b.first);
+    }
+} // namespace
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        void softmax(float *data, const size_t &size, const SimdLevel &level)
+        {
+            if (size == 0)
+            {
+                return;
+            }
+            select_kernel(level)(data, size);
+        }
+
+        void top_k(const float *data, const size_t &size, const size_t &k, std::vector<std::pair<int, float>> &output)
+        {
+            output.clear();
+            const size_t count = std::min(k, size);
+            if (count == 0)
+            {
+                return;
+            }
+
+            // Min-heap of the best k seen so far, a value only enters if it beats the root.
+            output.reserve(count);
+            for (size_t i = 0; i < size; ++i)
+            {
+                std::pair<int, float> candidate(static_cast<int>(i), data[i]);
+                if (output.size() < count)
+                {
+                    output.push_back(candidate);
+                    std::push_heap(output.begin(), output.end(), ranks_higher);
+                }
+                else if (ranks_higher(candidate, output.front()))
+                {
+                    std::pop_heap(output.begin(), output.end(), ranks_higher);
+                    output.back() = candidate;
+                    std::push_heap(output.begin(), output.end(), ranks_higher);
+                }
+            }
+            std::sort_heap(output.begin(), output.end(), ranks_higher);
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,62 @@
+#include "cpp_server/utils/thread_pool.hpp"
+
+namespace cpp_server
+{
+    namespace utils
+    {
+        ThreadPool::ThreadPool(const size_t &num_threads)
+        {
+            size_t n = num_threads > 0 ? num_threads : 1;
+            workers.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+            {
+                workers.emplace_back(&ThreadPool::run, this);
+            }
+        }
+
+        ThreadPool::~ThreadPool()
+        {
+            {
+                std::unique_lock<std::mutex> lock(tasks_mutex);
+                stop = true;
+            }
+            tasks_cv.notify_all();
+            for (std::thread &worker : workers)
+            {
+                if (worker.joinable())
+                {
+                    worker.join();
+                }
+            }
+        }
+
+        void ThreadPool::submit(std::function<void()> task)
+        {
+            {
+                std::unique_lock<std::mutex> lock(tasks_mutex);
+                tasks.push_back(std::move(task));
+            }
+            tasks_cv.notify_one();
+        }
+
+        void ThreadPool::run()
+        {
+            while (true)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(tasks_mutex);
+                    tasks_cv.wait(lock, [this]()
+                                  { return stop || !tasks.empty(); });
+                    if (tasks.empty())
+                    {
+                        break;
+                    }
+                    task = std::move(tasks.front());
+                    tasks.pop_front();
+                }
+                task();
+            }
+        }
+    } // namespace utils
+} // namespace cpp_server
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <boost/fiber/all.hpp>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/admission.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+TEST(AdmissionController, in_flight_is_bounded)
+{
+    cps_utils::AdmissionConfig config;
+    config.max_in_flight = 2;
+    config.max_queue_delay_us = -1;
+    cps_utils::AdmissionController controller(config);
+
+    const int num_requests = 6;
+    int active = 0, max_active = 0;
+    std::vector<cps_utils::Error> errors(num_requests);
+    std::vector<boost::fibers::fiber> fibers;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        fibers.emplace_back([&, i]()
+                            {
+                                cps_utils::AdmissionController::Ticket ticket;
+                                errors[i] = controller.admit(cps_utils::no_deadline(), ticket);
+                                if (!errors[i].IsOk())
+                                {
+                                    return;
+                                }
+                                max_active = std::max(max_active, ++active);
+                                boost::this_fiber::sleep_for(std::chrono::milliseconds(5));
+                                --active; });
+    }
+    for (boost::fibers::fiber &f : fibers)
+    {
+        f.join();
+    }
+
+    for (const cps_utils::Error &err : errors)
+    {
+        EXPECT_TRUE(err.IsOk()) << err.AsString();
+    }
+    EXPECT_EQ(max_active, 2);
+    EXPECT_EQ(controller.inFlight(), 0);
+    EXPECT_EQ(controller.queued(), 0);
+}
+
+TEST(AdmissionController, full_queue_is_rejected)
+{
+    cps_utils::AdmissionConfig config;
+    config.max_in_flight = 1;
+    config.max_queue = 1;
+    config.max_queue_delay_us = -1;
+    cps_utils::AdmissionController controller(config);
+
+    cps_utils::AdmissionController::Ticket ticket;
+    ASSERT_TRUE(controller.admit(cps_utils::no_deadline(), ticket).IsOk());
+
+    cps_utils::Error queued_err;
+    boost::fibers::fiber queued([&]()
+                                {
+                                    cps_utils::AdmissionController::Ticket other;
+                                    queued_err = controller.admit(cps_utils::no_deadline(), other); });
+    boost::this_fiber::yield();
+    EXPECT_EQ(controller.queued(), 1);
+
+    cps_utils::AdmissionController::Ticket rejected;
+    EXPECT_EQ(controller.admit(cps_utils::no_deadline(), rejected).ErrorCode(), cps_utils::Error::Code::RESOURCE_EXHAUSTED);
+    EXPECT_GE(controller.retryAfter(), 1);
+
+    ticket.reset();
+    queued.join();
+    EXPECT_TRUE(queued_err.IsOk()) << queued_err.AsString();
+    EXPECT_EQ(controller.inFlight(), 0);
+}
+
+TEST(AdmissionController, deadlines)
+{
+    cps_utils::AdmissionConfig config;
+    config.max_in_flight = 1;
+    config.max_queue_delay_us = 1000;
+    cps_utils::AdmissionController controller(config);
+
+    cps_utils::AdmissionController::Ticket ticket;
+    EXPECT_EQ(controller.admit(std::chrono::steady_clock::now(), ticket).ErrorCode(), cps_utils::Error::Code::DEADLINE_EXCEEDED);
+
+    // Record a service time of about 20ms.
+    ASSERT_TRUE(controller.admit(cps_utils::no_deadline(), ticket).IsOk());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    ticket.reset();
+
+    cps_utils::AdmissionController::Ticket holder;
+    ASSERT_TRUE(controller.admit(cps_utils::no_deadline(), holder).IsOk());
+    // The expected wait is longer than the queue delay, rejected without waiting.
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    cps_utils::AdmissionController::Ticket rejected;
+    EXPECT_EQ(controller.admit(cps_utils::no_deadline(), rejected).ErrorCode(), cps_utils::Error::Code::UNAVAILABLE);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(1));
+    EXPECT_EQ(controller.queued(), 0);
+}
+
+TEST(AdmissionController, waiting_times_out)
+{
+    cps_utils::AdmissionConfig config;
+    config.max_in_flight = 1;
+    config.max_queue_delay_us = 2000;
+    cps_utils::AdmissionController controller(config);
+
+    cps_utils::AdmissionController::Ticket holder, ticket;
+    ASSERT_TRUE(controller.admit(cps_utils::no_deadline(), holder).IsOk());
+    EXPECT_EQ(controller.admit(cps_utils::no_deadline(), ticket).ErrorCode(), cps_utils::Error::Code::UNAVAILABLE);
+    EXPECT_EQ(controller.queued(), 0);
+}
+
+TEST(AdmissionController, parse_request_timeout)
+{
+    cps_utils::Deadline deadline;
+    ASSERT_TRUE(cps_utils::parse_request_timeout("", deadline).IsOk());
+    EXPECT_EQ(deadline, cps_utils::no_deadline());
+
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    ASSERT_TRUE(cps_utils::parse_request_timeout("250", deadline).IsOk());
+    EXPECT_GE(deadline, now + std::chrono::milliseconds(250));
+    EXPECT_LT(deadline, now + std::chrono::milliseconds(1250));
+
+    EXPECT_EQ(cps_utils::parse_request_timeout("0", deadline).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+    EXPECT_EQ(cps_utils::parse_request_timeout("-5", deadline).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+    EXPECT_EQ(cps_utils::parse_request_timeout("10ms", deadline).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+}
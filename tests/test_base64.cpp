@@ -1,4 +1,7 @@
+#include <chrono>
 #include <iostream>
+#include <random>
+#include <vector>
 #include <gtest/gtest.h>
 #include "cpp_server/utils/base64.hpp"
 
@@ -99,3 +102,105 @@ TEST(Base64, invalid_encoded)
         EXPECT_EQ(err.what(), std::string("Input is not valid base64-encoded data."));
     }
 }
+
+TEST(Base64, decode_into_buffer)
+{
+    std::string encoded = "YWJjZGUxMjM0Ky8=";
+    std::string decoded(base64_decoded_size(encoded.data(), encoded.size()), '\0');
+    ASSERT_EQ(decoded.size(), 11);
+    ASSERT_TRUE(base64_decode(encoded.data(), encoded.size(), &decoded[0], decoded.size()).IsOk());
+    EXPECT_EQ(decoded, "abcde1234+/");
+
+    // Unpadded input decodes to the same bytes.
+    std::string unpadded = "YWJjZGUxMjM0Ky8";
+    ASSERT_EQ(base64_decoded_size(unpadded.data(), unpadded.size()), 11);
+    ASSERT_TRUE(base64_decode(unpadded.data(), unpadded.size(), &decoded[0], decoded.size()).IsOk());
+    EXPECT_EQ(decoded, "abcde1234+/");
+
+    Error err = base64_decode(encoded.data(), encoded.size(), &decoded[0], decoded.size() - 1);
+    EXPECT_EQ(err.ErrorCode(), Error::Code::INVALID_DATA);
+
+    std::string invalid = "YWJ2Z?GMyMw==";
+    err = base64_decode(invalid.data(), invalid.size(), &decoded[0], base64_decoded_size(invalid.data(), invalid.size()));
+    EXPECT_EQ(err.ErrorCode(), Error::Code::INVALID_DATA);
+
+    std::string truncated = "YWJjZ";
+    err = base64_decode(truncated.data(), truncated.size(), &decoded[0], base64_decoded_size(truncated.data(), truncated.size()));
+    EXPECT_EQ(err.ErrorCode(), Error::Code::INVALID_DATA);
+}
+
+TEST(Base64, simd_matches_scalar)
+{
+    // Random lengths cover the vector blocks and every scalar tail, with and without invalid characters.
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const SimdLevel levels[] = {SimdLevel::SSSE3, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON};
+
+    for (int iter = 0; iter < 2000; ++iter)
+    {
+        std::string original(rng() % 300, '\0');
+        for (char &c : original)
+        {
+            c = static_cast<char>(byte(rng));
+        }
+        std::string encoded = base64_encode(original);
+        if (iter % 2 == 1 && !encoded.empty())
+        {
+            encoded[rng() % encoded.size()] = static_cast<char>(byte(rng));
+        }
+
+        size_t size = base64_decoded_size(encoded.data(), encoded.size());
+        std::string reference(size, '\0');
+        Error reference_err = base64_decode(encoded.data(), encoded.size(), &reference[0], size, SimdLevel::SCALAR);
+        if (iter % 2 == 0)
+        {
+            ASSERT_TRUE(reference_err.IsOk()) << reference_err.AsString();
+            ASSERT_EQ(reference, original);
+        }
+
+        for (const SimdLevel &level : levels)
+        {
+            if (!simdSupported(level))
+            {
+                continue;
+            }
+            std::string decoded(size, '\0');
+            Error err = base64_decode(encoded.data(), encoded.size(), &decoded[0], size, level);
+            ASSERT_EQ(err.ErrorCode(), reference_err.ErrorCode()) << simdLevelName(level) << " " << encoded;
+            if (err.IsOk())
+            {
+                ASSERT_EQ(decoded, reference) << simdLevelName(level);
+            }
+        }
+    }
+}
+
+TEST(Base64, throughput)
+{
+    std::mt19937 rng(7);
+    std::string original(4 << 20, '\0');
+    for (char &c : original)
+    {
+        c = static_cast<char>(rng());
+    }
+    std::string encoded = base64_encode(original);
+    std::string decoded(original.size(), '\0');
+
+    const SimdLevel levels[] = {SimdLevel::SCALAR, SimdLevel::SSSE3, SimdLevel::AVX2, SimdLevel::AVX512, SimdLevel::NEON};
+    for (const SimdLevel &level : levels)
+    {
+        if (!simdSupported(level))
+        {
+            continue;
+        }
+        const int repeats = 10;
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; ++i)
+        {
+            ASSERT_TRUE(base64_decode(encoded.data(), encoded.size(), &decoded[0], decoded.size(), level).IsOk());
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        ASSERT_EQ(decoded, original);
+        std::cout << simdLevelName(level) << ": " << repeats * encoded.size() / seconds / (1 << 20) << " MB/s" << std::endl;
+    }
+}
@@ -0,0 +1,123 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "cpp_server/utils/batch_pipeline.hpp"
+#include "cpp_server/utils/common.hpp"
+#include "cpp_server/utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+/// @brief Result of a batch whose rows hold their row index.
+static cps_utils::InferenceResult<float> batch_result(const cps_utils::BatchRange &batch, const int64_t &cols)
+{
+    cps_utils::InferenceResult<float> result;
+    result.name = "output";
+    result.shape = {batch.rows, cols};
+    result.data = cps_utils::TensorBuffer<float>(batch.rows * cols);
+    for (int64_t i = 0; i < batch.rows * cols; ++i)
+    {
+        result.data[i] = batch.offset + i / cols;
+    }
+    return result;
+}
+
+TEST(BatchPipeline, split_batches)
+{
+    std::vector<cps_utils::BatchRange> batches = cps_utils::split_batches(9, 4);
+    ASSERT_EQ(batches.size(), 3u);
+    EXPECT_EQ(batches[0].offset, 0);
+    EXPECT_EQ(batches[0].rows, 4);
+    EXPECT_EQ(batches[1].offset, 4);
+    EXPECT_EQ(batches[1].rows, 4);
+    EXPECT_EQ(batches[2].offset, 8);
+    EXPECT_EQ(batches[2].rows, 1);
+
+    EXPECT_EQ(cps_utils::split_batches(8, 4).size(), 2u);
+    EXPECT_EQ(cps_utils::split_batches(1, 1).size(), 1u);
+}
+
+TEST(BatchPipeline, max_outstanding)
+{
+    cps_utils::BatchPipeline pipeline(4, 2);
+    size_t index;
+    ASSERT_TRUE(pipeline.next(index));
+    EXPECT_EQ(index, 0u);
+    ASSERT_TRUE(pipeline.next(index));
+    EXPECT_EQ(index, 1u);
+    EXPECT_FALSE(pipeline.next(index));
+
+    // A completed batch frees room for the next one.
+    EXPECT_FALSE(pipeline.complete(cps_utils::Error::Success));
+    ASSERT_TRUE(pipeline.next(index));
+    EXPECT_EQ(index, 2u);
+    EXPECT_FALSE(pipeline.next(index));
+}
+
+TEST(BatchPipeline, out_of_order_completion)
+{
+    std::vector<cps_utils::BatchRange> batches = cps_utils::split_batches(9, 4);
+    cps_utils::BatchPipeline pipeline(batches.size(), batches.size());
+    size_t index;
+    for (size_t k = 0; k < batches.size(); ++k)
+    {
+        ASSERT_TRUE(pipeline.next(index));
+    }
+    EXPECT_FALSE(pipeline.next(index));
+
+    // Responses arrive last batch first, only the last completion finishes the request.
+    std::vector<std::vector<cps_utils::InferenceResult<float>>> batch_results(batches.size());
+    for (size_t k : {2, 0, 1})
+    {
+        batch_results[k].push_back(batch_result(batches[k], 2));
+        EXPECT_EQ(pipeline.complete(cps_utils::Error::Success), k == 1) << k;
+    }
+    EXPECT_TRUE(pipeline.error().IsOk());
+
+    std::vector<cps_utils::InferenceResult<float>> results;
+    ASSERT_TRUE(cps_utils::join_batches(batch_results, results).IsOk());
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].shape, (std::vector<int64_t>{9, 2}));
+    ASSERT_EQ(results[0].data.size(), 18u);
+    EXPECT_EQ(results[0].byte_size, 18 * sizeof(float));
+    for (size_t i = 0; i < results[0].data.size(); ++i)
+    {
+        EXPECT_EQ(results[0].data[i], i / 2) << i;
+    }
+}
+
+TEST(BatchPipeline, failure_in_middle_batch)
+{
+    cps_utils::BatchPipeline pipeline(4, 3);
+    size_t index;
+    for (size_t k = 0; k < 3; ++k)
+    {
+        ASSERT_TRUE(pipeline.next(index));
+    }
+
+    // The failed batch stops the remaining ones, the request completes once the batches in flight are done.
+    cps_utils::Error failure(cps_utils::Error::Code::INFERENCE_ERROR, "batch 1 failed");
+    EXPECT_FALSE(pipeline.complete(failure));
+    EXPECT_FALSE(pipeline.next(index));
+    EXPECT_FALSE(pipeline.complete(cps_utils::Error::Success));
+    EXPECT_TRUE(pipeline.complete(cps_utils::Error(cps_utils::Error::Code::DEADLINE_EXCEEDED, "batch 2 expired")));
+    EXPECT_EQ(pipeline.error().ErrorCode(), cps_utils::Error::Code::INFERENCE_ERROR);
+    EXPECT_FALSE(pipeline.next(index));
+}
+
+TEST(BatchPipeline, single_batch_is_passed_as_is)
+{
+    cps_utils::BatchRange batch{0, 3};
+    std::vector<std::vector<cps_utils::InferenceResult<float>>> batch_results{{batch_result(batch, 2)}};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    ASSERT_TRUE(cps_utils::join_batches(batch_results, results).IsOk());
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(results[0].data.data(), batch_results[0][0].data.data());
+    EXPECT_EQ(results[0].shape, (std::vector<int64_t>{3, 2}));
+}
+
+TEST(BatchPipeline, batches_with_different_outputs)
+{
+    std::vector<cps_utils::BatchRange> batches = cps_utils::split_batches(5, 4);
+    std::vector<std::vector<cps_utils::InferenceResult<float>>> batch_results{{batch_result(batches[0], 2)}, {}};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    EXPECT_EQ(cps_utils::join_batches(batch_results, results).ErrorCode(), cps_utils::Error::Code::INFERENCE_ERROR);
+}
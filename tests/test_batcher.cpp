@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <boost/fiber/all.hpp>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/common.hpp"
+#include "cpp_server/dynamic_batcher.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_inferencer = cpp_server::inferencer;
+
+/// @brief Engine summing each row of the input, records the batches it received.
+class SumEngine : public cps_inferencer::InferenceEngine<float>
+{
+public:
+    SumEngine(const int &max_batch_size, std::atomic<int> &calls, std::atomic<int> &max_rows)
+        : calls(calls), max_rows(max_rows)
+    {
+        model_config.max_batch_size_ = max_batch_size;
+        model_config.input_shape_ = {max_batch_size, 2};
+        status = true;
+    }
+
+    cps_utils::Error process(const std::vector<cps_utils::InferenceData<float>> &infer_data, std::vector<cps_utils::InferenceResult<float>> &infer_results)
+    {
+        int rows = infer_data[0].shape[0];
+        calls++;
+        if (rows > max_rows)
+        {
+            max_rows = rows;
+        }
+
+        cps_utils::InferenceResult<float> result;
+        result.data = cps_utils::TensorBuffer<float>(rows);
+        for (int i = 0; i < rows; ++i)
+        {
+            result.data[i] = infer_data[0].data[2 * i] + infer_data[0].data[2 * i + 1];
+        }
+        result.data_dtype = "FP32";
+        result.shape = {rows, 1};
+        result.name = "output";
+        result.byte_size = sizeof(float) * result.data.size();
+        result.status = true;
+        infer_results.push_back(result);
+        return cps_utils::Error::Success;
+    }
+
+private:
+    std::atomic<int> &calls;
+    std::atomic<int> &max_rows;
+};
+
+static cps_utils::InferenceData<float> make_data(const float &value)
+{
+    cps_utils::InferenceData<float> data;
+    data.data = {value, value};
+    data.name = "input";
+    data.data_dtype = "FP32";
+    data.shape = {1, 2};
+    return data;
+}
+
+TEST(DynamicBatcher, concurrent_requests_are_batched)
+{
+    std::atomic<int> calls{0}, max_rows{0};
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new SumEngine(4, calls, max_rows));
+
+    cps_inferencer::BatcherConfig config;
+    config.max_queue_delay_us = 100000;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, config);
+    ASSERT_TRUE(batcher.isOk());
+
+    const int num_requests = 8;
+    std::vector<cps_utils::Error> errors(num_requests);
+    std::vector<std::vector<cps_utils::InferenceResult<float>>> results(num_requests);
+    std::vector<boost::fibers::fiber> fibers;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        fibers.emplace_back([&, i]()
+                            {
+                                std::vector<cps_utils::InferenceData<float>> data{make_data(i)};
+                                errors[i] = batcher.process(data, results[i]); });
+    }
+    for (boost::fibers::fiber &f : fibers)
+    {
+        f.join();
+    }
+
+    for (int i = 0; i < num_requests; ++i)
+    {
+        ASSERT_TRUE(errors[i].IsOk()) << errors[i].AsString();
+        ASSERT_EQ(results[i].size(), 1);
+        EXPECT_EQ(results[i][0].shape, (std::vector<int64_t>{1, 1}));
+        ASSERT_EQ(results[i][0].data.size(), 1);
+        EXPECT_EQ(results[i][0].data[0], 2.f * i);
+    }
+    EXPECT_EQ(max_rows, 4);
+    EXPECT_LT(calls, num_requests);
+}
+
+TEST(DynamicBatcher, single_request_waits_at_most_queue_delay)
+{
+    std::atomic<int> calls{0}, max_rows{0};
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new SumEngine(4, calls, max_rows));
+
+    cps_inferencer::BatcherConfig config;
+    config.max_queue_delay_us = 1000;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, config);
+
+    std::vector<cps_utils::InferenceData<float>> data{make_data(3)};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    ASSERT_TRUE(batcher.process(data, results).IsOk());
+    ASSERT_EQ(results[0].data.size(), 1);
+    EXPECT_EQ(results[0].data[0], 6.f);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(DynamicBatcher, batch_size_is_bounded_by_config)
+{
+    std::atomic<int> calls{0}, max_rows{0};
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new SumEngine(8, calls, max_rows));
+
+    cps_inferencer::BatcherConfig config;
+    config.max_batch_size = 2;
+    config.max_queue_delay_us = 100000;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, config);
+
+    std::vector<boost::fibers::fiber> fibers;
+    for (int i = 0; i < 6; ++i)
+    {
+        fibers.emplace_back([&, i]()
+                            {
+                                std::vector<cps_utils::InferenceData<float>> data{make_data(i)};
+                                std::vector<cps_utils::InferenceResult<float>> results;
+                                EXPECT_TRUE(batcher.process(data, results).IsOk()); });
+    }
+    for (boost::fibers::fiber &f : fibers)
+    {
+        f.join();
+    }
+    EXPECT_EQ(max_rows, 2);
+}
+
+TEST(DynamicBatcher, invalid_engine)
+{
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, cps_inferencer::BatcherConfig{});
+    EXPECT_FALSE(batcher.isOk());
+
+    std::vector<cps_utils::InferenceData<float>> data{make_data(1)};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    EXPECT_EQ(batcher.process(data, results).ErrorCode(), cps_utils::Error::Code::INTERNAL);
+}
+
+TEST(DynamicBatcher, process_async_invokes_callback)
+{
+    std::atomic<int> calls{0}, max_rows{0};
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new SumEngine(4, calls, max_rows));
+
+    cps_inferencer::BatcherConfig config;
+    config.max_queue_delay_us = 100000;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, config);
+
+    const int num_requests = 4;
+    std::vector<std::vector<cps_utils::InferenceData<float>>> data(num_requests);
+    std::vector<float> outputs(num_requests, -1.f);
+    boost::fibers::mutex outputs_mutex;
+    boost::fibers::condition_variable outputs_cv;
+    int done = 0;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        data[i].push_back(make_data(i));
+        cps_utils::Error p_err = batcher.processAsync(
+            data[i],
+            [&, i](cps_utils::Error err, std::vector<cps_utils::InferenceResult<float>> &results)
+            {
+                std::unique_lock<boost::fibers::mutex> lock(outputs_mutex);
+                if (err.IsOk())
+                {
+                    outputs[i] = results[0].data[0];
+                }
+                done++;
+                outputs_cv.notify_all();
+            });
+        ASSERT_TRUE(p_err.IsOk());
+    }
+
+    std::unique_lock<boost::fibers::mutex> lock(outputs_mutex);
+    outputs_cv.wait(lock, [&]()
+                    { return done == num_requests; });
+    for (int i = 0; i < num_requests; ++i)
+    {
+        EXPECT_EQ(outputs[i], 2.f * i);
+    }
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(DynamicBatcher, expired_requests_are_dropped)
+{
+    std::atomic<int> calls{0}, max_rows{0};
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new SumEngine(4, calls, max_rows));
+
+    cps_inferencer::BatcherConfig config;
+    config.max_queue_delay_us = 5000;
+    cps_inferencer::DynamicBatcher<float> batcher(engine, config);
+
+    cps_utils::Error expired_err, valid_err;
+    std::vector<cps_utils::InferenceResult<float>> expired_results, valid_results;
+    boost::fibers::fiber expired([&]()
+                                 {
+                                     // Expires while it waits for the batch to fill.
+                                     std::vector<cps_utils::InferenceData<float>> data{make_data(1)};
+                                     data[0].deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(500);
+                                     expired_err = batcher.process(data, expired_results); });
+    boost::fibers::fiber valid([&]()
+                               {
+                                   std::vector<cps_utils::InferenceData<float>> data{make_data(2)};
+                                   valid_err = batcher.process(data, valid_results); });
+    expired.join();
+    valid.join();
+
+    EXPECT_EQ(expired_err.ErrorCode(), cps_utils::Error::Code::DEADLINE_EXCEEDED);
+    EXPECT_TRUE(expired_results.empty());
+    ASSERT_TRUE(valid_err.IsOk()) << valid_err.AsString();
+    EXPECT_EQ(valid_results[0].data[0], 4.f);
+    EXPECT_EQ(max_rows, 1);
+}
@@ -23,3 +23,67 @@ TEST(COMMONTools, basic_common_convertion)
     }
 
 }
+
+TEST(COMMONTools, tensor_buffer_sharing)
+{
+    cps_utils::TensorBuffer<float> buffer{1.f, 2.f, 3.f, 4.f};
+    EXPECT_EQ(buffer.size(), 4);
+    EXPECT_EQ(buffer.use_count(), 1);
+
+    // Copies and slices share the same memory.
+    cps_utils::TensorBuffer<float> copy = buffer;
+    cps_utils::TensorBuffer<float> slice = buffer.slice(2, 2);
+    EXPECT_EQ(copy.data(), buffer.data());
+    EXPECT_EQ(slice.data(), buffer.data() + 2);
+    EXPECT_EQ(slice.size(), 2);
+    EXPECT_EQ(slice[1], 4.f);
+    EXPECT_EQ(buffer.use_count(), 3);
+
+    slice[0] = 10.f;
+    EXPECT_EQ(buffer[2], 10.f);
+}
+
+TEST(COMMONTools, tensor_buffer_ownership)
+{
+    int released = 0;
+    {
+        cps_utils::TensorBuffer<float> slice;
+        {
+            float *data = new float[8];
+            cps_utils::TensorBuffer<float> buffer(data, 8, [&released](float *ptr)
+                                                  { released++; delete[] ptr; });
+            slice = buffer.slice(4, 4);
+        }
+        // Slice keeps the wrapped memory alive.
+        EXPECT_EQ(released, 0);
+    }
+    EXPECT_EQ(released, 1);
+
+    std::vector<float> external{1.f, 2.f};
+    cps_utils::TensorBuffer<float> view = cps_utils::TensorBuffer<float>::view(external.data(), external.size());
+    EXPECT_EQ(view.data(), external.data());
+    EXPECT_EQ(view.use_count(), 0);
+
+    cps_utils::TensorBuffer<float> empty;
+    EXPECT_TRUE(empty.empty());
+    EXPECT_EQ(empty.begin(), empty.end());
+}
+
+TEST(COMMONTools, model_config_lookup)
+{
+    cps_utils::ModelConfig config;
+    config.inputs_.push_back(cps_utils::TensorConfig{"image", "FP32", "FORMAT_NCHW", {1, 3, 4, 4}, 192});
+    config.inputs_.push_back(cps_utils::TensorConfig{"scale", "FP32", "FORMAT_NONE", {1, 2}, 8});
+    config.outputs_.push_back(cps_utils::TensorConfig{"boxes", "FP32", "FORMAT_NONE", {1, -1, 4}, -1});
+    config.outputs_.push_back(cps_utils::TensorConfig{"scores", "FP32", "FORMAT_NONE", {1, -1}, -1});
+
+    EXPECT_EQ(config.inputIndex("scale"), 1);
+    EXPECT_EQ(config.inputIndex("boxes"), -1);
+    EXPECT_EQ(config.outputIndex("scores"), 1);
+
+    config.syncFirstTensors();
+    EXPECT_EQ(config.input_name_, "image");
+    EXPECT_EQ(config.input_shape_, (std::vector<int64_t>{1, 3, 4, 4}));
+    EXPECT_EQ(config.input_byte_size_, 192);
+    EXPECT_EQ(config.output_name_, "boxes");
+}
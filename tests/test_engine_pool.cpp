@@ -0,0 +1,235 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/fiber/all.hpp>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/common.hpp"
+#include "cpp_server/engine_pool.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_inferencer = cpp_server::inferencer;
+
+/// @brief Engine doubling its input, fails if it is called concurrently.
+class DoubleEngine : public cps_inferencer::InferenceEngine<float>
+{
+public:
+    DoubleEngine(std::atomic<int> &active, std::atomic<int> &max_active)
+        : active(active), max_active(max_active)
+    {
+        model_config.max_batch_size_ = 4;
+        status = true;
+    }
+
+    cps_utils::Error process(const std::vector<cps_utils::InferenceData<float>> &infer_data, std::vector<cps_utils::InferenceResult<float>> &infer_results)
+    {
+        if (in_use.exchange(true))
+        {
+            return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Engine used concurrently");
+        }
+        int current = ++active;
+        int previous = max_active;
+        while (current > previous && !max_active.compare_exchange_weak(previous, current))
+        {
+        }
+        boost::this_fiber::sleep_for(std::chrono::milliseconds(5));
+        --active;
+
+        cps_utils::InferenceResult<float> result;
+        result.data = cps_utils::TensorBuffer<float>(1);
+        result.data[0] = 2.f * infer_data[0].data[0];
+        result.shape = {1, 1};
+        result.status = true;
+        infer_results.push_back(result);
+        in_use = false;
+        return cps_utils::Error::Success;
+    }
+
+private:
+    std::atomic<bool> in_use{false};
+    std::atomic<int> &active;
+    std::atomic<int> &max_active;
+};
+
+static std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> make_engines(const size_t &count, std::atomic<int> &active, std::atomic<int> &max_active)
+{
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines;
+    for (size_t i = 0; i < count; ++i)
+    {
+        engines.emplace_back(new DoubleEngine(active, max_active));
+    }
+    return engines;
+}
+
+static cps_utils::InferenceData<float> make_data(const float &value)
+{
+    cps_utils::InferenceData<float> data;
+    data.data = {value};
+    data.name = "input";
+    data.data_dtype = "FP32";
+    data.shape = {1, 1};
+    return data;
+}
+
+TEST(EnginePool, concurrency_is_bounded_by_instances)
+{
+    std::atomic<int> active{0}, max_active{0};
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines = make_engines(2, active, max_active);
+    cps_inferencer::EnginePool<float> pool(engines);
+    ASSERT_TRUE(pool.isOk());
+    EXPECT_TRUE(engines.empty());
+    EXPECT_EQ(pool.size(), 2);
+    EXPECT_EQ(pool.modelConfig().max_batch_size_, 4);
+
+    const int num_requests = 6;
+    std::vector<cps_utils::Error> errors(num_requests);
+    std::vector<std::vector<cps_utils::InferenceResult<float>>> results(num_requests);
+    std::vector<boost::fibers::fiber> fibers;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        fibers.emplace_back([&, i]()
+                            {
+                                std::vector<cps_utils::InferenceData<float>> data{make_data(i)};
+                                errors[i] = pool.process(data, results[i]); });
+    }
+    for (boost::fibers::fiber &f : fibers)
+    {
+        f.join();
+    }
+
+    for (int i = 0; i < num_requests; ++i)
+    {
+        ASSERT_TRUE(errors[i].IsOk()) << errors[i].AsString();
+        EXPECT_EQ(results[i][0].data[0], 2.f * i);
+    }
+    EXPECT_EQ(max_active, 2);
+    EXPECT_EQ(pool.available(), 2);
+}
+
+TEST(EnginePool, checkout_times_out)
+{
+    std::atomic<int> active{0}, max_active{0};
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines = make_engines(1, active, max_active);
+    cps_inferencer::EnginePoolConfig config;
+    config.checkout_timeout_us = 1000;
+    cps_inferencer::EnginePool<float> pool(engines, config);
+
+    cps_inferencer::EnginePool<float>::Lease lease;
+    ASSERT_TRUE(pool.checkout(lease).IsOk());
+    EXPECT_EQ(pool.available(), 0);
+
+    cps_inferencer::EnginePool<float>::Lease other;
+    EXPECT_EQ(pool.checkout(other).ErrorCode(), cps_utils::Error::Code::UNAVAILABLE);
+    std::vector<cps_utils::InferenceData<float>> data{make_data(1)};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    EXPECT_EQ(pool.process(data, results).ErrorCode(), cps_utils::Error::Code::UNAVAILABLE);
+
+    lease.reset();
+    EXPECT_EQ(pool.available(), 1);
+    EXPECT_TRUE(pool.checkout(other).IsOk());
+}
+
+TEST(EnginePool, waiting_request_gets_returned_engine)
+{
+    std::atomic<int> active{0}, max_active{0};
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines = make_engines(1, active, max_active);
+    cps_inferencer::EnginePoolConfig config;
+    config.checkout_timeout_us = -1;
+    cps_inferencer::EnginePool<float> pool(engines, config);
+
+    cps_inferencer::EnginePool<float>::Lease lease;
+    ASSERT_TRUE(pool.checkout(lease).IsOk());
+
+    // Returned from another thread while the request waits.
+    std::thread holder([&lease]()
+                       {
+                           std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                           lease.reset(); });
+    std::vector<cps_utils::InferenceData<float>> data{make_data(3)};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    EXPECT_TRUE(pool.process(data, results).IsOk());
+    EXPECT_EQ(results[0].data[0], 6.f);
+    holder.join();
+}
+
+TEST(EnginePool, engine_is_returned_before_callback)
+{
+    std::atomic<int> active{0}, max_active{0};
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines = make_engines(1, active, max_active);
+    cps_inferencer::EnginePool<float> pool(engines);
+
+    std::vector<cps_utils::InferenceData<float>> data{make_data(2)};
+    size_t available = 0;
+    float output = 0;
+    ASSERT_TRUE(pool.processAsync(data, [&](cps_utils::Error err, std::vector<cps_utils::InferenceResult<float>> &results)
+                                  {
+                                      available = pool.available();
+                                      output = results[0].data[0]; })
+                    .IsOk());
+    EXPECT_EQ(available, 1);
+    EXPECT_EQ(output, 4.f);
+}
+
+TEST(EnginePool, concurrent_threads_never_share_engines)
+{
+    const size_t num_engines = 3;
+    std::vector<std::atomic<bool>> in_use(num_engines);
+    std::atomic<int> active{0}, max_active{0};
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines = make_engines(num_engines, active, max_active);
+    std::vector<cps_inferencer::InferenceEngine<float> *> raw_engines;
+    for (std::unique_ptr<cps_inferencer::InferenceEngine<float>> &engine : engines)
+    {
+        raw_engines.push_back(engine.get());
+    }
+    cps_inferencer::EnginePoolConfig config;
+    config.checkout_timeout_us = -1;
+    cps_inferencer::EnginePool<float> pool(engines, config);
+
+    std::atomic<int> shared{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; ++t)
+    {
+        threads.emplace_back([&]()
+                             {
+                                 for (int i = 0; i < 500; ++i)
+                                 {
+                                     cps_inferencer::EnginePool<float>::Lease lease;
+                                     if (!pool.checkout(lease).IsOk())
+                                     {
+                                         shared++;
+                                         continue;
+                                     }
+                                     size_t index = std::find(raw_engines.begin(), raw_engines.end(), lease.get()) - raw_engines.begin();
+                                     if (index >= num_engines || in_use[index].exchange(true))
+                                     {
+                                         shared++;
+                                     }
+                                     std::this_thread::yield();
+                                     in_use[index] = false;
+                                 } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(shared, 0);
+    EXPECT_EQ(pool.available(), num_engines);
+}
+
+TEST(EnginePool, invalid_engines)
+{
+    std::vector<std::unique_ptr<cps_inferencer::InferenceEngine<float>>> engines;
+    cps_inferencer::EnginePool<float> empty_pool(engines);
+    EXPECT_FALSE(empty_pool.isOk());
+
+    engines.emplace_back(nullptr);
+    cps_inferencer::EnginePool<float> pool(engines);
+    EXPECT_FALSE(pool.isOk());
+
+    std::vector<cps_utils::InferenceData<float>> data{make_data(1)};
+    std::vector<cps_utils::InferenceResult<float>> results;
+    EXPECT_EQ(pool.process(data, results).ErrorCode(), cps_utils::Error::Code::INTERNAL);
+}
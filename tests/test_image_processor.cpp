@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <opencv2/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <rapidjson/document.h>
+#include "cpp_server/base/inference_engine.hpp"
+#include "cpp_server/image_processor.hpp"
+#include "cpp_server/utils/base64.hpp"
+#include "cpp_server/utils/error.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_inferencer = cpp_server::inferencer;
+namespace cps_processor = cpp_server::processor;
+
+/// @brief Engine rejecting batches over its max batch size, like ONNXRTEngine, records the rows of each batch.
+class BatchRecordingEngine : public cps_inferencer::InferenceEngine<float>
+{
+public:
+    BatchRecordingEngine(const int &max_batch_size, std::vector<int64_t> &batches)
+        : batches(batches)
+    {
+        this->model_config.max_batch_size_ = max_batch_size;
+        this->model_config.input_shape_ = {max_batch_size, 3, 8, 8};
+        this->batch_size = max_batch_size;
+        this->status = true;
+    }
+
+    cps_utils::Error process(const std::vector<cps_utils::InferenceData<float>> &infer_data, std::vector<cps_utils::InferenceResult<float>> &infer_results)
+    {
+        int64_t rows = infer_data[0].shape[0];
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.push_back(rows);
+        }
+        if (rows > this->model_config.max_batch_size_ || infer_data[0].data.size() != static_cast<size_t>(rows * 3 * 8 * 8))
+        {
+            return cps_utils::Error(cps_utils::Error::Code::VALIDATION_ERROR, "Unexpected batch");
+        }
+
+        // Class 1 wins for bright images, normalized pixels of dark ones are negative.
+        cps_utils::InferenceResult<float> result;
+        result.name = "output";
+        result.shape = {rows, 2};
+        result.data = cps_utils::TensorBuffer<float>(rows * 2);
+        for (int64_t i = 0; i < rows; ++i)
+        {
+            result.data[i * 2] = 0.f;
+            result.data[i * 2 + 1] = infer_data[0].data[i * 3 * 8 * 8] > 0.5f ? 10.f : -10.f;
+        }
+        infer_results.push_back(std::move(result));
+        return cps_utils::Error::Success;
+    }
+
+private:
+    std::mutex mutex;
+    std::vector<int64_t> &batches;
+};
+
+/// @brief Base64 encoded 8x8 PNG of a single color.
+static std::string encoded_image(const unsigned char &value)
+{
+    std::vector<unsigned char> png;
+    cv::imencode(".png", cv::Mat(8, 8, CV_8UC3, cv::Scalar::all(value)), png);
+    return cps_utils::base64_encode(std::string(png.begin(), png.end()));
+}
+
+TEST(ImageProcessor, images_over_max_batch_size_are_split)
+{
+    std::vector<int64_t> batches;
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new BatchRecordingEngine(4, batches));
+    cps_processor::ImageProcessor processor(engine);
+
+    // Bright images score the second class, results keep the request order.
+    const rapidjson::SizeType num_images = 9;
+    std::string data = "{\"image\": [";
+    for (rapidjson::SizeType i = 0; i < num_images; ++i)
+    {
+        data += (i ? ", \"" : "\"") + encoded_image(i % 3 == 0 ? 255 : 0) + "\"";
+    }
+    data += "]}";
+    rapidjson::Document data_doc, result_doc;
+    data_doc.Parse(data.c_str());
+
+    cps_utils::Error err = processor.process(data_doc, result_doc);
+    ASSERT_TRUE(err.IsOk()) << err.AsString();
+    EXPECT_EQ(batches, (std::vector<int64_t>{4, 4, 1}));
+
+    const rapidjson::Value &results = result_doc["results"];
+    ASSERT_EQ(results.Size(), num_images);
+    for (rapidjson::SizeType i = 0; i < num_images; ++i)
+    {
+        EXPECT_EQ(results[i]["class"].GetInt(), i % 3 == 0 ? 2 : 1) << i;
+    }
+}
+
+TEST(ImageProcessor, images_within_max_batch_size_are_one_batch)
+{
+    std::vector<int64_t> batches;
+    std::unique_ptr<cps_inferencer::InferenceEngine<float>> engine(new BatchRecordingEngine(4, batches));
+    cps_processor::ImageProcessor processor(engine);
+
+    std::string data = "{\"image\": [\"" + encoded_image(0) + "\", \"" + encoded_image(255) + "\"]}";
+    rapidjson::Document data_doc, result_doc;
+    data_doc.Parse(data.c_str());
+
+    cps_utils::Error err = processor.process(data_doc, result_doc);
+    ASSERT_TRUE(err.IsOk()) << err.AsString();
+    EXPECT_EQ(batches, (std::vector<int64_t>{2}));
+    EXPECT_EQ(result_doc["results"].Size(), 2u);
+}
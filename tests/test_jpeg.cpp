@@ -0,0 +1,66 @@
+#include <gtest/gtest.h>
+#include <string>
+#include "cpp_server/utils/jpeg.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+/// @brief Minimal JPEG header with an APP0 segment, fill bytes and a SOF marker of the given size.
+static std::string make_header(const unsigned char &sof, const int &width, const int &height)
+{
+    std::string header("\xff\xd8", 2);
+    header += std::string("\xff\xe0\x00\x06JFIF", 8);
+    header += std::string("\xff\xff", 2);
+    header += static_cast<char>(sof);
+    header += std::string("\x00\x11\x08", 3);
+    header += static_cast<char>(height >> 8);
+    header += static_cast<char>(height & 0xff);
+    header += static_cast<char>(width >> 8);
+    header += static_cast<char>(width & 0xff);
+    header += std::string("\x03\x01\x22\x00\x02\x11\x01\x03\x11\x01", 10);
+    header += std::string("\xff\xda", 2);
+    return header;
+}
+
+TEST(Jpeg, size_from_frame_header)
+{
+    int width = 0, height = 0;
+    std::string baseline = make_header(0xc0, 4032, 3024);
+    ASSERT_TRUE(cps_utils::jpeg_size(baseline.data(), baseline.size(), width, height));
+    EXPECT_EQ(width, 4032);
+    EXPECT_EQ(height, 3024);
+
+    std::string progressive = make_header(0xc2, 640, 480);
+    ASSERT_TRUE(cps_utils::jpeg_size(progressive.data(), progressive.size(), width, height));
+    EXPECT_EQ(width, 640);
+    EXPECT_EQ(height, 480);
+}
+
+TEST(Jpeg, invalid_header)
+{
+    int width = 0, height = 0;
+    std::string png("\x89PNG\r\n\x1a\n", 8);
+    EXPECT_FALSE(cps_utils::jpeg_size(png.data(), png.size(), width, height));
+
+    std::string truncated = make_header(0xc0, 640, 480).substr(0, 16);
+    EXPECT_FALSE(cps_utils::jpeg_size(truncated.data(), truncated.size(), width, height));
+
+    // DHT shares the SOF marker range but carries no frame size.
+    std::string dht = make_header(0xc4, 640, 480);
+    EXPECT_FALSE(cps_utils::jpeg_size(dht.data(), dht.size(), width, height));
+
+    EXPECT_FALSE(cps_utils::jpeg_size(nullptr, 0, width, height));
+}
+
+TEST(Jpeg, scale_denominator)
+{
+    // 12 megapixel photo into a 384x384 network, 3024 / 4 = 756 but 3024 / 8 = 378.
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(4032, 3024, 384, 384), 4);
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(4032, 3072, 384, 384), 8);
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(800, 800, 384, 384), 2);
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(700, 900, 384, 384), 1);
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(200, 200, 384, 384), 1);
+    // Odd sides round up like the scaled decoder, ceil(767 / 2) = 384.
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(767, 767, 384, 384), 2);
+    // Non square targets use the larger side.
+    EXPECT_EQ(cps_utils::jpeg_scale_denominator(1920, 1080, 256, 512), 2);
+}
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+#include "cpp_server/utils/json_writer.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+static void build_results(rapidjson::Document &doc, const int &num_results)
+{
+    doc.SetObject();
+    rapidjson::Value results(rapidjson::kArrayType);
+    for (int i = 0; i < num_results; ++i)
+    {
+        rapidjson::Value obj(rapidjson::kObjectType);
+        obj.AddMember("score", 0.123456f * i, doc.GetAllocator());
+        obj.AddMember("class", i, doc.GetAllocator());
+        results.PushBack(obj, doc.GetAllocator());
+    }
+    doc.AddMember("results", results, doc.GetAllocator());
+}
+
+TEST(JsonWriterTest, matches_string_buffer)
+{
+    cps_utils::JsonBuffer::Ptr buffer = cps_utils::JsonBuffer::acquire();
+    std::string expected, output = "prefix";
+    {
+        rapidjson::Document doc(&buffer->allocator());
+        build_results(doc, 8);
+
+        rapidjson::StringBuffer string_buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(string_buffer);
+        writer.SetMaxDecimalPlaces(3);
+        doc.Accept(writer);
+        expected = string_buffer.GetString();
+
+        cps_utils::write_json(doc, output, *buffer, 3);
+    }
+    EXPECT_EQ(output, "prefix" + expected);
+    EXPECT_EQ(buffer->last_output_size, expected.size());
+}
+
+TEST(JsonWriterTest, buffers_are_reused)
+{
+    cps_utils::JsonBuffer *first = nullptr;
+    {
+        cps_utils::JsonBuffer::Ptr buffer = cps_utils::JsonBuffer::acquire();
+        first = buffer.get();
+        rapidjson::Document doc(&buffer->allocator());
+        // Overflow the inline buffer, the released buffer must be reset.
+        build_results(doc, 4096);
+        std::string output;
+        cps_utils::write_json(doc, output, *buffer, 3);
+    }
+
+    cps_utils::JsonBuffer::Ptr buffer = cps_utils::JsonBuffer::acquire();
+    EXPECT_EQ(buffer.get(), first);
+    EXPECT_EQ(buffer->allocator().Size(), 0);
+
+    // A buffer in use is not handed out twice.
+    cps_utils::JsonBuffer::Ptr other = cps_utils::JsonBuffer::acquire();
+    EXPECT_NE(other.get(), first);
+}
+
+TEST(JsonWriterTest, small_documents_stay_inline)
+{
+    cps_utils::JsonBuffer::Ptr buffer = cps_utils::JsonBuffer::acquire();
+    size_t capacity = buffer->allocator().Capacity();
+    std::string output;
+    {
+        rapidjson::Document doc(&buffer->allocator());
+        build_results(doc, 16);
+        cps_utils::write_json(doc, output, *buffer, 3);
+    }
+    // Document and writer stack fit in the inline buffer, no chunk was allocated from the heap.
+    EXPECT_EQ(buffer->allocator().Capacity(), capacity);
+    EXPECT_GT(buffer->allocator().Size(), 0);
+}
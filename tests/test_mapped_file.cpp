@@ -0,0 +1,39 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <unistd.h>
+#include "cpp_server/utils/mapped_file.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+TEST(MappedFileTest, map_file_content)
+{
+    char path[] = "/tmp/mapped_file_XXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    close(fd);
+
+    const std::string content = "model weights";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << content;
+    }
+
+    {
+        cps_utils::MappedFile mapped(path);
+        ASSERT_TRUE(mapped.isValid());
+        ASSERT_EQ(mapped.size(), content.size());
+        EXPECT_EQ(std::memcmp(mapped.data(), content.data(), content.size()), 0);
+    }
+    unlink(path);
+}
+
+TEST(MappedFileTest, missing_file)
+{
+    cps_utils::MappedFile mapped("/tmp/mapped_file_does_not_exist");
+    EXPECT_FALSE(mapped.isValid());
+    EXPECT_EQ(mapped.data(), nullptr);
+    EXPECT_EQ(mapped.size(), 0);
+}
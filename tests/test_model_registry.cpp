@@ -0,0 +1,266 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <rapidjson/document.h>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/model_registry.hpp"
+#include "cpp_server/model_watcher.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_processor = cpp_server::processor;
+
+/// @brief Number of processors destroyed.
+static std::atomic<int> destroyed{0};
+
+/// @brief Processor answering with the model version it was created for.
+class VersionProcessor : public cps_processor::Processor
+{
+public:
+    explicit VersionProcessor(const cps_processor::ModelSpec &spec) : spec(spec) {}
+    ~VersionProcessor() { destroyed++; }
+
+    cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                             const cps_utils::Deadline &deadline = cps_utils::no_deadline())
+    {
+        return cps_utils::Error::Success;
+    }
+
+    cps_processor::ModelSpec spec;
+};
+
+/// @brief Model repository in a temporary directory, removed with its content.
+class ModelRepository : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        char path[] = "/tmp/model_repository_XXXXXX";
+        ASSERT_NE(mkdtemp(path), nullptr);
+        repository = path;
+        make_directory("resnet");
+        make_directory("resnet/1");
+        make_directory("resnet/3");
+        make_directory("resnet/latest");
+        make_directory("yolo");
+        make_directory("yolo/2");
+        make_directory(".hidden");
+        make_directory(".hidden/1");
+        std::ofstream(repository + "/resnet/3/model.onnx") << "onnx";
+    }
+
+    void TearDown()
+    {
+        std::string command = "rm -rf " + repository;
+        ASSERT_EQ(std::system(command.c_str()), 0);
+    }
+
+    void make_directory(const std::string &path)
+    {
+        ASSERT_EQ(mkdir((repository + "/" + path).c_str(), 0755), 0);
+    }
+
+    static std::unique_ptr<cps_processor::Processor> create(const cps_processor::ModelSpec &spec)
+    {
+        return std::unique_ptr<cps_processor::Processor>(new VersionProcessor(spec));
+    }
+
+    std::string repository;
+};
+
+TEST_F(ModelRepository, scan_finds_numeric_versions)
+{
+    std::vector<cps_processor::ModelSpec> specs;
+    ASSERT_TRUE(cps_processor::ModelRegistry::scan(repository, specs).IsOk());
+    ASSERT_EQ(specs.size(), 3);
+    EXPECT_EQ(specs[0].name, "resnet");
+    EXPECT_EQ(specs[0].version, "1");
+    EXPECT_EQ(specs[1].version, "3");
+    EXPECT_EQ(specs[1].model_path, repository + "/resnet");
+    EXPECT_EQ(specs[1].version_path, repository + "/resnet/3");
+    EXPECT_EQ(specs[2].name, "yolo");
+    EXPECT_EQ(specs[2].version, "2");
+    for (size_t i = 0; i < specs.size(); ++i)
+    {
+        EXPECT_EQ(specs[i].position, i);
+    }
+
+    EXPECT_EQ(cps_processor::ModelRegistry::scan(repository + "/missing", specs).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+}
+
+TEST_F(ModelRepository, requests_are_routed_by_name_and_version)
+{
+    cps_processor::ModelRegistry registry;
+    ASSERT_TRUE(registry.load(repository, &ModelRepository::create).IsOk());
+    EXPECT_EQ(registry.size(), 3);
+    EXPECT_EQ(registry.models().size(), 3);
+
+    std::shared_ptr<cps_processor::Processor> processor;
+    ASSERT_TRUE(registry.find("resnet", "", processor).IsOk());
+    EXPECT_EQ(static_cast<VersionProcessor &>(*processor).spec.version, "3");
+    ASSERT_TRUE(registry.find("resnet", "1", processor).IsOk());
+    EXPECT_EQ(static_cast<VersionProcessor &>(*processor).spec.version, "1");
+    ASSERT_TRUE(registry.find("yolo", "", processor).IsOk());
+    EXPECT_EQ(static_cast<VersionProcessor &>(*processor).spec.name, "yolo");
+
+    EXPECT_EQ(registry.find("resnet", "2", processor).ErrorCode(), cps_utils::Error::Code::NOT_FOUND);
+    EXPECT_EQ(registry.find("resnet", "latest", processor).ErrorCode(), cps_utils::Error::Code::NOT_FOUND);
+    EXPECT_EQ(registry.find("bert", "", processor).ErrorCode(), cps_utils::Error::Code::NOT_FOUND);
+}
+
+TEST_F(ModelRepository, failed_model_fails_load)
+{
+    cps_processor::ModelRegistry registry;
+    cps_utils::Error p_err = registry.load(repository, [](const cps_processor::ModelSpec &spec)
+                                           {
+                                               if (spec.name == "yolo")
+                                               {
+                                                   throw std::runtime_error("Model not found");
+                                               }
+                                               return ModelRepository::create(spec); });
+    EXPECT_EQ(p_err.ErrorCode(), cps_utils::Error::Code::INTERNAL);
+}
+
+TEST(ModelRegistry, add)
+{
+    cps_processor::ModelRegistry registry;
+    cps_processor::ModelSpec spec;
+    spec.name = "resnet";
+    spec.version = "1";
+    std::unique_ptr<cps_processor::Processor> processor(new VersionProcessor(spec));
+    ASSERT_TRUE(registry.add(spec, processor).IsOk());
+    EXPECT_FALSE(processor);
+
+    processor.reset(new VersionProcessor(spec));
+    EXPECT_EQ(registry.add(spec, processor).ErrorCode(), cps_utils::Error::Code::ALREADY_EXISTS);
+    spec.version = "v2";
+    EXPECT_EQ(registry.add(spec, processor).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+}
+
+TEST_F(ModelRepository, reload_swaps_changed_versions)
+{
+    cps_processor::ModelRegistry registry;
+    ASSERT_TRUE(registry.reload(repository, &ModelRepository::create).IsOk());
+    EXPECT_EQ(registry.size(), 3);
+
+    std::shared_ptr<cps_processor::Processor> resnet_1, resnet_3, yolo;
+    ASSERT_TRUE(registry.find("resnet", "1", resnet_1).IsOk());
+    ASSERT_TRUE(registry.find("resnet", "3", resnet_3).IsOk());
+    ASSERT_TRUE(registry.find("yolo", "", yolo).IsOk());
+
+    // Version 3 is updated, version 4 is added and yolo is removed.
+    std::ofstream(repository + "/resnet/3/model.onnx.tmp") << "onnx";
+    ASSERT_EQ(std::rename((repository + "/resnet/3/model.onnx.tmp").c_str(), (repository + "/resnet/3/model.onnx").c_str()), 0);
+    make_directory("resnet/4");
+    ASSERT_EQ(std::system(("rm -rf " + repository + "/yolo").c_str()), 0);
+
+    // Replaced versions are freed once the requests holding them are done.
+    cps_processor::Processor *replaced = resnet_3.get();
+    int destroyed_before = destroyed;
+    std::thread request([&resnet_3, &yolo]()
+                        {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                            resnet_3.reset();
+                            yolo.reset(); });
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(registry.reload(repository, &ModelRepository::create).IsOk());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+    request.join();
+    EXPECT_EQ(destroyed - destroyed_before, 2);
+
+    std::shared_ptr<cps_processor::Processor> processor;
+    ASSERT_TRUE(registry.find("resnet", "1", processor).IsOk());
+    EXPECT_EQ(processor, resnet_1);
+    ASSERT_TRUE(registry.find("resnet", "3", processor).IsOk());
+    EXPECT_NE(processor.get(), replaced);
+    ASSERT_TRUE(registry.find("resnet", "", processor).IsOk());
+    EXPECT_EQ(static_cast<VersionProcessor &>(*processor).spec.version, "4");
+    EXPECT_EQ(registry.find("yolo", "", processor).ErrorCode(), cps_utils::Error::Code::NOT_FOUND);
+}
+
+TEST_F(ModelRepository, drain_does_not_block_updates)
+{
+    cps_processor::ModelRegistry registry;
+    ASSERT_TRUE(registry.reload(repository, &ModelRepository::create).IsOk());
+    std::shared_ptr<cps_processor::Processor> yolo;
+    ASSERT_TRUE(registry.find("yolo", "", yolo).IsOk());
+
+    // The reload waits for the request holding the removed version.
+    ASSERT_EQ(std::system(("rm -rf " + repository + "/yolo").c_str()), 0);
+    std::atomic<bool> reloaded{false};
+    std::thread reload([&registry, &reloaded, this]()
+                       {
+                           registry.reload(repository, &ModelRepository::create);
+                           reloaded = true; });
+    std::shared_ptr<cps_processor::Processor> processor;
+    while (registry.find("yolo", "", processor).IsOk())
+    {
+        processor.reset();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    cps_processor::ModelSpec spec;
+    spec.name = "bert";
+    spec.version = "1";
+    std::unique_ptr<cps_processor::Processor> bert(new VersionProcessor(spec));
+    EXPECT_TRUE(registry.add(spec, bert).IsOk());
+    EXPECT_FALSE(reloaded);
+
+    int destroyed_before = destroyed;
+    yolo.reset();
+    reload.join();
+    EXPECT_EQ(destroyed - destroyed_before, 1);
+}
+
+TEST_F(ModelRepository, failed_reload_keeps_current_version)
+{
+    cps_processor::ModelRegistry registry;
+    ASSERT_TRUE(registry.reload(repository, &ModelRepository::create).IsOk());
+    std::shared_ptr<cps_processor::Processor> current;
+    ASSERT_TRUE(registry.find("yolo", "2", current).IsOk());
+
+    std::ofstream(repository + "/yolo/2/model.onnx") << "onnx";
+    cps_utils::Error p_err = registry.reload(repository, &ModelRepository::create, [](cps_processor::Processor &processor, const cps_processor::ModelSpec &spec)
+                                             { return cps_utils::Error(cps_utils::Error::Code::INFERENCE_ERROR, "Warmup failed"); });
+    EXPECT_EQ(p_err.ErrorCode(), cps_utils::Error::Code::INFERENCE_ERROR);
+
+    std::shared_ptr<cps_processor::Processor> processor;
+    ASSERT_TRUE(registry.find("yolo", "2", processor).IsOk());
+    EXPECT_EQ(processor, current);
+    EXPECT_EQ(registry.size(), 3);
+}
+
+TEST_F(ModelRepository, watcher_reloads_when_triggered)
+{
+    cps_processor::ModelRegistry registry;
+    cps_processor::WatcherConfig config;
+    config.poll_interval_ms = 0;
+    cps_processor::ModelWatcher watcher(registry, repository, &ModelRepository::create, cps_processor::ModelRegistry::WarmupFunction(), config);
+
+    watcher.trigger();
+    while (watcher.reloads() < 1)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_TRUE(watcher.status().IsOk());
+    EXPECT_EQ(registry.size(), 3);
+
+    make_directory("yolo/5");
+    watcher.trigger();
+    while (watcher.reloads() < 2)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    std::shared_ptr<cps_processor::Processor> processor;
+    ASSERT_TRUE(registry.find("yolo", "", processor).IsOk());
+    EXPECT_EQ(static_cast<VersionProcessor &>(*processor).spec.version, "5");
+}
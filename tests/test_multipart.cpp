@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "cpp_server/utils/multipart.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+TEST(Multipart, boundary)
+{
+    std::string boundary;
+    ASSERT_TRUE(cps_utils::multipart_boundary("multipart/form-data; boundary=abc123", boundary));
+    EXPECT_EQ(boundary, "abc123");
+    ASSERT_TRUE(cps_utils::multipart_boundary("Multipart/Form-Data; charset=utf-8; boundary=\"a b\"", boundary));
+    EXPECT_EQ(boundary, "a b");
+    EXPECT_FALSE(cps_utils::multipart_boundary("application/json", boundary));
+    EXPECT_FALSE(cps_utils::multipart_boundary("multipart/form-data", boundary));
+}
+
+TEST(Multipart, parts_point_into_body)
+{
+    // Binary content may contain CRLF and dashes, only CRLF followed by the delimiter ends a part.
+    std::string image("\xff\xd8\r\n--x\r\n\x00\xff\xd9", 11);
+    std::string body = "preamble\r\n"
+                       "--XyZ\r\n"
+                       "Content-Disposition: form-data; name=\"meta\"\r\n"
+                       "\r\n"
+                       "hello\r\n"
+                       "--XyZ\r\n"
+                       "content-disposition: form-data; name=\"image\"; filename=\"cat.jpg\"\r\n"
+                       "Content-Type: image/jpeg\r\n"
+                       "\r\n" +
+                       image +
+                       "\r\n--XyZ--\r\n";
+
+    std::vector<cps_utils::MultipartPart> parts;
+    cps_utils::Error err = cps_utils::parse_multipart(body.data(), body.size(), "XyZ", parts);
+    ASSERT_TRUE(err.IsOk()) << err.AsString();
+    ASSERT_EQ(parts.size(), 2);
+
+    EXPECT_EQ(parts[0].name, "meta");
+    EXPECT_EQ(std::string(parts[0].data, parts[0].size), "hello");
+
+    EXPECT_EQ(parts[1].name, "image");
+    EXPECT_EQ(parts[1].filename, "cat.jpg");
+    EXPECT_EQ(parts[1].content_type, "image/jpeg");
+    EXPECT_EQ(std::string(parts[1].data, parts[1].size), image);
+    EXPECT_GE(parts[1].data, body.data());
+    EXPECT_LT(parts[1].data, body.data() + body.size());
+}
+
+TEST(Multipart, malformed)
+{
+    std::vector<cps_utils::MultipartPart> parts;
+    std::string no_boundary = "hello";
+    EXPECT_EQ(cps_utils::parse_multipart(no_boundary.data(), no_boundary.size(), "b", parts).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+
+    std::string unterminated = "--b\r\nContent-Disposition: form-data; name=\"image\"\r\n\r\ndata";
+    EXPECT_EQ(cps_utils::parse_multipart(unterminated.data(), unterminated.size(), "b", parts).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+
+    std::string no_headers = "--b\r\nContent-Disposition: form-data";
+    EXPECT_EQ(cps_utils::parse_multipart(no_headers.data(), no_headers.size(), "b", parts).ErrorCode(), cps_utils::Error::Code::INVALID_DATA);
+}
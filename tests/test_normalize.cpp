@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "cpp_server/utils/normalize.hpp"
+#include "cpp_server/utils/simd.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+static std::vector<uint8_t> random_image(const size_t &size)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> image(size);
+    for (uint8_t &px : image)
+    {
+        px = static_cast<uint8_t>(dist(rng));
+    }
+    return image;
+}
+
+TEST(NormalizeTest, known_pixel)
+{
+    // Single BGR pixel, converted to RGB.
+    std::vector<uint8_t> image{0, 51, 255};
+    std::vector<float> output(3);
+    cps_utils::NormalizeParams params;
+    cps_utils::bgr_to_chw_normalize(image.data(), 3, 1, 1, true, params, output.data(), cps_utils::SimdLevel::SCALAR);
+
+    EXPECT_NEAR(output[0], (1.f - 0.485f) / 0.229f, 1e-5);
+    EXPECT_NEAR(output[1], (0.2f - 0.456f) / 0.224f, 1e-5);
+    EXPECT_NEAR(output[2], (0.f - 0.406f) / 0.225f, 1e-5);
+}
+
+TEST(NormalizeTest, simd_matches_scalar)
+{
+    // Odd width exercises the scalar tail, padded rows exercise the stride.
+    const int width = 53, height = 7;
+    const size_t step = 3 * width + 5;
+    std::vector<uint8_t> image = random_image(step * height);
+    cps_utils::NormalizeParams params;
+
+    for (const bool swap_rb : {false, true})
+    {
+        std::vector<float> expected(3 * width * height);
+        cps_utils::bgr_to_chw_normalize(image.data(), step, width, height, swap_rb, params, expected.data(), cps_utils::SimdLevel::SCALAR);
+        ASSERT_NEAR(expected[0], (image[swap_rb ? 2 : 0] / 255.f - params.mean[0]) / params.std[0], 1e-5);
+
+        for (const cps_utils::SimdLevel &level : {cps_utils::SimdLevel::SSSE3, cps_utils::SimdLevel::AVX2,
+                                                  cps_utils::SimdLevel::AVX512, cps_utils::SimdLevel::NEON})
+        {
+            if (!cps_utils::simdSupported(level))
+            {
+                continue;
+            }
+            std::vector<float> output(3 * width * height);
+            cps_utils::bgr_to_chw_normalize(image.data(), step, width, height, swap_rb, params, output.data(), level);
+            for (size_t i = 0; i < output.size(); ++i)
+            {
+                ASSERT_NEAR(output[i], expected[i], 1e-5) << cps_utils::simdLevelName(level) << " at " << i;
+            }
+        }
+    }
+}
@@ -0,0 +1,274 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <string>
+#include <vector>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/utils/common.hpp"
+#include "cpp_server/onnxrt_engine.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_inferencer = cpp_server::inferencer;
+
+static std::atomic<bool> count_allocations{false};
+static std::atomic<size_t> allocation_count{0};
+
+void *operator new(size_t size)
+{
+    if (count_allocations)
+    {
+        allocation_count++;
+    }
+    void *ptr = std::malloc(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static std::vector<cps_utils::InferenceData<float>> make_data(const cps_utils::ModelConfig &config)
+{
+    cps_utils::InferenceData<float> data;
+    data.shape = config.input_shape_;
+    data.shape[0] = 1;
+    data.data = cps_utils::TensorBuffer<float>(std::vector<float>(cps_utils::vectorProduct(data.shape), 0.5f));
+    data.name = config.input_name_;
+    data.data_dtype = "FP32";
+    return std::vector<cps_utils::InferenceData<float>>{data};
+}
+
+/// @brief Protobuf message writer, enough to write a small ONNX model.
+struct ProtoWriter
+{
+    ProtoWriter &varint(const int &field, const uint64_t &value)
+    {
+        key(field, 0);
+        raw_varint(value);
+        return *this;
+    }
+
+    ProtoWriter &bytes(const int &field, const std::string &value)
+    {
+        key(field, 2);
+        raw_varint(value.size());
+        buffer += value;
+        return *this;
+    }
+
+    ProtoWriter &message(const int &field, const ProtoWriter &value)
+    {
+        return bytes(field, value.buffer);
+    }
+
+    void key(const int &field, const int &wire_type)
+    {
+        raw_varint(static_cast<uint64_t>(field) << 3 | wire_type);
+    }
+
+    void raw_varint(uint64_t value)
+    {
+        for (; value >= 0x80; value >>= 7)
+        {
+            buffer += static_cast<char>((value & 0x7f) | 0x80);
+        }
+        buffer += static_cast<char>(value);
+    }
+
+    std::string buffer;
+};
+
+/// @brief ONNX value info of a tensor, float unless another element type is given.
+/// Dimensions without a name have a fixed size.
+static ProtoWriter tensor_info(const std::string &name, const std::vector<std::pair<std::string, int64_t>> &dims, const int &elem_type = 1)
+{
+    ProtoWriter shape;
+    for (const std::pair<std::string, int64_t> &dim : dims)
+    {
+        shape.message(1, dim.first.empty() ? ProtoWriter().varint(1, dim.second) : ProtoWriter().bytes(2, dim.first));
+    }
+    ProtoWriter tensor_type = ProtoWriter().varint(1, elem_type).message(2, shape);
+    return ProtoWriter().bytes(1, name).message(2, ProtoWriter().message(1, tensor_type));
+}
+
+/// @brief Write a model keeping columns 0, 2 and 3 of a [N, 4] input with Compress,
+/// the output width is only known after the run so ONNXRuntime allocates the output.
+static void write_compress_model(const std::string &path)
+{
+    ProtoWriter keep = ProtoWriter().varint(1, 4).varint(2, 9).bytes(8, "keep").bytes(9, std::string("\x01\x00\x01\x01", 4));
+    ProtoWriter axis = ProtoWriter().bytes(1, "axis").varint(3, 1).varint(20, 2);
+    ProtoWriter node = ProtoWriter().bytes(1, "x").bytes(1, "keep").bytes(2, "y").bytes(4, "Compress").message(5, axis);
+    ProtoWriter graph = ProtoWriter()
+                            .message(1, node)
+                            .bytes(2, "compress")
+                            .message(5, keep)
+                            .message(11, tensor_info("x", {{"N", 0}, {"", 4}}))
+                            .message(12, tensor_info("y", {{"N", 0}, {"K", 0}}));
+    ProtoWriter model = ProtoWriter().varint(1, 7).message(7, graph).message(8, ProtoWriter().varint(2, 13));
+    std::ofstream(path, std::ios::binary) << model.buffer;
+}
+
+/// @brief Write a model of a single node on a [N, 4] input with one INT attribute.
+/// @param path model path.
+/// @param op_type operator of the node.
+/// @param attribute name of the attribute.
+/// @param value value of the attribute.
+/// @param output value info of the node output "y".
+static void write_single_node_model(const std::string &path, const std::string &op_type, const std::string &attribute,
+                                    const int64_t &value, const ProtoWriter &output)
+{
+    ProtoWriter attr = ProtoWriter().bytes(1, attribute).varint(3, value).varint(20, 2);
+    ProtoWriter node = ProtoWriter().bytes(1, "x").bytes(2, "y").bytes(4, op_type).message(5, attr);
+    ProtoWriter graph = ProtoWriter()
+                            .message(1, node)
+                            .bytes(2, op_type)
+                            .message(11, tensor_info("x", {{"N", 0}, {"", 4}}))
+                            .message(12, output);
+    ProtoWriter model = ProtoWriter().varint(1, 7).message(7, graph).message(8, ProtoWriter().varint(2, 13));
+    std::ofstream(path, std::ios::binary) << model.buffer;
+}
+
+/// @brief Count the allocations ONNXRuntime makes itself when running a session through a preallocated IO binding.
+static size_t count_run_allocations(const std::string &model_path, const cps_inferencer::ONNXRTConfig &config, const size_t &iterations)
+{
+    cps_inferencer::ORTRunner runner(model_path, config);
+    cps_utils::ModelConfig model_config = runner.getModelConfig();
+    std::vector<float> input(cps_utils::vectorProduct(model_config.input_shape_), 0.5f);
+    std::vector<float> output(cps_utils::vectorProduct(model_config.output_shape_));
+
+    Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtAllocatorType::OrtDeviceAllocator, OrtMemType::OrtMemTypeDefault);
+    Ort::Value input_value = Ort::Value::CreateTensor<float>(memory_info, input.data(), input.size(),
+                                                             model_config.input_shape_.data(), model_config.input_shape_.size());
+    Ort::Value output_value = Ort::Value::CreateTensor<float>(memory_info, output.data(), output.size(),
+                                                              model_config.output_shape_.data(), model_config.output_shape_.size());
+    std::unique_ptr<Ort::IoBinding> binding;
+    EXPECT_TRUE(runner.createIoBinding(binding).IsOk());
+    binding->BindInput(model_config.input_name_.c_str(), input_value);
+    binding->BindOutput(model_config.output_name_.c_str(), output_value);
+    EXPECT_TRUE(runner.process(*binding).IsOk());
+
+    allocation_count = 0;
+    count_allocations = true;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        runner.process(*binding);
+    }
+    count_allocations = false;
+    return allocation_count;
+}
+
+TEST(ONNXRTEngine, steady_state_does_not_allocate)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+    // Single-threaded runs, so ONNXRuntime allocates the same on every run.
+    cps_inferencer::ONNXRTConfig config;
+    config.intra_op_num_threads = 1;
+    config.inter_op_num_threads = 1;
+    cps_inferencer::ONNXRTEngine<float> engine(model_path, 1, config);
+    ASSERT_TRUE(engine.isOk());
+
+    std::vector<cps_utils::InferenceData<float>> data = make_data(engine.modelConfig());
+    std::vector<cps_utils::InferenceResult<float>> results;
+
+    // Warm up allocates the binding slot and the results, which are reused by the following calls.
+    ASSERT_TRUE(engine.process(data, results).IsOk());
+    const float *output_ptr = results[0].data.data();
+
+    const size_t iterations = 10;
+    allocation_count = 0;
+    count_allocations = true;
+    for (size_t i = 0; i < iterations; ++i)
+    {
+        cps_utils::Error p_err = engine.process(data, results);
+        bool same_buffer = results.size() == 1 && results[0].data.data() == output_ptr;
+        count_allocations = false;
+        ASSERT_TRUE(p_err.IsOk()) << p_err.AsString();
+        ASSERT_TRUE(same_buffer);
+        count_allocations = true;
+    }
+    count_allocations = false;
+    size_t engine_allocations = allocation_count;
+
+    // Session::Run allocates its execution frame on every run, which the engine can't avoid.
+    // Those allocations are measured on a bare run of the same model and excluded.
+    size_t ort_allocations = count_run_allocations(model_path, config, iterations);
+    ASSERT_GE(engine_allocations, ort_allocations);
+    EXPECT_EQ(engine_allocations - ort_allocations, 0);
+}
+
+TEST(ONNXRTEngine, held_results_are_not_overwritten)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+    cps_inferencer::ONNXRTEngine<float> engine(model_path, 1);
+    ASSERT_TRUE(engine.isOk());
+
+    std::vector<cps_utils::InferenceData<float>> data = make_data(engine.modelConfig());
+    std::vector<cps_utils::InferenceResult<float>> first, second;
+    ASSERT_TRUE(engine.process(data, first).IsOk());
+    std::vector<float> expected(first[0].data.begin(), first[0].data.end());
+
+    ASSERT_TRUE(engine.process(data, second).IsOk());
+    EXPECT_NE(first[0].data.data(), second[0].data.data());
+    EXPECT_EQ(std::vector<float>(first[0].data.begin(), first[0].data.end()), expected);
+}
+
+TEST(ONNXRTEngine, allocated_outputs_are_trimmed_to_rows)
+{
+    std::string model_path = "/tmp/test_onnxrt_engine_compress.onnx";
+    write_compress_model(model_path);
+    cps_inferencer::ONNXRTEngine<float> engine(model_path, 4);
+    ASSERT_TRUE(engine.isOk());
+    ASSERT_LT(engine.modelConfig().outputs_[0].byte_size_, 0);
+
+    // 3 rows run in the bucket of 4, the padding row is not returned.
+    cps_utils::InferenceData<float> data;
+    data.shape = {3, 4};
+    std::vector<float> values(12);
+    std::iota(values.begin(), values.end(), 0.0f);
+    data.data = cps_utils::TensorBuffer<float>(values);
+    data.name = "x";
+    data.data_dtype = "FP32";
+
+    std::vector<cps_utils::InferenceResult<float>> results;
+    ASSERT_TRUE(engine.process(std::vector<cps_utils::InferenceData<float>>{data}, results).IsOk());
+    std::remove(model_path.c_str());
+    ASSERT_EQ(results.size(), 1);
+    EXPECT_EQ(results[0].shape, std::vector<int64_t>({3, 3}));
+    EXPECT_EQ(results[0].byte_size, 9 * sizeof(float));
+    EXPECT_EQ(std::vector<float>(results[0].data.begin(), results[0].data.end()),
+              std::vector<float>({0, 2, 3, 4, 6, 7, 8, 10, 11}));
+}
+
+TEST(ONNXRTEngine, unsupported_tensors_are_rejected)
+{
+    std::string model_path = "/tmp/test_onnxrt_engine_unsupported.onnx";
+
+    // Sum of the whole input is a scalar, the output has no batch dimension.
+    write_single_node_model(model_path, "ReduceSum", "keepdims", 0, tensor_info("y", {}));
+    EXPECT_FALSE(cps_inferencer::ONNXRTEngine<float>(model_path, 4).isOk());
+
+    // Index of the largest column of each row is batched, but INT64 doesn't match the engine type.
+    write_single_node_model(model_path, "ArgMax", "axis", 1, tensor_info("y", {{"N", 0}, {"", 1}}, 7));
+    EXPECT_FALSE(cps_inferencer::ONNXRTEngine<float>(model_path, 4).isOk());
+
+    // Float output with the batch as first dimension is supported.
+    write_single_node_model(model_path, "Softmax", "axis", 1, tensor_info("y", {{"N", 0}, {"", 4}}));
+    EXPECT_TRUE(cps_inferencer::ONNXRTEngine<float>(model_path, 4).isOk());
+    std::remove(model_path.c_str());
+}
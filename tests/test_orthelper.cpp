@@ -1,6 +1,10 @@
 #include <gtest/gtest.h>
+#include <cstdio>
+#include <cstdlib>
 #include <memory>
 #include <vector>
+#include <dirent.h>
+#include <unistd.h>
 #include "cpp_server/utils/error.hpp"
 #include "cpp_server/utils/common.hpp"
 #include "cpp_server/onnxrt_helper.hpp"
@@ -14,11 +18,100 @@ TEST(Runner, config_reading)
 
     cps_inferencer::ORTRunner runner(model_path);
 
-    std::vector<cps_utils::ModelConfig> configs = runner.getModelConfigs();
-    EXPECT_STREQ(configs[0].input_name_.c_str(), "input");
-    EXPECT_STREQ(configs[0].input_datatype_.c_str(), "FP32");
-    EXPECT_EQ(configs[0].input_byte_size_, 1769472);
-    EXPECT_STREQ(configs[0].output_name_.c_str(), "output");
-    EXPECT_STREQ(configs[0].output_datatype_.c_str(), "FP32");
-    EXPECT_EQ(configs[0].output_byte_size_, 4000);
-}
\ No newline at end of file
+    cps_utils::ModelConfig config = runner.getModelConfig();
+    EXPECT_STREQ(config.input_name_.c_str(), "input");
+    EXPECT_STREQ(config.input_datatype_.c_str(), "FP32");
+    EXPECT_EQ(config.input_byte_size_, 1769472);
+    EXPECT_STREQ(config.output_name_.c_str(), "output");
+    EXPECT_STREQ(config.output_datatype_.c_str(), "FP32");
+    EXPECT_EQ(config.output_byte_size_, 4000);
+
+    ASSERT_EQ(config.inputs_.size(), 1);
+    ASSERT_EQ(config.outputs_.size(), 1);
+    EXPECT_EQ(config.inputIndex("input"), 0);
+    EXPECT_EQ(config.outputIndex("output"), 0);
+    EXPECT_EQ(config.outputIndex("missing"), -1);
+}
+TEST(Runner, session_config)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+
+    cps_inferencer::ONNXRTConfig config;
+    config.intra_op_num_threads = 1;
+    config.inter_op_num_threads = 1;
+    config.graph_optimization_level = GraphOptimizationLevel::ORT_ENABLE_BASIC;
+    config.execution_mode = ExecutionMode::ORT_PARALLEL;
+    config.enable_mem_pattern = false;
+    config.enable_cpu_mem_arena = false;
+    cps_inferencer::ORTRunner runner(model_path, config);
+
+    ASSERT_TRUE(runner.isValid());
+    EXPECT_STREQ(runner.getModelConfig().input_name_.c_str(), "input");
+}
+
+TEST(Runner, global_thread_pool)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+
+    cps_inferencer::ONNXRTConfig config;
+    config.intra_op_num_threads = 2;
+    config.use_global_thread_pool = true;
+    cps_inferencer::ORTRunner runner_a(model_path, config);
+    cps_inferencer::ORTRunner runner_b(model_path, config);
+    EXPECT_TRUE(runner_a.isValid());
+    EXPECT_TRUE(runner_b.isValid());
+
+    // Environment is already created with global thread pools.
+    cps_inferencer::ORTRunner runner_c(model_path);
+    EXPECT_TRUE(runner_c.isValid());
+}
+
+TEST(Runner, optimized_model_cache)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+    char cache_dir[] = "/tmp/ort_cache_XXXXXX";
+    ASSERT_NE(mkdtemp(cache_dir), nullptr);
+
+    cps_inferencer::ONNXRTConfig config;
+    config.optimized_model_cache_dir = cache_dir;
+
+    std::vector<std::string> entries;
+    {
+        cps_inferencer::ORTRunner runner(model_path, config);
+        ASSERT_TRUE(runner.isValid());
+
+        DIR *dir = opendir(cache_dir);
+        ASSERT_NE(dir, nullptr);
+        for (dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.')
+            {
+                entries.push_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    ASSERT_EQ(entries.size(), 1);
+
+    // Second start loads the cached ORT format model with the same metadata.
+    cps_inferencer::ORTRunner runner(model_path, config);
+    ASSERT_TRUE(runner.isValid());
+    EXPECT_STREQ(runner.getModelConfig().input_name_.c_str(), "input");
+    EXPECT_EQ(runner.getModelConfig().output_byte_size_, 4000);
+
+    std::remove((std::string(cache_dir) + "/" + entries[0]).c_str());
+    rmdir(cache_dir);
+}
+
+TEST(Runner, mmap_model)
+{
+    std::string model_path = "/model-repository/imagenet_classification_static/1/model.onnx";
+
+    cps_inferencer::ONNXRTConfig config;
+    config.mmap_model = true;
+    cps_inferencer::ORTRunner runner(model_path, config);
+
+    ASSERT_TRUE(runner.isValid());
+    EXPECT_EQ(runner.getModelConfig().input_byte_size_, 1769472);
+    EXPECT_EQ(runner.getModelConfig().output_byte_size_, 4000);
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/fiber/all.hpp>
+#include <rapidjson/document.h>
+#include "cpp_server/utils/error.hpp"
+#include "cpp_server/parallel_processor.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_processor = cpp_server::processor;
+
+/// @brief Processor echoing the worker it runs on, records how many requests overlap.
+class EchoProcessor : public cps_processor::Processor
+{
+public:
+    EchoProcessor(const size_t &worker_id, std::atomic<int> &max_active)
+        : worker_id(worker_id), thread_id(std::this_thread::get_id()), max_active(max_active) {}
+
+    cps_utils::Error process(const rapidjson::Document &data_doc, rapidjson::Document &result_doc,
+                             const cps_utils::Deadline &deadline = cps_utils::no_deadline())
+    {
+        throw std::runtime_error("JSON input is not supported");
+    }
+
+    cps_utils::Error process(const char *data, const size_t &size, rapidjson::Document &result_doc,
+                             const cps_utils::Deadline &deadline = cps_utils::no_deadline())
+    {
+        if (std::this_thread::get_id() != thread_id)
+        {
+            return cps_utils::Error(cps_utils::Error::Code::INTERNAL, "Processor used from another thread");
+        }
+        int current = ++active;
+        max_active = std::max<int>(max_active, current);
+        boost::this_fiber::sleep_for(std::chrono::milliseconds(10));
+        --active;
+
+        std::string result = "{\"worker\": " + std::to_string(worker_id) + ", \"size\": " + std::to_string(size) + "}";
+        result_doc.Parse(result.c_str());
+        return cps_utils::Error::Success;
+    }
+
+private:
+    size_t worker_id;
+    std::thread::id thread_id;
+    int active{0};
+    std::atomic<int> &max_active;
+};
+
+TEST(ParallelProcessor, requests_are_spread_over_workers)
+{
+    std::atomic<int> max_active{0};
+    cps_processor::WorkerConfig config;
+    config.num_workers = 2;
+    config.pin_workers = false;
+    cps_processor::ParallelProcessor processor([&max_active](const size_t &worker_id)
+                                               { return std::unique_ptr<cps_processor::Processor>(new EchoProcessor(worker_id, max_active)); },
+                                               config);
+    ASSERT_TRUE(processor.isOk());
+    ASSERT_EQ(processor.size(), 2);
+
+    const int num_requests = 8;
+    const char data[num_requests] = {};
+    std::vector<cps_utils::Error> errors(num_requests);
+    std::vector<rapidjson::Document> results(num_requests);
+    std::vector<boost::fibers::fiber> fibers;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        fibers.emplace_back([&, i]()
+                            { errors[i] = processor.process(data, i, results[i]); });
+    }
+    for (boost::fibers::fiber &f : fibers)
+    {
+        f.join();
+    }
+
+    std::set<int> used_workers;
+    for (int i = 0; i < num_requests; ++i)
+    {
+        ASSERT_TRUE(errors[i].IsOk()) << errors[i].AsString();
+        EXPECT_EQ(results[i]["size"].GetInt(), i);
+        used_workers.insert(results[i]["worker"].GetInt());
+    }
+    EXPECT_EQ(used_workers.size(), 2);
+    // Requests of a worker overlap on its fibers instead of running one by one.
+    EXPECT_GT(max_active, 1);
+}
+
+TEST(ParallelProcessor, exceptions_become_errors)
+{
+    std::atomic<int> max_active{0};
+    cps_processor::WorkerConfig config;
+    config.num_workers = 1;
+    cps_processor::ParallelProcessor processor([&max_active](const size_t &worker_id)
+                                               { return std::unique_ptr<cps_processor::Processor>(new EchoProcessor(worker_id, max_active)); },
+                                               config);
+    ASSERT_TRUE(processor.isOk());
+
+    rapidjson::Document data_doc, result_doc;
+    data_doc.Parse("{}");
+    EXPECT_EQ(processor.process(data_doc, result_doc).ErrorCode(), cps_utils::Error::Code::INTERNAL);
+}
+
+TEST(ParallelProcessor, failed_worker)
+{
+    std::atomic<int> max_active{0};
+    cps_processor::WorkerConfig config;
+    config.num_workers = 2;
+    cps_processor::ParallelProcessor processor([&max_active](const size_t &worker_id)
+                                               {
+                                                   if (worker_id == 1)
+                                                   {
+                                                       throw std::runtime_error("Model not found");
+                                                   }
+                                                   return std::unique_ptr<cps_processor::Processor>(new EchoProcessor(worker_id, max_active)); },
+                                               config);
+    EXPECT_FALSE(processor.isOk());
+
+    rapidjson::Document result_doc;
+    EXPECT_EQ(processor.process("", 0, result_doc).ErrorCode(), cps_utils::Error::Code::INTERNAL);
+}
+
+TEST(ParallelProcessor, expired_requests_are_dropped)
+{
+    std::atomic<int> max_active{0};
+    cps_processor::WorkerConfig config;
+    config.num_workers = 1;
+    cps_processor::ParallelProcessor processor([&max_active](const size_t &worker_id)
+                                               { return std::unique_ptr<cps_processor::Processor>(new EchoProcessor(worker_id, max_active)); },
+                                               config);
+    ASSERT_TRUE(processor.isOk());
+
+    rapidjson::Document result_doc;
+    EXPECT_EQ(processor.process("", 0, result_doc, std::chrono::steady_clock::now()).ErrorCode(), cps_utils::Error::Code::DEADLINE_EXCEEDED);
+    EXPECT_EQ(max_active, 0);
+    EXPECT_TRUE(processor.process("", 0, result_doc, std::chrono::steady_clock::now() + std::chrono::seconds(1)).IsOk());
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <vector>
+#include <rapidjson/document.h>
+#include "cpp_server/utils/preprocess.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+static std::vector<uint8_t> random_image(const size_t &size)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+    std::vector<uint8_t> image(size);
+    for (uint8_t &px : image)
+    {
+        px = static_cast<uint8_t>(dist(rng));
+    }
+    return image;
+}
+
+TEST(PreprocessTest, parse_config)
+{
+    rapidjson::Document doc;
+    doc.Parse("{\"width\": 320, \"height\": 240, \"resize_mode\": \"letterbox\", \"interpolation\": \"linear\","
+              "\"pad_value\": 114, \"color_order\": \"BGR\", \"mean\": [0.5, 0.5, 0.5], \"std\": [0.25, 0.25, 0.25],"
+              "\"layout\": \"NHWC\", \"datatype\": \"FP32\"}");
+    ASSERT_FALSE(doc.HasParseError());
+
+    cps_utils::PreprocessConfig config;
+    cps_utils::Error err = cps_utils::parse_preprocess_config(doc, config);
+    ASSERT_TRUE(err.IsOk()) << err.AsString();
+    EXPECT_EQ(config.width, 320);
+    EXPECT_EQ(config.height, 240);
+    EXPECT_EQ(config.resize_mode, cps_utils::ResizeMode::LETTERBOX);
+    EXPECT_EQ(config.interpolation, cps_utils::Interpolation::LINEAR);
+    EXPECT_EQ(config.pad_value, 114);
+    EXPECT_EQ(config.color_order, cps_utils::ColorOrder::BGR);
+    EXPECT_FLOAT_EQ(config.normalize.mean[1], 0.5f);
+    EXPECT_FLOAT_EQ(config.normalize.std[2], 0.25f);
+    EXPECT_EQ(config.layout, cps_utils::TensorLayout::NHWC);
+    EXPECT_EQ(config.datatype, "FP32");
+
+    for (const char *invalid : {"{\"resize_mode\": \"fit\"}", "{\"std\": [1, 0, 1]}", "{\"mean\": [1, 2]}",
+                                "{\"datatype\": \"INT64\"}", "{\"datatype\": \"FP16\"}", "{\"pad_value\": 300}", "{\"scale\": 1}", "[]"})
+    {
+        doc.Parse(invalid);
+        cps_utils::PreprocessConfig other;
+        EXPECT_EQ(cps_utils::parse_preprocess_config(doc, other).ErrorCode(), cps_utils::Error::Code::VALIDATION_ERROR) << invalid;
+    }
+}
+
+TEST(PreprocessTest, resolve_from_model)
+{
+    cps_utils::ModelConfig model_config;
+    model_config.input_shape_ = {-1, 224, 160, 3};
+    model_config.input_format_ = "FORMAT_NHWC";
+    model_config.input_datatype_ = "FP32";
+
+    cps_utils::PreprocessConfig config;
+    ASSERT_TRUE(cps_utils::resolve_preprocess_config(model_config, config).IsOk());
+    EXPECT_EQ(config.layout, cps_utils::TensorLayout::NHWC);
+    EXPECT_EQ(config.datatype, "FP32");
+    EXPECT_EQ(config.height, 224);
+    EXPECT_EQ(config.width, 160);
+
+    // Explicit options win, variable-size dimensions fall back to 384.
+    model_config.input_shape_ = {1, 3, -1, -1};
+    model_config.input_format_ = "FORMAT_NONE";
+    cps_utils::PreprocessConfig fixed;
+    fixed.width = 512;
+    fixed.datatype = "FP32";
+    ASSERT_TRUE(cps_utils::resolve_preprocess_config(model_config, fixed).IsOk());
+    EXPECT_EQ(fixed.layout, cps_utils::TensorLayout::NCHW);
+    EXPECT_EQ(fixed.datatype, "FP32");
+    EXPECT_EQ(fixed.width, 512);
+    EXPECT_EQ(fixed.height, 384);
+
+    // Fixed model dimensions can't be overridden, configured sizes must match them.
+    model_config.input_shape_ = {1, 3, 224, 160};
+    model_config.input_datatype_ = "FP32";
+    cps_utils::PreprocessConfig matching;
+    matching.width = 160;
+    matching.height = 224;
+    EXPECT_TRUE(cps_utils::resolve_preprocess_config(model_config, matching).IsOk());
+    for (const std::pair<int, int> &size : {std::make_pair(512, 0), std::make_pair(0, 512), std::make_pair(224, 160)})
+    {
+        cps_utils::PreprocessConfig mismatched;
+        mismatched.width = size.first;
+        mismatched.height = size.second;
+        EXPECT_EQ(cps_utils::resolve_preprocess_config(model_config, mismatched).ErrorCode(), cps_utils::Error::Code::VALIDATION_ERROR)
+            << size.first << "x" << size.second;
+    }
+
+    // Images are only packed to float tensors.
+    for (const char *datatype : {"INT64", "FP16", "UINT8"})
+    {
+        model_config.input_datatype_ = datatype;
+        cps_utils::PreprocessConfig unsupported;
+        EXPECT_EQ(cps_utils::resolve_preprocess_config(model_config, unsupported).ErrorCode(), cps_utils::Error::Code::UNSUPPORTED) << datatype;
+    }
+}
+
+TEST(PreprocessTest, pack_layouts)
+{
+    // Padded rows exercise the stride, odd width exercises the kernel tails.
+    const int width = 37, height = 5;
+    const size_t step = 3 * width + 7;
+    const size_t plane = width * height;
+    std::vector<uint8_t> image = random_image(step * height);
+
+    for (const cps_utils::ColorOrder &order : {cps_utils::ColorOrder::RGB, cps_utils::ColorOrder::BGR})
+    {
+        for (const cps_utils::TensorLayout &layout : {cps_utils::TensorLayout::NCHW, cps_utils::TensorLayout::NHWC})
+        {
+            cps_utils::PreprocessConfig config;
+            config.color_order = order;
+            config.layout = layout;
+            config.datatype = "FP32";
+
+            std::vector<float> output(3 * plane);
+            cps_utils::pack_image(image.data(), step, width, height, config, output.data());
+
+            for (int y = 0; y < height; ++y)
+            {
+                for (int x = 0; x < width; ++x)
+                {
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        // Channel c of the output reads channel sc of the BGR source.
+                        int sc = order == cps_utils::ColorOrder::RGB ? 2 - c : c;
+                        uint8_t px = image[y * step + 3 * x + sc];
+                        size_t index = layout == cps_utils::TensorLayout::NCHW ? c * plane + y * width + x : 3 * (y * width + x) + c;
+                        float expected = (px / 255.f - config.normalize.mean[c]) / config.normalize.std[c];
+                        ASSERT_NEAR(output[index], expected, 1e-5);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,32 @@
+#include <gtest/gtest.h>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include "cpp_server/utils/shared_memory.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+TEST(SharedMemoryTest, region_is_shared_by_key)
+{
+    const std::string key = "/cps_test_shm_" + std::to_string(getpid());
+    const std::string content = "preprocessed tensor";
+    {
+        cps_utils::SharedMemoryRegion owner(key, 4096);
+        ASSERT_TRUE(owner.isValid());
+        EXPECT_EQ(owner.size(), 4096);
+        std::memcpy(owner.data(), content.data(), content.size());
+
+        // Another mapping, as opened by the inference server, sees the same bytes.
+        cps_utils::SharedMemoryRegion reader(key, 4096, false);
+        ASSERT_TRUE(reader.isValid());
+        EXPECT_EQ(std::memcmp(reader.data(), content.data(), content.size()), 0);
+
+        // Key is already taken.
+        cps_utils::SharedMemoryRegion duplicate(key, 4096);
+        EXPECT_FALSE(duplicate.isValid());
+    }
+
+    // Region is unlinked with its owner.
+    cps_utils::SharedMemoryRegion reopened(key, 4096, false);
+    EXPECT_FALSE(reopened.isValid());
+}
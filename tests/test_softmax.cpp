@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+#include "cpp_server/utils/simd.hpp"
+#include "cpp_server/utils/softmax.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+static std::vector<float> reference_softmax(const std::vector<float> &logits)
+{
+    double max_value = *std::max_element(logits.begin(), logits.end());
+    double sum = 0;
+    for (const float &logit : logits)
+    {
+        sum += std::exp(logit - max_value);
+    }
+    std::vector<float> output;
+    for (const float &logit : logits)
+    {
+        output.push_back(std::exp(logit - max_value) / sum);
+    }
+    return output;
+}
+
+TEST(SoftmaxTest, simd_matches_reference)
+{
+    // Sizes cover the kernel tails and an ImageNet row, logits span the range seen in practice.
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> dist(-30.f, 30.f);
+    for (const size_t &size : std::vector<size_t>{1, 7, 8, 17, 1000, 1001})
+    {
+        std::vector<float> logits(size);
+        for (float &logit : logits)
+        {
+            logit = dist(rng);
+        }
+        std::vector<float> expected = reference_softmax(logits);
+        float max_value = *std::max_element(logits.begin(), logits.end());
+
+        for (const cps_utils::SimdLevel &level : {cps_utils::SimdLevel::SCALAR, cps_utils::SimdLevel::SSSE3, cps_utils::SimdLevel::AVX2,
+                                                  cps_utils::SimdLevel::AVX512, cps_utils::SimdLevel::NEON})
+        {
+            if (!cps_utils::simdSupported(level))
+            {
+                continue;
+            }
+            std::vector<float> output = logits;
+            cps_utils::softmax(output.data(), output.size(), level);
+            double total = 0;
+            for (size_t i = 0; i < size; ++i)
+            {
+                // Rounding of logit - max in float adds a relative error growing with its magnitude.
+                double tolerance = expected[i] * (1e-6 + 2.4e-7 * std::fabs(logits[i] - max_value)) + 1e-30;
+                ASSERT_NEAR(output[i], expected[i], tolerance) << cps_utils::simdLevelName(level) << " at " << i;
+                total += output[i];
+            }
+            EXPECT_NEAR(total, 1.0, 1e-5);
+        }
+    }
+}
+
+TEST(SoftmaxTest, large_logits_are_stable)
+{
+    std::vector<float> logits{1000.f, 1000.f, -1000.f};
+    cps_utils::softmax(logits.data(), logits.size());
+    EXPECT_NEAR(logits[0], 0.5f, 1e-6);
+    EXPECT_NEAR(logits[1], 0.5f, 1e-6);
+    EXPECT_NEAR(logits[2], 0.f, 1e-30);
+}
+
+TEST(SoftmaxTest, top_k)
+{
+    std::vector<float> values{0.1f, 0.4f, 0.05f, 0.4f, 0.3f, 0.15f};
+    std::vector<std::pair<int, float>> output;
+    cps_utils::top_k(values.data(), values.size(), 3, output);
+    ASSERT_EQ(output.size(), 3);
+    // Ties keep the lower index first.
+    EXPECT_EQ(output[0], std::make_pair(1, 0.4f));
+    EXPECT_EQ(output[1], std::make_pair(3, 0.4f));
+    EXPECT_EQ(output[2], std::make_pair(4, 0.3f));
+
+    cps_utils::top_k(values.data(), values.size(), 10, output);
+    ASSERT_EQ(output.size(), values.size());
+    EXPECT_EQ(output.back(), std::make_pair(2, 0.05f));
+
+    cps_utils::top_k(values.data(), values.size(), 0, output);
+    EXPECT_TRUE(output.empty());
+}
+
+TEST(SoftmaxTest, top_k_matches_sort)
+{
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    std::vector<float> values(1000);
+    for (float &value : values)
+    {
+        value = dist(rng);
+    }
+    std::vector<int> indices(values.size());
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        indices[i] = i;
+    }
+    std::stable_sort(indices.begin(), indices.end(), [&values](const int &a, const int &b)
+                     { return values[a] > values[b]; });
+
+    std::vector<std::pair<int, float>> output;
+    cps_utils::top_k(values.data(), values.size(), 5, output);
+    ASSERT_EQ(output.size(), 5);
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+        EXPECT_EQ(output[i].first, indices[i]);
+    }
+}
@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <memory>
+#include <set>
+#include <thread>
+#include <mutex>
+#include "cpp_server/utils/thread_pool.hpp"
+
+namespace cps_utils = cpp_server::utils;
+
+TEST(ThreadPool, runs_all_tasks_before_destruction)
+{
+    std::atomic<int> counter{0};
+    {
+        cps_utils::ThreadPool pool(4);
+        EXPECT_EQ(pool.size(), 4);
+        for (int i = 0; i < 100; ++i)
+        {
+            pool.submit([&counter]()
+                        { counter++; });
+        }
+    }
+    EXPECT_EQ(counter, 100);
+}
+
+TEST(ThreadPool, tasks_run_on_worker_threads)
+{
+    std::mutex ids_mutex;
+    std::set<std::thread::id> ids;
+    {
+        cps_utils::ThreadPool pool(0);
+        EXPECT_EQ(pool.size(), 1);
+        for (int i = 0; i < 10; ++i)
+        {
+            pool.submit([&]()
+                        {
+                            std::lock_guard<std::mutex> lock(ids_mutex);
+                            ids.insert(std::this_thread::get_id()); });
+        }
+    }
+    EXPECT_EQ(ids.size(), 1);
+    EXPECT_EQ(ids.count(std::this_thread::get_id()), 0);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <set>
+#include <vector>
+#include "cpp_server/triton_client_pool.hpp"
+
+namespace cps_inferencer = cpp_server::inferencer;
+
+/// @brief Pool over unreachable endpoints, HTTP clients connect lazily so no server is needed.
+static cps_inferencer::ClientConfig make_config(const size_t &num_endpoints)
+{
+    cps_inferencer::ClientConfig client_config;
+    client_config.verbose = false;
+    for (size_t i = 0; i < num_endpoints; ++i)
+    {
+        client_config.urls.push_back("localhost:" + std::to_string(1 + i));
+    }
+    client_config.connections_per_endpoint = 2;
+    client_config.max_consecutive_failures = 2;
+    client_config.health_check_interval_ms = 0;
+    return client_config;
+}
+
+TEST(TritonClientPool, least_outstanding_spreads_requests)
+{
+    cps_inferencer::TritonClientPool pool(make_config(3));
+    ASSERT_TRUE(pool.isValid());
+    ASSERT_EQ(pool.size(), 3);
+
+    std::vector<cps_inferencer::TritonConnection *> connections;
+    for (int i = 0; i < 6; ++i)
+    {
+        connections.push_back(pool.acquire());
+        ASSERT_NE(connections.back(), nullptr);
+    }
+    // Every endpoint gets two requests, each on its own connection.
+    std::set<cps_inferencer::TritonConnection *> unique(connections.begin(), connections.end());
+    EXPECT_EQ(unique.size(), 6);
+    for (size_t e = 0; e < pool.size(); ++e)
+    {
+        EXPECT_EQ(pool.outstanding(e), 2);
+    }
+
+    for (cps_inferencer::TritonConnection *connection : connections)
+    {
+        pool.release(connection, true);
+    }
+    for (size_t e = 0; e < pool.size(); ++e)
+    {
+        EXPECT_EQ(pool.outstanding(e), 0);
+    }
+}
+
+TEST(TritonClientPool, power_of_two_choices_avoids_loaded_endpoint)
+{
+    cps_inferencer::ClientConfig client_config = make_config(2);
+    client_config.load_balancing = cps_inferencer::LoadBalancingPolicy::POWER_OF_TWO_CHOICES;
+    cps_inferencer::TritonClientPool pool(client_config);
+    ASSERT_TRUE(pool.isValid());
+
+    // With two endpoints both are always compared, so load alternates between them.
+    for (int i = 0; i < 10; ++i)
+    {
+        ASSERT_NE(pool.acquire(), nullptr);
+        EXPECT_LE(std::abs(pool.outstanding(0) - pool.outstanding(1)), 1);
+    }
+}
+
+TEST(TritonClientPool, failing_endpoint_is_ejected)
+{
+    cps_inferencer::TritonClientPool pool(make_config(2));
+    ASSERT_TRUE(pool.isValid());
+
+    // Idle endpoints are taken in turn, each one fails twice in a row.
+    for (size_t i = 0; i < 4; ++i)
+    {
+        cps_inferencer::TritonConnection *connection = pool.acquire();
+        ASSERT_NE(connection, nullptr);
+        EXPECT_EQ(connection->endpoint, i % 2);
+        pool.release(connection, false);
+    }
+    EXPECT_FALSE(pool.isHealthy(0));
+    EXPECT_FALSE(pool.isHealthy(1));
+    EXPECT_EQ(pool.acquire(), nullptr);
+}
+
+TEST(TritonClientPool, success_resets_failures)
+{
+    cps_inferencer::TritonClientPool pool(make_config(1));
+    ASSERT_TRUE(pool.isValid());
+
+    std::vector<bool> outcomes{false, true, false};
+    for (const bool &success : outcomes)
+    {
+        pool.release(pool.acquire(), success);
+    }
+    EXPECT_TRUE(pool.isHealthy(0));
+
+    pool.release(pool.acquire(), false);
+    EXPECT_FALSE(pool.isHealthy(0));
+}
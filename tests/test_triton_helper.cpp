@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include <rapidjson/document.h>
+#include "cpp_server/utils/common.hpp"
+#include "cpp_server/triton_helper.hpp"
+
+namespace cps_utils = cpp_server::utils;
+namespace cps_inferencer = cpp_server::inferencer;
+
+static const char *http_metadata =
+    "{\"name\": \"resnet\","
+    "\"inputs\": [{\"name\": \"input\", \"datatype\": \"FP32\", \"shape\": [-1, 3, 224, 224]}],"
+    "\"outputs\": [{\"name\": \"output\", \"datatype\": \"FP32\", \"shape\": [-1, 1000]}]}";
+
+/// @brief gRPC metadata and configuration of a model with one input and one output.
+static void grpc_model(const int &max_batch_size, inference::ModelMetadataResponse &metadata, inference::ModelConfigResponse &config)
+{
+    metadata.set_name("resnet");
+    inference::ModelMetadataResponse::TensorMetadata *input = metadata.add_inputs();
+    input->set_name("input");
+    input->set_datatype("FP32");
+    inference::ModelMetadataResponse::TensorMetadata *output = metadata.add_outputs();
+    output->set_name("output");
+    output->set_datatype("FP32");
+    // Metadata of a batching model holds the batch dimension as -1.
+    if (max_batch_size > 0)
+    {
+        input->add_shape(-1);
+        output->add_shape(-1);
+    }
+    for (const int64_t &dim : {3, 224, 224})
+    {
+        input->add_shape(dim);
+    }
+    output->add_shape(1000);
+
+    config.mutable_config()->set_max_batch_size(max_batch_size);
+    inference::ModelInput *input_config = config.mutable_config()->add_input();
+    input_config->set_name("input");
+    input_config->set_format(inference::ModelInput::FORMAT_NCHW);
+}
+
+TEST(TritonHelper, http_batched_model)
+{
+    rapidjson::Document metadata, config;
+    metadata.Parse(http_metadata);
+    config.Parse("{\"max_batch_size\": 8, \"input\": [{\"name\": \"input\", \"format\": \"FORMAT_NCHW\"}]}");
+    ASSERT_FALSE(metadata.HasParseError() || config.HasParseError());
+
+    cps_utils::ModelConfig model_info;
+    ASSERT_TRUE(cps_inferencer::ParseModelHttp(metadata, config, 4, &model_info));
+    EXPECT_EQ(model_info.max_batch_size_, 8);
+    EXPECT_EQ(model_info.input_shape_, std::vector<int64_t>({4, 3, 224, 224}));
+    EXPECT_EQ(model_info.input_byte_size_, 4 * 3 * 224 * 224 * 4);
+    EXPECT_EQ(model_info.output_shape_, std::vector<int64_t>({4, 1000}));
+    EXPECT_EQ(model_info.output_byte_size_, 4 * 1000 * 4);
+    EXPECT_TRUE(model_info.channel_first_);
+
+    EXPECT_FALSE(cps_inferencer::ParseModelHttp(metadata, config, 16, &model_info));
+}
+
+TEST(TritonHelper, http_model_without_batching)
+{
+    rapidjson::Document metadata, config;
+    metadata.Parse("{\"name\": \"resnet\","
+                   "\"inputs\": [{\"name\": \"input\", \"datatype\": \"FP32\", \"shape\": [3, 224, 224]}],"
+                   "\"outputs\": [{\"name\": \"output\", \"datatype\": \"FP32\", \"shape\": [1000]}]}");
+    config.Parse("{\"max_batch_size\": 0}");
+    ASSERT_FALSE(metadata.HasParseError() || config.HasParseError());
+
+    cps_utils::ModelConfig model_info;
+    ASSERT_TRUE(cps_inferencer::ParseModelHttp(metadata, config, 1, &model_info));
+    EXPECT_EQ(model_info.input_shape_, std::vector<int64_t>({3, 224, 224}));
+    EXPECT_EQ(model_info.output_shape_, std::vector<int64_t>({1000}));
+    EXPECT_FALSE(cps_inferencer::ParseModelHttp(metadata, config, 2, &model_info));
+}
+
+TEST(TritonHelper, grpc_batched_model)
+{
+    inference::ModelMetadataResponse metadata;
+    inference::ModelConfigResponse config;
+    grpc_model(8, metadata, config);
+
+    cps_utils::ModelConfig model_info;
+    ASSERT_TRUE(cps_inferencer::ParseModelGrpc(metadata, config, 4, &model_info));
+    EXPECT_EQ(model_info.max_batch_size_, 8);
+    EXPECT_EQ(model_info.input_shape_, std::vector<int64_t>({4, 3, 224, 224}));
+    EXPECT_EQ(model_info.input_byte_size_, 4 * 3 * 224 * 224 * 4);
+    EXPECT_EQ(model_info.output_shape_, std::vector<int64_t>({4, 1000}));
+    EXPECT_TRUE(model_info.channel_first_);
+
+    EXPECT_FALSE(cps_inferencer::ParseModelGrpc(metadata, config, 16, &model_info));
+}
+
+TEST(TritonHelper, grpc_model_without_batching)
+{
+    inference::ModelMetadataResponse metadata;
+    inference::ModelConfigResponse config;
+    grpc_model(0, metadata, config);
+
+    cps_utils::ModelConfig model_info;
+    ASSERT_TRUE(cps_inferencer::ParseModelGrpc(metadata, config, 1, &model_info));
+    EXPECT_EQ(model_info.input_shape_, std::vector<int64_t>({3, 224, 224}));
+    EXPECT_EQ(model_info.output_shape_, std::vector<int64_t>({1000}));
+}